@@ -548,15 +548,13 @@ void saveBehaviors()
 
    behavior = new Behavior();
    assert(behavior != NULL);
-   behavior->sensorSequence.resize(BehaviorSequenceLength);
-   behavior->motorSequence.resize(BehaviorSequenceLength);
+   behavior->sensorSequence.resize(BehaviorSequenceLength, NUM_SENSORS);
+   behavior->motorSequence.resize(BehaviorSequenceLength, NUM_MOTORS);
    for (i = 0; i < BehaviorSequenceLength; i++)
    {
       sensorMagnitudes = SensorSequence[i];
-      behavior->sensorSequence[i].resize(NUM_SENSORS, 0.0f);
       behavior->sensorSequence[i][SensorIndices[0].index] = sensorMagnitudes[0];
       behavior->sensorSequence[i][SensorIndices[1].index] = sensorMagnitudes[1];
-      behavior->motorSequence[i].resize(NUM_MOTORS, 0.0f);
       dorsalMagnitudes  = DorsalMotorSequence[i];
       ventralMagnitudes = VentralMotorSequence[i];
       for (j = 0; j < BodyJoints; j++)
@@ -263,30 +263,33 @@ void EvolveWriggle::prune()
       population[i] = offspring[j];
    }
    offspring.clear();
-   sort();
+
+   // Rank offspring into the sorted survivors.
+   merge(n - numOffspring);
 }
 
 
 // Sort members by error.
 void EvolveWriggle::sort()
 {
-   int     i, j, n;
-   Wriggle *wriggle1, *wriggle2;
+   merge(0);
+}
 
-   for (i = 0, n = (int)population.size(); i < n; i++)
-   {
-      wriggle1 = population[i];
-      for (j = i + 1; j < n; j++)
-      {
-         wriggle2 = population[j];
-         if (wriggle2->error < wriggle1->error)
-         {
-            population[i] = wriggle2;
-            population[j] = wriggle1;
-            wriggle1      = wriggle2;
-         }
-      }
-   }
+
+// Merge members from first index on into sorted members before it.
+// Only the unsorted members are sorted, and equally fit members keep their order.
+void EvolveWriggle::merge(int first)
+{
+   assert(first >= 0 && first <= (int)population.size());
+   stable_sort(population.begin() + first, population.end(), ranksBefore);
+   inplace_merge(population.begin(), population.begin() + first, population.end(), ranksBefore);
+}
+
+
+// Member ranks before other by lower error.
+bool EvolveWriggle::ranksBefore(Wriggle *member, Wriggle *other)
+{
+   return(member->error < other->error);
 }
 
 
@@ -4,6 +4,7 @@
 #define __EVOLVE_WRIGGLE_HPP__
 
 #include "wriggle.hpp"
+#include <algorithm>
 
 class EvolveWriggle
 {
@@ -83,6 +84,10 @@ private:
    // Sort by fitness.
    void sort();
 
+   // Merge members from first index on into the sorted members before it.
+   void merge(int first);
+   static bool ranksBefore(Wriggle *member, Wriggle *other);
+
    // Logging.
    FILE *logfp;
    bool startLog(char *logFile);
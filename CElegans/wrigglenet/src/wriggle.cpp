@@ -262,14 +262,12 @@ void Wriggle::createBehaviors(vector<Behavior *>& behaviors)
    // Touch-stimulated behavior.
    behavior = new Behavior();
    assert(behavior != NULL);
-   behavior->sensorSequence.resize(movements);
-   behavior->motorSequence.resize(movements);
+   behavior->sensorSequence.resize(movements, NUM_SENSORS);
+   behavior->motorSequence.resize(movements, NUM_MOTORS);
    for (i = 0; i < movements; i++)
    {
-      behavior->sensorSequence[i].resize(NUM_SENSORS, 0.0f);
       behavior->sensorSequence[i][SensorIndices[0].index] = 1.0f;
       behavior->sensorSequence[i][SensorIndices[1].index] = 1.0f;
-      behavior->motorSequence[i].resize(NUM_MOTORS, 0.0f);
       dorsalMagnitudes  = dorsalMotorSequence[i];
       ventralMagnitudes = ventralMotorSequence[i];
       for (j = 0; j < BODY_JOINTS; j++)
@@ -295,13 +293,8 @@ void Wriggle::createBehaviors(vector<Behavior *>& behaviors)
    // No touch behavior.
    behavior = new Behavior();
    assert(behavior != NULL);
-   behavior->sensorSequence.resize(movements);
-   behavior->motorSequence.resize(movements);
-   for (i = 0; i < movements; i++)
-   {
-      behavior->sensorSequence[i].resize(NUM_SENSORS, 0.0f);
-      behavior->motorSequence[i].resize(NUM_MOTORS, 0.0f);
-   }
+   behavior->sensorSequence.resize(movements, NUM_SENSORS);
+   behavior->motorSequence.resize(movements, NUM_MOTORS);
    behaviors.push_back(behavior);
 }
 
@@ -361,152 +354,31 @@ void Wriggle::mutate()
 // Optimize.
 void Wriggle::optimize()
 {
-   int   n;
-   float value, e;
-
-   vector<vector<float> > valueRanges;
-   vector<float>          valueRange;
-   vector<vector<float> > permutations;
-   vector<float>          permutation;
-
-   // Hill-climb parameter value permutations.
-   valueRange.clear();
-   value = periodParm.value;
-   valueRange.push_back(value);
-   if (periodParm.maxDelta > 0.0f)
-   {
-      value = periodParm.value -
-              (float)randomizer->RAND_INTERVAL(0.0f, periodParm.maxDelta);
-      if (value < periodParm.minimum)
-      {
-         value = periodParm.minimum;
-      }
-   }
-   valueRange.push_back(value);
-   if (periodParm.maxDelta > 0.0f)
-   {
-      value = periodParm.value +
-              (float)randomizer->RAND_INTERVAL(0.0f, periodParm.maxDelta);
-      if (value > periodParm.maximum)
-      {
-         value = periodParm.maximum;
-      }
-   }
-   valueRange.push_back(value);
-   valueRanges.push_back(valueRange);
-
-   valueRange.clear();
-   value = amplitudeParm.value;
-   valueRange.push_back(value);
-   if (amplitudeParm.maxDelta > 0.0f)
-   {
-      value = amplitudeParm.value -
-              (float)randomizer->RAND_INTERVAL(0.0f, amplitudeParm.maxDelta);
-      if (value < amplitudeParm.minimum)
-      {
-         value = amplitudeParm.minimum;
-      }
-   }
-   valueRange.push_back(value);
-   if (amplitudeParm.maxDelta > 0.0f)
-   {
-      value = amplitudeParm.value +
-              (float)randomizer->RAND_INTERVAL(0.0f, amplitudeParm.maxDelta);
-      if (value > amplitudeParm.maximum)
-      {
-         value = amplitudeParm.maximum;
-      }
-   }
-   valueRange.push_back(value);
-   valueRanges.push_back(valueRange);
-
-   valueRange.clear();
-   value = phaseParm.value;
-   valueRange.push_back(value);
-   if (phaseParm.maxDelta > 0.0f)
-   {
-      value = phaseParm.value -
-              (float)randomizer->RAND_INTERVAL(0.0f, phaseParm.maxDelta);
-      if (value < phaseParm.minimum)
-      {
-         value = phaseParm.minimum;
-      }
-   }
-   valueRange.push_back(value);
-   if (phaseParm.maxDelta > 0.0f)
-   {
-      value = phaseParm.value +
-              (float)randomizer->RAND_INTERVAL(0.0f, phaseParm.maxDelta);
-      if (value > phaseParm.maximum)
-      {
-         value = phaseParm.maximum;
-      }
-   }
-   valueRange.push_back(value);
-   valueRanges.push_back(valueRange);
-
-   valueRange.clear();
-   value = speedParm.value;
-   valueRange.push_back(value);
-   if (speedParm.maxDelta > 0.0f)
-   {
-      value = speedParm.value -
-              (float)randomizer->RAND_INTERVAL(0.0f, speedParm.maxDelta);
-      if (value < speedParm.minimum)
-      {
-         value = speedParm.minimum;
-      }
-   }
-   valueRange.push_back(value);
-   if (speedParm.maxDelta > 0.0f)
-   {
-      value = speedParm.value +
-              (float)randomizer->RAND_INTERVAL(0.0f, speedParm.maxDelta);
-      if (value > speedParm.maximum)
-      {
-         value = speedParm.maximum;
-      }
-   }
-   valueRange.push_back(value);
-   valueRanges.push_back(valueRange);
-
-   permutation.resize(4);
-   permuteValues(valueRanges, permutations, permutation, 0, 3);
-   n = randomizer->RAND_CHOICE((int)permutations.size() - 1) + 1;
+   float e;
+
+   vector<MutableParm>    parms;
+   vector<vector<float> > candidates;
+
+   // Hill-climb a parameter value permutation.
+   parms.push_back(periodParm);
+   parms.push_back(amplitudeParm);
+   parms.push_back(phaseParm);
+   parms.push_back(speedParm);
+   GridOptimizer optimizer(parms, error, randomizer, 1);
+   optimizer.propose(candidates);
    e = error;
-   periodParm.value    = permutations[n][0];
-   amplitudeParm.value = permutations[n][1];
-   phaseParm.value     = permutations[n][2];
-   speedParm.value     = permutations[n][3];
+   periodParm.value    = candidates[0][0];
+   amplitudeParm.value = candidates[0][1];
+   phaseParm.value     = candidates[0][2];
+   speedParm.value     = candidates[0][3];
    evaluate();
    if (error > e)
    {
       error               = e;
-      periodParm.value    = permutations[0][0];
-      amplitudeParm.value = permutations[0][1];
-      phaseParm.value     = permutations[0][2];
-      speedParm.value     = permutations[0][3];
-   }
-}
-
-
-// Permute values.
-void Wriggle::permuteValues(vector<vector<float> >& valueRanges,
-                            vector<vector<float> >& permutations,
-                            vector<float>& permutation,
-                            int level, int depth)
-{
-   for (int i = 0; i < 3; i++)
-   {
-      permutation[level] = valueRanges[level][i];
-      if (level < depth)
-      {
-         permuteValues(valueRanges, permutations, permutation, level + 1, depth);
-      }
-      else
-      {
-         permutations.push_back(permutation);
-      }
+      periodParm.value    = parms[0].value;
+      amplitudeParm.value = parms[1].value;
+      phaseParm.value     = parms[2].value;
+      speedParm.value     = parms[3].value;
    }
 }
 
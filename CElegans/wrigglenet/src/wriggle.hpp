@@ -114,10 +114,5 @@ private:
 
    // Create network trained to behaviors.
    void createNetwork(vector<Behavior *>& behaviors);
-
-   void permuteValues(vector<vector<float> >& valueRanges,
-                      vector<vector<float> >& permutations,
-                      vector<float>& permutation,
-                      int level, int depth);
 };
 #endif
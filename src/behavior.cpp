@@ -2,18 +2,103 @@
 
 #include "behavior.hpp"
 
+// Behavior sequence constructors.
+BehaviorSequence::BehaviorSequence()
+{
+   values  = NULL;
+   steps   = columns = 0;
+   owned   = true;
+}
+
+
+BehaviorSequence::BehaviorSequence(const BehaviorSequence& sequence)
+{
+   values  = NULL;
+   steps   = columns = 0;
+   owned   = true;
+   *this   = sequence;
+}
+
+
+// Behavior sequence destructor.
+BehaviorSequence::~BehaviorSequence()
+{
+   clear();
+}
+
+
+// Assignment copies values.
+BehaviorSequence& BehaviorSequence::operator=(const BehaviorSequence& sequence)
+{
+   if (this != &sequence)
+   {
+      resize(sequence.steps, sequence.columns);
+      if ((steps * columns) > 0)
+      {
+         memcpy(values, sequence.values, steps * columns * sizeof(float));
+      }
+   }
+   return(*this);
+}
+
+
+// Resize, discarding previous values.
+void BehaviorSequence::resize(int steps, int columns, float value)
+{
+   int i, n;
+
+   clear();
+   this->steps   = steps;
+   this->columns = columns;
+   n             = steps * columns;
+   if (n > 0)
+   {
+      values = new float[n];
+      assert(values != NULL);
+      for (i = 0; i < n; i++)
+      {
+         values[i] = value;
+      }
+   }
+}
+
+
+// Use values in place without copying.
+void BehaviorSequence::map(float *values, int steps, int columns)
+{
+   clear();
+   this->values  = values;
+   this->steps   = steps;
+   this->columns = columns;
+   owned         = false;
+}
+
+
+// Clear.
+void BehaviorSequence::clear()
+{
+   if (owned && (values != NULL))
+   {
+      delete [] values;
+   }
+   values = NULL;
+   steps  = columns = 0;
+   owned  = true;
+}
+
+
 // Behavior constructors.
 Behavior::Behavior(Network *network, int length, Random *randomizer)
 {
-   int i, j;
-
-   vector<float> sensors;
-   vector<float> motors;
+   int   i, j;
+   float *sensors, *motors;
 
-   sensors.resize(network->numSensors);
-   motors.resize(network->numMotors);
+   mappedFile = NULL;
+   sensorSequence.resize(length, network->numSensors);
+   motorSequence.resize(length, network->numMotors);
    for (i = 0; i < length; i++)
    {
+      sensors = sensorSequence[i];
       for (j = 0; j < network->numSensors; j++)
       {
          sensors[j] = (float)randomizer->RAND_PROB();
@@ -29,49 +114,60 @@ Behavior::Behavior(Network *network, int length, Random *randomizer)
 #endif
          network->neurons[j]->bias = sensors[j];
       }
-      sensorSequence.push_back(sensors);
       network->step();
+      motors = motorSequence[i];
       for (j = 0; j < network->numMotors; j++)
       {
          motors[j] = network->neurons[network->numSensors + j]->activation;
       }
-      motorSequence.push_back(motors);
    }
 }
 
 
 // Construct from given sensor sequence.
-Behavior::Behavior(Network *network, vector<vector<float> >& sensorSequence)
+// Stepping stops after maxStep if not -1.
+Behavior::Behavior(Network *network, BehaviorSequence& sensorSequence, int maxStep)
 {
-   int i, j;
-
-   vector<float> sensors;
-   vector<float> motors;
+   int   i, j, n;
+   float *sensors, *motors;
 
-   sensors.resize(network->numSensors);
-   motors.resize(network->numMotors);
+   mappedFile = NULL;
    network->clear();
-   for (i = 0; i < (int)sensorSequence.size(); i++)
+   n = sensorSequence.size();
+   if ((maxStep != -1) && ((maxStep + 1) < n))
    {
-      assert(network->numSensors == (int)sensorSequence[i].size());
+      n = maxStep + 1;
+   }
+   assert((n == 0) || (network->numSensors == sensorSequence.width()));
+   this->sensorSequence.resize(n, network->numSensors);
+   this->motorSequence.resize(n, network->numMotors);
+   for (i = 0; i < n; i++)
+   {
+      sensors = this->sensorSequence[i];
+      memcpy(sensors, sensorSequence[i], network->numSensors * sizeof(float));
       for (j = 0; j < network->numSensors; j++)
       {
-         sensors[j] = sensorSequence[i][j];
          network->neurons[j]->bias = sensors[j];
       }
-      this->sensorSequence.push_back(sensors);
       network->step();
+      motors = this->motorSequence[i];
       for (j = 0; j < network->numMotors; j++)
       {
          motors[j] = network->neurons[network->numSensors + j]->activation;
       }
-      this->motorSequence.push_back(motors);
    }
 }
 
 
+Behavior::Behavior()
+{
+   mappedFile = NULL;
+}
+
+
 Behavior::Behavior(FilePointer *fp)
 {
+   mappedFile = NULL;
    load(fp);
 }
 
@@ -81,6 +177,10 @@ Behavior::~Behavior()
 {
    sensorSequence.clear();
    motorSequence.clear();
+   if (mappedFile != NULL)
+   {
+      unmapFile(mappedFile);
+   }
 }
 
 
@@ -88,26 +188,26 @@ Behavior::~Behavior()
 void Behavior::load(FilePointer *fp)
 {
    int   i, j, n, numSensors, numMotors;
-   float f;
+   float f, *sensors, *motors;
 
    FREAD_INT(&n, fp);
-   sensorSequence.resize(n);
-   motorSequence.resize(n);
    FREAD_INT(&numSensors, fp);
    FREAD_INT(&numMotors, fp);
+   sensorSequence.resize(n, numSensors);
+   motorSequence.resize(n, numMotors);
    for (i = 0; i < n; i++)
    {
-      sensorSequence[i].resize(numSensors);
+      sensors = sensorSequence[i];
       for (j = 0; j < numSensors; j++)
       {
          FREAD_FLOAT(&f, fp);
-         sensorSequence[i][j] = f;
+         sensors[j] = f;
       }
-      motorSequence[i].resize(numMotors);
+      motors = motorSequence[i];
       for (j = 0; j < numMotors; j++)
       {
          FREAD_FLOAT(&f, fp);
-         motorSequence[i][j] = f;
+         motors[j] = f;
       }
    }
 }
@@ -119,15 +219,15 @@ void Behavior::save(FilePointer *fp)
    int   i, j, n, numSensors, numMotors;
    float f;
 
-   n = (int)sensorSequence.size();
+   n = sensorSequence.size();
    FWRITE_INT(&n, fp);
    if (n == 0)
    {
       return;
    }
-   numSensors = (int)sensorSequence[0].size();
+   numSensors = sensorSequence.width();
    FWRITE_INT(&numSensors, fp);
-   numMotors = (int)motorSequence[0].size();
+   numMotors = motorSequence.width();
    FWRITE_INT(&numMotors, fp);
    for (i = 0; i < n; i++)
    {
@@ -152,20 +252,20 @@ void Behavior::print()
 
    printf("Sensory-motor sequence:\n");
    printf("sensors:\n");
-   for (i = 0; i < (int)sensorSequence.size(); i++)
+   for (i = 0; i < sensorSequence.size(); i++)
    {
       printf("           ");
-      for (j = 0; j < (int)sensorSequence[i].size(); j++)
+      for (j = 0; j < sensorSequence.width(); j++)
       {
          printf("%0.2f ", sensorSequence[i][j]);
       }
       printf("\n");
    }
    printf("motors:\n");
-   for (i = 0; i < (int)motorSequence.size(); i++)
+   for (i = 0; i < motorSequence.size(); i++)
    {
       printf("           ");
-      for (j = 0; j < (int)motorSequence[i].size(); j++)
+      for (j = 0; j < motorSequence.width(); j++)
       {
          printf("%0.2f ", motorSequence[i][j]);
       }
@@ -182,11 +282,11 @@ void Behavior::printMotorDeltas(Behavior *behavior, float tolerance)
 
    printf("Motor deltas (tolerance=%0.2f):\n", tolerance);
    assert(motorSequence.size() == behavior->motorSequence.size());
-   for (i = 0; i < (int)motorSequence.size(); i++)
+   assert(motorSequence.width() == behavior->motorSequence.width());
+   for (i = 0; i < motorSequence.size(); i++)
    {
-      assert(motorSequence[i].size() == behavior->motorSequence[i].size());
       printf("           ");
-      for (j = 0; j < (int)motorSequence[i].size(); j++)
+      for (j = 0; j < motorSequence.width(); j++)
       {
          delta = fabs(motorSequence[i][j] - behavior->motorSequence[i][j]);
          if (delta >= tolerance)
@@ -204,9 +304,11 @@ void Behavior::printMotorDeltas(Behavior *behavior, float tolerance)
 
 
 // Load behaviors from file.
+// Mapped behaviors files are detected and used in place.
 bool Behavior::loadBehaviors(vector<Behavior *>& behaviors, char *filename, bool binary)
 {
-   int i, n;
+   int  i, n;
+   char magic[sizeof(MAPPED_MAGIC)];
 
    FilePointer *fp = FOPEN_READ(filename, binary);
 
@@ -214,8 +316,16 @@ bool Behavior::loadBehaviors(vector<Behavior *>& behaviors, char *filename, bool
    {
       return(false);
    }
+   if ((fread(magic, sizeof(magic), 1, fp->fp) == 1) &&
+       (memcmp(magic, MAPPED_MAGIC, sizeof(magic)) == 0))
+   {
+      FCLOSE(fp);
+      return(mapBehaviors(behaviors, filename));
+   }
+   rewind(fp->fp);
    if (FREAD_INT(&n, fp) != 1)
    {
+      FCLOSE(fp);
       return(false);
    }
    behaviors.clear();
@@ -250,3 +360,404 @@ bool Behavior::saveBehaviors(vector<Behavior *>& behaviors, char *filename, bool
    FCLOSE(fp);
    return(true);
 }
+
+
+// Mapped behaviors file magic.
+const char Behavior::MAPPED_MAGIC[8] = { 'B', 'I', 'O', 'N', 'E', 'T', 'B', 'H' };
+
+// Mapped behaviors file directory entry.
+struct MappedBehaviorEntry
+{
+   int       steps;
+   int       numSensors;
+   int       numMotors;
+   int       pad;
+   long long sensorOffset;
+   long long motorOffset;
+};
+
+// Save behaviors to mapped behaviors file.
+bool Behavior::saveMappedBehaviors(vector<Behavior *>& behaviors, char *filename)
+{
+   int       i, n, version;
+   long long offset, size;
+   Behavior  *behavior;
+
+   vector<struct MappedBehaviorEntry> directory;
+   struct MappedBehaviorEntry         entry;
+   unsigned char                      pad[MAPPED_ALIGNMENT];
+
+   // Lay out value blocks.
+   n      = (int)behaviors.size();
+   offset = sizeof(MAPPED_MAGIC) + (2 * sizeof(int)) + (n * sizeof(entry));
+   for (i = 0; i < n; i++)
+   {
+      behavior           = behaviors[i];
+      entry.steps        = behavior->sensorSequence.size();
+      entry.numSensors   = behavior->sensorSequence.width();
+      entry.numMotors    = behavior->motorSequence.width();
+      entry.pad          = 0;
+      assert(behavior->motorSequence.size() == entry.steps);
+      offset             = ((offset + MAPPED_ALIGNMENT - 1) / MAPPED_ALIGNMENT) * MAPPED_ALIGNMENT;
+      entry.sensorOffset = offset;
+      offset            += (long long)entry.steps * entry.numSensors * sizeof(float);
+      offset             = ((offset + MAPPED_ALIGNMENT - 1) / MAPPED_ALIGNMENT) * MAPPED_ALIGNMENT;
+      entry.motorOffset  = offset;
+      offset            += (long long)entry.steps * entry.numMotors * sizeof(float);
+      directory.push_back(entry);
+   }
+
+   FilePointer *fp = FOPEN_WRITE(filename, true);
+   if (fp == NULL)
+   {
+      return(false);
+   }
+   FWRITE_BYTES((unsigned char *)MAPPED_MAGIC, sizeof(MAPPED_MAGIC), fp);
+   version = MAPPED_VERSION;
+   FWRITE_INT(&version, fp);
+   FWRITE_INT(&n, fp);
+   if (n > 0)
+   {
+      FWRITE_BYTES((unsigned char *)&directory[0], n * sizeof(entry), fp);
+   }
+   memset(pad, 0, sizeof(pad));
+   offset = sizeof(MAPPED_MAGIC) + (2 * sizeof(int)) + (n * sizeof(entry));
+   for (i = 0; i < n; i++)
+   {
+      behavior = behaviors[i];
+      FWRITE_BYTES(pad, (int)(directory[i].sensorOffset - offset), fp);
+      size = (long long)directory[i].steps * directory[i].numSensors * sizeof(float);
+      if (size > 0)
+      {
+         FWRITE_BYTES((unsigned char *)behavior->sensorSequence.data(), (int)size, fp);
+      }
+      offset = directory[i].sensorOffset + size;
+      FWRITE_BYTES(pad, (int)(directory[i].motorOffset - offset), fp);
+      size = (long long)directory[i].steps * directory[i].numMotors * sizeof(float);
+      if (size > 0)
+      {
+         FWRITE_BYTES((unsigned char *)behavior->motorSequence.data(), (int)size, fp);
+      }
+      offset = directory[i].motorOffset + size;
+   }
+   if (ferror(fp->fp))
+   {
+      FCLOSE(fp);
+      return(false);
+   }
+   FCLOSE(fp);
+   return(true);
+}
+
+
+// Load behaviors from mapped behaviors file.
+// Behavior sequences refer to the mapped values, which are
+// unmapped when the last referring behavior is deleted.
+bool Behavior::mapBehaviors(vector<Behavior *>& behaviors, char *filename)
+{
+   int           i, n, version;
+   long          length;
+   unsigned char *base;
+   Behavior      *behavior;
+   MappedFile    *mappedFile;
+
+   struct MappedBehaviorEntry *directory;
+
+#ifdef WIN32
+   FILE *fp = fopen(filename, "rb");
+   if (fp == NULL)
+   {
+      return(false);
+   }
+   fseek(fp, 0, SEEK_END);
+   length = ftell(fp);
+   fseek(fp, 0, SEEK_SET);
+   base = new unsigned char[length + 1];
+   assert(base != NULL);
+   if (fread(base, 1, length, fp) != (size_t)length)
+   {
+      fclose(fp);
+      delete [] base;
+      return(false);
+   }
+   fclose(fp);
+#else
+   struct stat info;
+   int         fd = open(filename, O_RDONLY);
+   if (fd == -1)
+   {
+      return(false);
+   }
+   if (fstat(fd, &info) == -1)
+   {
+      close(fd);
+      return(false);
+   }
+   length = (long)info.st_size;
+   base   = (unsigned char *)mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+   close(fd);
+   if (base == (unsigned char *)MAP_FAILED)
+   {
+      fprintf(stderr, "Cannot map behaviors file %s, errno=%d\n", filename, errno);
+      return(false);
+   }
+#endif
+   mappedFile = new MappedFile;
+   assert(mappedFile != NULL);
+   mappedFile->base       = base;
+   mappedFile->length     = length;
+   mappedFile->references = 1;
+
+   // Validate header and directory.
+   n = 0;
+   if (length >= (long)(sizeof(MAPPED_MAGIC) + (2 * sizeof(int))))
+   {
+      memcpy(&version, &base[sizeof(MAPPED_MAGIC)], sizeof(int));
+      memcpy(&n, &base[sizeof(MAPPED_MAGIC) + sizeof(int)], sizeof(int));
+   }
+   else
+   {
+      version = -1;
+   }
+   if ((memcmp(base, MAPPED_MAGIC, sizeof(MAPPED_MAGIC)) != 0) ||
+       (version != MAPPED_VERSION) || (n < 0) ||
+       ((long long)length <
+        (long long)(sizeof(MAPPED_MAGIC) + (2 * sizeof(int)) + (n * sizeof(struct MappedBehaviorEntry)))))
+   {
+      fprintf(stderr, "Invalid mapped behaviors file %s\n", filename);
+      unmapFile(mappedFile);
+      return(false);
+   }
+   directory = (struct MappedBehaviorEntry *)&base[sizeof(MAPPED_MAGIC) + (2 * sizeof(int))];
+   for (i = 0; i < n; i++)
+   {
+      if ((directory[i].steps < 0) || (directory[i].numSensors < 0) || (directory[i].numMotors < 0) ||
+          (directory[i].sensorOffset < 0) || (directory[i].motorOffset < 0) ||
+          ((directory[i].sensorOffset % (long long)sizeof(float)) != 0) ||
+          ((directory[i].motorOffset % (long long)sizeof(float)) != 0) ||
+          ((directory[i].sensorOffset +
+            ((long long)directory[i].steps * directory[i].numSensors * (long long)sizeof(float))) > (long long)length) ||
+          ((directory[i].motorOffset +
+            ((long long)directory[i].steps * directory[i].numMotors * (long long)sizeof(float))) > (long long)length))
+      {
+         fprintf(stderr, "Invalid mapped behaviors file %s\n", filename);
+         unmapFile(mappedFile);
+         return(false);
+      }
+   }
+
+   // Create behaviors using mapped values.
+   behaviors.clear();
+   for (i = 0; i < n; i++)
+   {
+      behavior = new Behavior();
+      assert(behavior != NULL);
+      behavior->sensorSequence.map((float *)&base[directory[i].sensorOffset],
+                                   directory[i].steps, directory[i].numSensors);
+      behavior->motorSequence.map((float *)&base[directory[i].motorOffset],
+                                  directory[i].steps, directory[i].numMotors);
+      behavior->mappedFile = mappedFile;
+      mappedFile->references++;
+      behaviors.push_back(behavior);
+   }
+   unmapFile(mappedFile);
+   return(true);
+}
+
+
+// Release mapped behaviors file reference.
+void Behavior::unmapFile(MappedFile *mappedFile)
+{
+   mappedFile->references--;
+   if (mappedFile->references > 0)
+   {
+      return;
+   }
+#ifdef WIN32
+   delete [] (unsigned char *)mappedFile->base;
+#else
+   munmap(mappedFile->base, mappedFile->length);
+#endif
+   delete mappedFile;
+}
+
+
+// Behavior prefix trie constructor.
+BehaviorTrie::BehaviorTrie(vector<Behavior *>& behaviors)
+{
+   int   i, j, n, m, w, node, child;
+   float *sensors;
+   Node  root;
+
+   root.depth       = -1;
+   root.sensors     = NULL;
+   root.numSensors  = 0;
+   root.firstChild  = root.lastChild = root.nextSibling = -1;
+   nodes.push_back(root);
+   paths.resize(behaviors.size());
+   for (i = 0, n = (int)behaviors.size(); i < n; i++)
+   {
+      w = behaviors[i]->sensorSequence.width();
+      for (j = node = 0, m = behaviors[i]->sensorSequence.size(); j < m; j++)
+      {
+         sensors = behaviors[i]->sensorSequence[j];
+         for (child = nodes[node].firstChild; child != -1; child = nodes[child].nextSibling)
+         {
+            if ((nodes[child].numSensors == w) &&
+                (memcmp(nodes[child].sensors, sensors, w * sizeof(float)) == 0))
+            {
+               break;
+            }
+         }
+         if (child == -1)
+         {
+            Node next;
+            next.depth       = j;
+            next.sensors     = sensors;
+            next.numSensors  = w;
+            next.firstChild  = next.lastChild = next.nextSibling = -1;
+            child            = (int)nodes.size();
+            nodes.push_back(next);
+            if (nodes[node].lastChild == -1)
+            {
+               nodes[node].firstChild = child;
+            }
+            else
+            {
+               nodes[nodes[node].lastChild].nextSibling = child;
+            }
+            nodes[node].lastChild = child;
+         }
+         paths[i].push_back(child);
+         node = child;
+      }
+   }
+}
+
+
+// Number of simulated steps with trie.
+int BehaviorTrie::trieSteps(int maxStep)
+{
+   int i, n, steps;
+
+   for (i = 1, n = (int)nodes.size(), steps = 0; i < n; i++)
+   {
+      if ((maxStep == -1) || (nodes[i].depth <= maxStep))
+      {
+         steps++;
+      }
+   }
+   return(steps);
+}
+
+
+// Number of simulated steps without trie.
+int BehaviorTrie::behaviorSteps(int maxStep)
+{
+   int i, n, m, steps;
+
+   for (i = steps = 0, n = (int)paths.size(); i < n; i++)
+   {
+      m = (int)paths[i].size();
+      if ((maxStep != -1) && ((maxStep + 1) < m))
+      {
+         m = maxStep + 1;
+      }
+      steps += m;
+   }
+   return(steps);
+}
+
+
+// Run network through trie, storing motor outputs by node.
+// The network is left in the state of simulating the behaviors in order.
+void BehaviorTrie::run(Network *network, int maxStep, BehaviorSequence& motorOutputs)
+{
+   int   i, j, k, m, node, last, lastBehavior;
+   float *motors;
+
+   vector<pair<int, int> > open;
+   vector<vector<float> >  states;
+   vector<float>           lastState;
+
+   motorOutputs.resize((int)nodes.size(), network->numMotors);
+
+   // Final node of last simulated behavior.
+   last = -1;
+   for (i = (int)paths.size() - 1; i >= 0; i--)
+   {
+      m = (int)paths[i].size();
+      if ((maxStep != -1) && ((maxStep + 1) < m))
+      {
+         m = maxStep + 1;
+      }
+      if (m > 0)
+      {
+         last = paths[i][m - 1];
+         break;
+      }
+   }
+   lastBehavior = i;
+
+   // Depth-first traversal, saving state at branch points.
+   network->clear();
+   open.push_back(pair<int, int>(0, -1));
+   while (open.size() > 0)
+   {
+      node = open.back().first;
+      k    = open.back().second;
+      open.pop_back();
+      if (k != -1)
+      {
+         network->setState(states[k]);
+      }
+      while (true)
+      {
+         if (node != 0)
+         {
+            assert(network->numSensors == nodes[node].numSensors);
+            for (j = 0; j < network->numSensors; j++)
+            {
+               network->neurons[j]->bias = nodes[node].sensors[j];
+            }
+            network->step();
+            motors = motorOutputs[node];
+            for (j = 0; j < network->numMotors; j++)
+            {
+               motors[j] = network->neurons[network->numSensors + j]->activation;
+            }
+            if (node == last)
+            {
+               network->getState(lastState);
+            }
+         }
+         m = nodes[node].firstChild;
+         if ((m == -1) || ((maxStep != -1) && (nodes[m].depth > maxStep)))
+         {
+            break;
+         }
+         if (nodes[m].nextSibling != -1)
+         {
+            k = (int)states.size();
+            states.resize(k + 1);
+            network->getState(states[k]);
+            for (j = nodes[m].nextSibling; j != -1; j = nodes[j].nextSibling)
+            {
+               open.push_back(pair<int, int>(j, k));
+            }
+         }
+         node = m;
+      }
+   }
+
+   // Restore state of sequential simulation:
+   // trailing behaviors with no steps leave the network cleared.
+   if (last != -1)
+   {
+      network->setState(lastState);
+      if (lastBehavior < ((int)paths.size() - 1))
+      {
+         network->clear();
+      }
+   }
+}
@@ -4,22 +4,67 @@
 #define __BEHAVIOR_HPP__
 
 #include <stdlib.h>
+#include <string.h>
 #include <vector>
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 #include "network.hpp"
 using namespace std;
 
+// Behavior sequence: contiguous row-major matrix with one row of
+// sensor or motor values per step.
+// Values are either owned or reside in a mapped behaviors file.
+class BehaviorSequence
+{
+public:
+   BehaviorSequence();
+   BehaviorSequence(const BehaviorSequence& sequence);
+   ~BehaviorSequence();
+   BehaviorSequence& operator=(const BehaviorSequence& sequence);
+
+   // Number of steps.
+   int size() { return(steps); }
+
+   // Values per step.
+   int width() { return(columns); }
+
+   // Step values.
+   float *operator[](int step) { return(&values[step * columns]); }
+
+   // Contiguous values.
+   float *data() { return(values); }
+
+   // Resize, discarding previous values.
+   void resize(int steps, int columns, float value = 0.0f);
+
+   // Use values in place without copying.
+   void map(float *values, int steps, int columns);
+
+   // Clear.
+   void clear();
+
+private:
+   float *values;
+   int   steps;
+   int   columns;
+   bool  owned;
+};
+
 class Behavior
 {
 public:
    Behavior(Network *network, int length, Random *randomizer);
-   Behavior(Network *network, vector<vector<float> >& sensors);
-   Behavior() {}
+   Behavior(Network *network, BehaviorSequence& sensors, int maxStep = (-1));
+   Behavior();
    Behavior(FilePointer *fp);
    ~Behavior();
 
    // Sensory-motor sequence.
-   vector<vector<float> > sensorSequence;
-   vector<vector<float> > motorSequence;
+   BehaviorSequence sensorSequence;
+   BehaviorSequence motorSequence;
 
    // Load.
    void load(FilePointer *fp);
@@ -34,9 +79,74 @@ public:
    void printMotorDeltas(Behavior *behavior, float tolerance = 0.0f);
 
    // Load behaviors from file.
+   // Mapped behaviors files are detected and used in place.
    static bool loadBehaviors(vector<Behavior *>& behaviors, char *filename, bool binary = false);
 
    // Save behaviors to file.
    static bool saveBehaviors(vector<Behavior *>& behaviors, char *filename, bool binary = false);
+
+   // Mapped behaviors file format:
+   // header: magic, version, number of behaviors,
+   // directory: per behavior steps, sensors, motors, and sensor and motor value offsets,
+   // values: per behavior sensor matrix and motor matrix, native floats aligned to MAPPED_ALIGNMENT.
+   static const char MAPPED_MAGIC[8];
+   enum { MAPPED_VERSION = 1, MAPPED_ALIGNMENT = 64 };
+
+   // Save behaviors to mapped behaviors file.
+   static bool saveMappedBehaviors(vector<Behavior *>& behaviors, char *filename);
+
+   // Load behaviors from mapped behaviors file.
+   static bool mapBehaviors(vector<Behavior *>& behaviors, char *filename);
+
+private:
+
+   // Mapped behaviors file.
+   class MappedFile
+   {
+   public:
+      void *base;
+      long  length;
+      int   references;
+   };
+   MappedFile *mappedFile;
+   static void unmapFile(MappedFile *mappedFile);
+
+   // Behaviors sharing a mapped file are not copyable.
+   Behavior(const Behavior&);
+   Behavior& operator=(const Behavior&);
+};
+
+// Behavior prefix trie.
+// Behaviors sharing sensor sequence prefixes are simulated once up to each
+// branch point, where network state is saved and restored for each branch.
+class BehaviorTrie
+{
+public:
+   BehaviorTrie(vector<Behavior *>& behaviors);
+
+   // Trie node for each behavior step.
+   vector<vector<int> > paths;
+
+   // Number of simulated steps with and without trie.
+   int trieSteps(int maxStep = (-1));
+   int behaviorSteps(int maxStep = (-1));
+
+   // Run network through trie, storing motor outputs by node.
+   void run(Network *network, int maxStep, BehaviorSequence& motorOutputs);
+
+private:
+
+   // Trie node: root is node 0.
+   class Node
+   {
+   public:
+      int   depth;
+      float *sensors;
+      int   numSensors;
+      int   firstChild;
+      int   lastChild;
+      int   nextSibling;
+   };
+   vector<Node> nodes;
 };
 #endif
@@ -89,6 +89,13 @@ char *Usage[] =
    (char *)"   -printNetworkBehaviors",
    (char *)"   -loadBehaviors <behaviors file name>",
    (char *)"",
+   (char *)"Convert network behaviors to mapped format:",
+   (char *)"",
+   (char *)"bionet",
+   (char *)"   -convertNetworkBehaviors",
+   (char *)"   -loadBehaviors <behaviors file name>",
+   (char *)"   -saveBehaviors <mapped behaviors file name>",
+   (char *)"",
    (char *)"Create homomorphic networks:",
    (char *)"",
    (char *)"bionet (new morph)",
@@ -110,9 +117,27 @@ char *Usage[] =
    (char *)"   -synapseWeights <minimum> <maximum> <max delta>",
    (char *)"   -synapseCrossoverBondStrength <probability of connected neurons crossing over together>",
    (char *)"   -synapseOptimizedPathLength <synapse path length optimized as a group>",
+   (char *)"   [-racePermutations <behaviors per screening subset> <screening steps (0=entire sequences)>",
+   (char *)"      <fraction of permutations advancing to full evaluation> [<full evaluation audit interval (default 10, 0=never)>]]",
+   (char *)"   [-optimizer <permute | bptt [<iterations>] | cmaes [<evaluations>]> (synapse weight permutations (default),",
+   (char *)"      gradient descent by backpropagation through time (default 10 iterations),",
+   (char *)"      or CMA-ES search of synapse path weights within evaluation budget (default 100))]",
+   (char *)"   [-optimizeBudget <maximum synapse weight permutations evaluated per optimization,",
+   (char *)"      sampled by Latin hypercube if exceeded>]",
+   (char *)"   [-fitnessCacheSize <number of cached fitness evaluations shared by threads>]",
+   (char *)"   [-pipelineOffspring (mate, mutate and optimize each offspring in one task)]",
+   (char *)"   [-steadyState (replace worst member with each child, without generation barriers)]",
+   (char *)"   [-island <island index (mixed into random seed)> <island addresses (host:port or Unix socket path, comma-separated)>",
+   (char *)"      -migrate <generation interval> <number of migrants> [ring | random (target island, defaults to ring)]]",
+   (char *)"   [-evalFarm <worker port> [<maximum evaluations in flight per worker (default 4)> [<worker reply timeout seconds (default 60)>]] (loadBehaviors only)]",
+   (char *)"   [-numa [<probability of choosing parents from another node (default 0.1)>] (pin threads to NUMA node cores)]",
    (char *)"   -saveMorph <morph file name> and/or -saveNetworks [<files prefix (default=\"network_\")>]",
    (char *)"   [-randomSeed <random seed>]",
    (char *)"   [-logMorph <log file name>]",
+   (char *)"   [-logBufferSize <morph log memory budget in kilobytes (default 4096)>]",
+   (char *)"   [-binaryLog (write morph log as binary events, decoded with -decodeLog)]",
+   (char *)"   [-duplicates <reuse | mutate | reject> (duplicate offspring genome policy)]",
+   (char *)"   [-timeBudget <seconds> (fit generations to wall-clock budget, stopping in time to save)]",
 #ifdef THREADS
    (char *)"   [-numThreads <number of threads> (defaults to system capacity)]",
 #endif
@@ -129,8 +154,26 @@ char *Usage[] =
    (char *)"   [-mutationRate <probability> (defaults to loaded value)]",
    (char *)"   [-synapseBondStrength <probability of connected neurons crossing over together> (defaults to loaded value)]",
    (char *)"   [-synapseChainSize <number of chained synapses optimized as a group> (defaults to loaded value)]",
+   (char *)"   [-racePermutations <behaviors per screening subset> <screening steps (0=entire sequences)>",
+   (char *)"      <fraction of permutations advancing to full evaluation> [<full evaluation audit interval (default 10, 0=never)>]]",
+   (char *)"   [-optimizer <permute | bptt [<iterations>] | cmaes [<evaluations>]> (synapse weight permutations (default),",
+   (char *)"      gradient descent by backpropagation through time (default 10 iterations),",
+   (char *)"      or CMA-ES search of synapse path weights within evaluation budget (default 100))]",
+   (char *)"   [-optimizeBudget <maximum synapse weight permutations evaluated per optimization,",
+   (char *)"      sampled by Latin hypercube if exceeded>]",
+   (char *)"   [-fitnessCacheSize <number of cached fitness evaluations shared by threads>]",
+   (char *)"   [-pipelineOffspring (mate, mutate and optimize each offspring in one task)]",
+   (char *)"   [-steadyState (replace worst member with each child, without generation barriers)]",
+   (char *)"   [-island <island index (mixed into random seed)> <island addresses (host:port or Unix socket path, comma-separated)>",
+   (char *)"      -migrate <generation interval> <number of migrants> [ring | random (target island, defaults to ring)]]",
+   (char *)"   [-evalFarm <worker port> [<maximum evaluations in flight per worker (default 4)> [<worker reply timeout seconds (default 60)>]] (loadBehaviors only)]",
+   (char *)"   [-numa [<probability of choosing parents from another node (default 0.1)>] (pin threads to NUMA node cores)]",
    (char *)"   -saveMorph <morph file name> and/or -saveNetworks [<files prefix (default=\"network_\")>]",
    (char *)"   [-logMorph <morph log file name> (instead of standard output)]",
+   (char *)"   [-logBufferSize <morph log memory budget in kilobytes (default 4096)>]",
+   (char *)"   [-binaryLog (write morph log as binary events, decoded with -decodeLog)]",
+   (char *)"   [-duplicates <reuse | mutate | reject> (duplicate offspring genome policy)]",
+   (char *)"   [-timeBudget <seconds> (fit generations to wall-clock budget, stopping in time to save)]",
 #ifdef THREADS
    (char *)"   [-numThreads <number of threads> (defaults to system capacity)]",
 #endif
@@ -148,9 +191,23 @@ char *Usage[] =
    (char *)"   -synapseWeights <minimum> <maximum> <max delta>",
    (char *)"   -synapseCrossoverBondStrength <probability of connected neurons crossing over together>",
    (char *)"   -synapseOptimizedPathLength <synapse path length optimized as a group>",
+   (char *)"   [-optimizer <permute | cmaes [<evaluations>]> (synapse weight permutations (default),",
+   (char *)"      or CMA-ES search of synapse path weights within evaluation budget (default 100))]",
+   (char *)"   [-optimizeBudget <maximum synapse weight permutations evaluated per optimization,",
+   (char *)"      sampled by Latin hypercube if exceeded>]",
+   (char *)"   [-fitnessCacheSize <number of cached fitness evaluations shared by threads>]",
+   (char *)"   [-pipelineOffspring (mate, mutate and optimize each offspring in one task)]",
+   (char *)"   [-steadyState (replace worst member with each child, without generation barriers)]",
+   (char *)"   [-island <island index (mixed into random seed)> <island addresses (host:port or Unix socket path, comma-separated)>",
+   (char *)"      -migrate <generation interval> <number of migrants> [ring | random (target island, defaults to ring)]]",
+   (char *)"   [-numa [<probability of choosing parents from another node (default 0.1)>] (pin threads to NUMA node cores)]",
    (char *)"   -saveMorph <morph file name> and / or -saveNetworks [<files prefix(default = \"network_\")>]",
    (char *)"   [-randomSeed <random seed>]",
    (char *)"   [-logMorph <morph log file name>(instead of standard output)]",
+   (char *)"   [-logBufferSize <morph log memory budget in kilobytes (default 4096)>]",
+   (char *)"   [-binaryLog (write morph log as binary events, decoded with -decodeLog)]",
+   (char *)"   [-duplicates <reuse | mutate | reject> (duplicate offspring genome policy)]",
+   (char *)"   [-timeBudget <seconds> (fit generations to wall-clock budget, stopping in time to save)]",
    (char *)"   [-numThreads <number of threads>(defaults to system capacity)]",
    (char *)"",
    (char *)"bionet (resume undulation behavior morph)",
@@ -162,8 +219,22 @@ char *Usage[] =
    (char *)"   [-mutationRate <probability>(defaults to loaded value)]",
    (char *)"   [-synapseCrossoverBondStrength <probability of connected neurons crossing over together>]",
    (char *)"   [-synapseOptimizedPathLength <synapse path length optimized as a group>]",
+   (char *)"   [-optimizer <permute | cmaes [<evaluations>]> (synapse weight permutations (default),",
+   (char *)"      or CMA-ES search of synapse path weights within evaluation budget (default 100))]",
+   (char *)"   [-optimizeBudget <maximum synapse weight permutations evaluated per optimization,",
+   (char *)"      sampled by Latin hypercube if exceeded>]",
+   (char *)"   [-fitnessCacheSize <number of cached fitness evaluations shared by threads>]",
+   (char *)"   [-pipelineOffspring (mate, mutate and optimize each offspring in one task)]",
+   (char *)"   [-steadyState (replace worst member with each child, without generation barriers)]",
+   (char *)"   [-island <island index (mixed into random seed)> <island addresses (host:port or Unix socket path, comma-separated)>",
+   (char *)"      -migrate <generation interval> <number of migrants> [ring | random (target island, defaults to ring)]]",
+   (char *)"   [-numa [<probability of choosing parents from another node (default 0.1)>] (pin threads to NUMA node cores)]",
    (char *)"   -saveMorph <morph file name> and / or -saveNetworks [<files prefix(default = \"network_\")>]",
    (char *)"   [-logMorph <morph log file name>(instead of standard output)]",
+   (char *)"   [-logBufferSize <morph log memory budget in kilobytes (default 4096)>]",
+   (char *)"   [-binaryLog (write morph log as binary events, decoded with -decodeLog)]",
+   (char *)"   [-duplicates <reuse | mutate | reject> (duplicate offspring genome policy)]",
+   (char *)"   [-timeBudget <seconds> (fit generations to wall-clock budget, stopping in time to save)]",
    (char *)"   [-numThreads <number of threads>(defaults to system capacity)]",
    (char *)"",
    (char *)"bionet (new morph with NEURON simulator evaluation)",
@@ -182,9 +253,23 @@ char *Usage[] =
    (char *)"   -synapseWeights <minimum> <maximum> <max delta>",
    (char *)"   -synapseCrossoverBondStrength <probability of connected neurons crossing over together>",
    (char *)"   -synapseOptimizedPathLength <synapse path length optimized as a group>",
+   (char *)"   [-optimizer <permute | cmaes [<evaluations>]> (synapse weight permutations (default),",
+   (char *)"      or CMA-ES search of synapse path weights within evaluation budget (default 100))]",
+   (char *)"   [-optimizeBudget <maximum synapse weight permutations evaluated per optimization,",
+   (char *)"      sampled by Latin hypercube if exceeded>]",
+   (char *)"   [-fitnessCacheSize <number of cached fitness evaluations shared by threads>]",
+   (char *)"   [-pipelineOffspring (mate, mutate and optimize each offspring in one task)]",
+   (char *)"   [-steadyState (replace worst member with each child, without generation barriers)]",
+   (char *)"   [-island <island index (mixed into random seed)> <island addresses (host:port or Unix socket path, comma-separated)>",
+   (char *)"      -migrate <generation interval> <number of migrants> [ring | random (target island, defaults to ring)]]",
+   (char *)"   [-numa [<probability of choosing parents from another node (default 0.1)>] (pin threads to NUMA node cores)]",
    (char *)"   -saveMorph <morph file name> and / or -saveNetworks [<files prefix(default = \"network_\")>]",
    (char *)"   [-randomSeed <random seed>]",
    (char *)"   [-logMorph <morph log file name>(instead of standard output)]",
+   (char *)"   [-logBufferSize <morph log memory budget in kilobytes (default 4096)>]",
+   (char *)"   [-binaryLog (write morph log as binary events, decoded with -decodeLog)]",
+   (char *)"   [-duplicates <reuse | mutate | reject> (duplicate offspring genome policy)]",
+   (char *)"   [-timeBudget <seconds> (fit generations to wall-clock budget, stopping in time to save)]",
    (char *)"   [-numThreads <number of threads>(defaults to system capacity)]",
    (char *)"",
    (char *)"bionet (resume morph with NEURON simulator evaluation)",
@@ -198,8 +283,22 @@ char *Usage[] =
    (char *)"   [-mutationRate <probability>(defaults to loaded value)]",
    (char *)"   [-synapseCrossoverBondStrength <probability of connected neurons crossing over together>]",
    (char *)"   [-synapseOptimizedPathLength <synapse path length optimized as a group>]",
+   (char *)"   [-optimizer <permute | cmaes [<evaluations>]> (synapse weight permutations (default),",
+   (char *)"      or CMA-ES search of synapse path weights within evaluation budget (default 100))]",
+   (char *)"   [-optimizeBudget <maximum synapse weight permutations evaluated per optimization,",
+   (char *)"      sampled by Latin hypercube if exceeded>]",
+   (char *)"   [-fitnessCacheSize <number of cached fitness evaluations shared by threads>]",
+   (char *)"   [-pipelineOffspring (mate, mutate and optimize each offspring in one task)]",
+   (char *)"   [-steadyState (replace worst member with each child, without generation barriers)]",
+   (char *)"   [-island <island index (mixed into random seed)> <island addresses (host:port or Unix socket path, comma-separated)>",
+   (char *)"      -migrate <generation interval> <number of migrants> [ring | random (target island, defaults to ring)]]",
+   (char *)"   [-numa [<probability of choosing parents from another node (default 0.1)>] (pin threads to NUMA node cores)]",
    (char *)"   -saveMorph <morph file name> and / or -saveNetworks [<files prefix(default = \"network_\")>]",
    (char *)"   [-logMorph <morph log file name>(instead of standard output)]",
+   (char *)"   [-logBufferSize <morph log memory budget in kilobytes (default 4096)>]",
+   (char *)"   [-binaryLog (write morph log as binary events, decoded with -decodeLog)]",
+   (char *)"   [-duplicates <reuse | mutate | reject> (duplicate offspring genome policy)]",
+   (char *)"   [-timeBudget <seconds> (fit generations to wall-clock budget, stopping in time to save)]",
    (char *)"   [-numThreads <number of threads>(defaults to system capacity)]",
    (char *)"",
    (char *)"bionet (new morph with c302 simulator evaluation)",
@@ -216,9 +315,23 @@ char *Usage[] =
    (char *)"   -synapseWeights <minimum> <maximum> <max delta>",
    (char *)"   -synapseCrossoverBondStrength <probability of connected neurons crossing over together>",
    (char *)"   -synapseOptimizedPathLength <synapse path length optimized as a group>",
+   (char *)"   [-optimizer <permute | cmaes [<evaluations>]> (synapse weight permutations (default),",
+   (char *)"      or CMA-ES search of synapse path weights within evaluation budget (default 100))]",
+   (char *)"   [-optimizeBudget <maximum synapse weight permutations evaluated per optimization,",
+   (char *)"      sampled by Latin hypercube if exceeded>]",
+   (char *)"   [-fitnessCacheSize <number of cached fitness evaluations shared by threads>]",
+   (char *)"   [-pipelineOffspring (mate, mutate and optimize each offspring in one task)]",
+   (char *)"   [-steadyState (replace worst member with each child, without generation barriers)]",
+   (char *)"   [-island <island index (mixed into random seed)> <island addresses (host:port or Unix socket path, comma-separated)>",
+   (char *)"      -migrate <generation interval> <number of migrants> [ring | random (target island, defaults to ring)]]",
+   (char *)"   [-numa [<probability of choosing parents from another node (default 0.1)>] (pin threads to NUMA node cores)]",
    (char *)"   -saveMorph <morph file name> and / or -saveNetworks [<files prefix(default = \"network_\")>]",
    (char *)"   [-randomSeed <random seed>]",
    (char *)"   [-logMorph <morph log file name>(instead of standard output)]",
+   (char *)"   [-logBufferSize <morph log memory budget in kilobytes (default 4096)>]",
+   (char *)"   [-binaryLog (write morph log as binary events, decoded with -decodeLog)]",
+   (char *)"   [-duplicates <reuse | mutate | reject> (duplicate offspring genome policy)]",
+   (char *)"   [-timeBudget <seconds> (fit generations to wall-clock budget, stopping in time to save)]",
    (char *)"   [-numThreads <number of threads>(defaults to system capacity)]",
    (char *)"",
    (char *)"bionet (resume morph with c302 simulator evaluation)",
@@ -231,10 +344,35 @@ char *Usage[] =
    (char *)"   [-mutationRate <probability>(defaults to loaded value)]",
    (char *)"   [-synapseCrossoverBondStrength <probability of connected neurons crossing over together>]",
    (char *)"   [-synapseOptimizedPathLength <synapse path length optimized as a group>]",
+   (char *)"   [-optimizer <permute | cmaes [<evaluations>]> (synapse weight permutations (default),",
+   (char *)"      or CMA-ES search of synapse path weights within evaluation budget (default 100))]",
+   (char *)"   [-optimizeBudget <maximum synapse weight permutations evaluated per optimization,",
+   (char *)"      sampled by Latin hypercube if exceeded>]",
+   (char *)"   [-fitnessCacheSize <number of cached fitness evaluations shared by threads>]",
+   (char *)"   [-pipelineOffspring (mate, mutate and optimize each offspring in one task)]",
+   (char *)"   [-steadyState (replace worst member with each child, without generation barriers)]",
+   (char *)"   [-island <island index (mixed into random seed)> <island addresses (host:port or Unix socket path, comma-separated)>",
+   (char *)"      -migrate <generation interval> <number of migrants> [ring | random (target island, defaults to ring)]]",
+   (char *)"   [-numa [<probability of choosing parents from another node (default 0.1)>] (pin threads to NUMA node cores)]",
    (char *)"   -saveMorph <morph file name> and / or -saveNetworks [<files prefix(default = \"network_\")>]",
    (char *)"   [-logMorph <morph log file name>(instead of standard output)]",
+   (char *)"   [-logBufferSize <morph log memory budget in kilobytes (default 4096)>]",
+   (char *)"   [-binaryLog (write morph log as binary events, decoded with -decodeLog)]",
+   (char *)"   [-duplicates <reuse | mutate | reject> (duplicate offspring genome policy)]",
+   (char *)"   [-timeBudget <seconds> (fit generations to wall-clock budget, stopping in time to save)]",
    (char *)"   [-numThreads <number of threads>(defaults to system capacity)]",
    (char *)"",
+   (char *)"Evaluate homomorphic network behaviors for morph with evalFarm option:",
+   (char *)"",
+   (char *)"bionet",
+   (char *)"   -evalWorker <morph host:worker port>",
+   (char *)"",
+   (char *)"Decode binary morph log:",
+   (char *)"",
+   (char *)"bionet",
+   (char *)"   -decodeLog <binary morph log file name>",
+   (char *)"   [-csv (export member events as comma-separated values)]",
+   (char *)"",
    (char *)"Merge homomorphic network populations:",
    (char *)"",
    (char *)"bionet",
@@ -769,7 +907,7 @@ int createNetworkBehaviors(int argc, char *argv[])
       {
          Behavior *sensorBehavior = sensorBehaviors[i];
          if ((sensorBehavior->sensorSequence.size() > 0) &&
-             ((int)sensorBehavior->sensorSequence[0].size() != network->numSensors))
+             (sensorBehavior->sensorSequence.width() != network->numSensors))
          {
             fprintf(stderr, "Number of sensors not equal\n");
             result = 1;
@@ -784,12 +922,11 @@ int createNetworkBehaviors(int argc, char *argv[])
    }
    else
    {
-      vector<vector<float> > sensorSequence;
-      Behavior               *behavior;
-      sensorSequence.resize(undulationMovements);
+      BehaviorSequence sensorSequence;
+      Behavior         *behavior;
+      sensorSequence.resize(undulationMovements, network->numSensors);
       for (i = 0; i < undulationMovements; i++)
       {
-         sensorSequence[i].resize(network->numSensors, 0.0f);
          sensorSequence[i][UndulationNetworkHomomorph::sensorIndices[0].index] = 1.0f;
          sensorSequence[i][UndulationNetworkHomomorph::sensorIndices[1].index] = 1.0f;
       }
@@ -906,7 +1043,7 @@ int testNetworkBehaviors(int argc, char *argv[])
    {
       Behavior *behavior = behaviors[i];
       if ((behavior->sensorSequence.size() > 0) &&
-          ((int)behavior->sensorSequence[0].size() != network->numSensors))
+          (behavior->sensorSequence.width() != network->numSensors))
       {
          fprintf(stderr, "Number of sensors not equal\n");
          result = 1;
@@ -984,6 +1121,74 @@ int printNetworkBehaviors(int argc, char *argv[])
 }
 
 
+// Convert network behaviors to mapped format.
+int convertNetworkBehaviors(int argc, char *argv[])
+{
+   int  i, n, result;
+   char *behaviorsLoadFile = NULL;
+   char *behaviorsSaveFile = NULL;
+
+   vector<Behavior *> behaviors;
+
+   for (i = 1; i < argc; i++)
+   {
+      if (strcmp(argv[i], "-convertNetworkBehaviors") == 0)
+      {
+         continue;
+      }
+      if (strcmp(argv[i], "-loadBehaviors") == 0)
+      {
+         i++;
+         if ((i >= argc) || (argv[i][0] == '-'))
+         {
+            printUsageError(argv[i - 1]);
+            return(1);
+         }
+         behaviorsLoadFile = argv[i];
+         continue;
+      }
+      if (strcmp(argv[i], "-saveBehaviors") == 0)
+      {
+         i++;
+         if ((i >= argc) || (argv[i][0] == '-'))
+         {
+            printUsageError(argv[i - 1]);
+            return(1);
+         }
+         behaviorsSaveFile = argv[i];
+         continue;
+      }
+      printUsageError((char *)"invalid option");
+      return(1);
+   }
+
+   if ((behaviorsLoadFile == NULL) || (behaviorsSaveFile == NULL))
+   {
+      printUsageError((char *)"missing required option");
+      return(1);
+   }
+
+   // Convert behaviors.
+   if (!Behavior::loadBehaviors(behaviors, behaviorsLoadFile))
+   {
+      fprintf(stderr, "Cannot load behaviors from file %s\n", behaviorsLoadFile);
+      return(1);
+   }
+   result = 0;
+   if (!Behavior::saveMappedBehaviors(behaviors, behaviorsSaveFile))
+   {
+      fprintf(stderr, "Cannot save behaviors to file %s\n", behaviorsSaveFile);
+      result = 1;
+   }
+   for (i = 0, n = (int)behaviors.size(); i < n; i++)
+   {
+      delete behaviors[i];
+   }
+   behaviors.clear();
+   return(result);
+}
+
+
 // Global homomorphogenesis.
 NetworkHomomorphoGenesis *MorphoGenesis = NULL;
 
@@ -1013,6 +1218,24 @@ int createHomomorphicNetworks(int argc, char *argv[])
    MutableParm synapseWeightsParm;
    float       synapseCrossoverBondStrength = -1.0f;
    int         synapseOptimizedPathLength   = -1;
+   NetworkHomomorph::RaceSchedule raceSchedule;
+   int                            optimizer = NetworkHomomorphoGenesis::PERMUTE_OPTIMIZER;
+   int                            optimizerBudget = -1;
+   int                            optimizeBudget  = -1;
+   int         fitnessCacheSize = -1;
+   bool        pipelineOffspring = false;
+   bool        steadyState       = false;
+   int         islandIndex       = -1;
+   vector<string> islandAddresses;
+   int         migrationInterval = -1;
+   int         numMigrants       = -1;
+   Island::TOPOLOGY migrationTopology = Island::RING;
+   int         evalFarmPort      = -1;
+   int         evalFarmInFlight  = EvalFarm::DEFAULT_MAX_IN_FLIGHT;
+   int         evalFarmTimeout   = EvalFarm::DEFAULT_REPLY_TIMEOUT;
+   bool        numaPlacement     = false;
+   float       numaMigrationRate = Numa::DEFAULT_MIGRATION_RATE;
+   string      wisdomFile;
    bool        saveNetworks   = false;
    char        *filesPrefix   = (char *)"network_";
    RANDOM      randomSeed     = Network::DEFAULT_RANDOM_SEED;
@@ -1020,6 +1243,11 @@ int createHomomorphicNetworks(int argc, char *argv[])
    char        *morphSaveFile = NULL;
    char        *morphLoadFile = NULL;
    char        *logFile       = NULL;
+   int         logBufferSize = MorphLog::DEFAULT_BUFFER_SIZE;
+   bool        binaryLog     = false;
+   int         duplicatePolicy = NetworkHomomorphoGenesis::KEEP_DUPLICATES;
+   int         timeBudget      = -1;
+   TIME        startTime       = gettime();
 
 #ifdef THREADS
    int numThreads = -1;
@@ -1356,6 +1584,259 @@ int createHomomorphicNetworks(int argc, char *argv[])
          }
          continue;
       }
+      if (strcmp(argv[i], "-optimizer") == 0)
+      {
+         i++;
+         if (i >= argc)
+         {
+            printUsageError(argv[i - 1]);
+            return(1);
+         }
+         if (strcmp(argv[i], "permute") == 0)
+         {
+            optimizer = NetworkHomomorphoGenesis::PERMUTE_OPTIMIZER;
+         }
+         else if (strcmp(argv[i], "bptt") == 0)
+         {
+            optimizer = NetworkHomomorphoGenesis::BPTT_OPTIMIZER;
+            if (((i + 1) < argc) && (argv[i + 1][0] != '-'))
+            {
+               i++;
+               optimizerBudget = atoi(argv[i]);
+               if (optimizerBudget <= 0)
+               {
+                  printUsageError(argv[i - 2]);
+                  return(1);
+               }
+            }
+         }
+         else if (strcmp(argv[i], "cmaes") == 0)
+         {
+            optimizer = NetworkHomomorphoGenesis::CMAES_OPTIMIZER;
+            if (((i + 1) < argc) && (argv[i + 1][0] != '-'))
+            {
+               i++;
+               optimizerBudget = atoi(argv[i]);
+               if (optimizerBudget <= 0)
+               {
+                  printUsageError(argv[i - 2]);
+                  return(1);
+               }
+            }
+         }
+         else
+         {
+            printUsageError(argv[i - 1]);
+            return(1);
+         }
+         continue;
+      }
+      if (strcmp(argv[i], "-optimizeBudget") == 0)
+      {
+         i++;
+         if (i >= argc)
+         {
+            printUsageError(argv[i - 1]);
+            return(1);
+         }
+         optimizeBudget = atoi(argv[i]);
+         if (optimizeBudget <= 0)
+         {
+            printUsageError(argv[i - 1]);
+            return(1);
+         }
+         continue;
+      }
+      if (strcmp(argv[i], "-racePermutations") == 0)
+      {
+         if (((i + 3) >= argc) || (argv[i + 1][0] == '-') ||
+             (argv[i + 2][0] == '-') || (argv[i + 3][0] == '-'))
+         {
+            printUsageError(argv[i]);
+            return(1);
+         }
+         raceSchedule.behaviors = atoi(argv[i + 1]);
+         raceSchedule.steps     = atoi(argv[i + 2]);
+         raceSchedule.advance   = (float)atof(argv[i + 3]);
+         if ((raceSchedule.behaviors <= 0) || (raceSchedule.steps < 0) ||
+             (raceSchedule.advance <= 0.0f) || (raceSchedule.advance > 1.0f))
+         {
+            printUsageError(argv[i]);
+            return(1);
+         }
+         if (raceSchedule.steps == 0)
+         {
+            raceSchedule.steps = -1;
+         }
+         i += 3;
+         if (((i + 1) < argc) && (argv[i + 1][0] != '-'))
+         {
+            i++;
+            raceSchedule.auditInterval = atoi(argv[i]);
+            if (raceSchedule.auditInterval < 0)
+            {
+               printUsageError(argv[i - 4]);
+               return(1);
+            }
+         }
+         continue;
+      }
+      if (strcmp(argv[i], "-fitnessCacheSize") == 0)
+      {
+         i++;
+         if ((i >= argc) || (argv[i][0] == '-'))
+         {
+            printUsageError(argv[i - 1]);
+            return(1);
+         }
+         fitnessCacheSize = atoi(argv[i]);
+         if (fitnessCacheSize <= 0)
+         {
+            printUsageError(argv[i - 1]);
+            return(1);
+         }
+         continue;
+      }
+      if (strcmp(argv[i], "-pipelineOffspring") == 0)
+      {
+         pipelineOffspring = true;
+         continue;
+      }
+      if (strcmp(argv[i], "-steadyState") == 0)
+      {
+         steadyState = true;
+         continue;
+      }
+      if (strcmp(argv[i], "-island") == 0)
+      {
+         i++;
+         if ((i >= argc) || (argv[i][0] == '-'))
+         {
+            printUsageError(argv[i - 1]);
+            return(1);
+         }
+         islandIndex = atoi(argv[i]);
+         if (islandIndex < 0)
+         {
+            printUsageError(argv[i - 1]);
+            return(1);
+         }
+         i++;
+         if ((i >= argc) || (argv[i][0] == '-'))
+         {
+            printUsageError(argv[i - 2]);
+            return(1);
+         }
+         char comma[] = ",";
+         char *token  = strtok(argv[i], comma);
+         while (token != NULL)
+         {
+            islandAddresses.push_back(token);
+            token = strtok(NULL, comma);
+         }
+         if ((islandAddresses.size() < 2) || (islandIndex >= (int)islandAddresses.size()))
+         {
+            printUsageError(argv[i - 2]);
+            return(1);
+         }
+         continue;
+      }
+      if (strcmp(argv[i], "-evalFarm") == 0)
+      {
+         i++;
+         if ((i >= argc) || (argv[i][0] == '-'))
+         {
+            printUsageError(argv[i - 1]);
+            return(1);
+         }
+         evalFarmPort = atoi(argv[i]);
+         if (evalFarmPort <= 0)
+         {
+            printUsageError(argv[i - 1]);
+            return(1);
+         }
+         if (((i + 1) < argc) && (argv[i + 1][0] != '-'))
+         {
+            i++;
+            evalFarmInFlight = atoi(argv[i]);
+            if (evalFarmInFlight <= 0)
+            {
+               printUsageError(argv[i - 2]);
+               return(1);
+            }
+            if (((i + 1) < argc) && (argv[i + 1][0] != '-'))
+            {
+               i++;
+               evalFarmTimeout = atoi(argv[i]);
+               if (evalFarmTimeout <= 0)
+               {
+                  printUsageError(argv[i - 3]);
+                  return(1);
+               }
+            }
+         }
+         continue;
+      }
+      if (strcmp(argv[i], "-numa") == 0)
+      {
+         numaPlacement = true;
+         if (((i + 1) < argc) && (argv[i + 1][0] != '-'))
+         {
+            i++;
+            numaMigrationRate = (float)atof(argv[i]);
+            if ((numaMigrationRate < 0.0f) || (numaMigrationRate > 1.0f))
+            {
+               printUsageError(argv[i - 1]);
+               return(1);
+            }
+         }
+         continue;
+      }
+      if (strcmp(argv[i], "-migrate") == 0)
+      {
+         i++;
+         if ((i >= argc) || (argv[i][0] == '-'))
+         {
+            printUsageError(argv[i - 1]);
+            return(1);
+         }
+         migrationInterval = atoi(argv[i]);
+         if (migrationInterval <= 0)
+         {
+            printUsageError(argv[i - 1]);
+            return(1);
+         }
+         i++;
+         if ((i >= argc) || (argv[i][0] == '-'))
+         {
+            printUsageError(argv[i - 2]);
+            return(1);
+         }
+         numMigrants = atoi(argv[i]);
+         if (numMigrants <= 0)
+         {
+            printUsageError(argv[i - 2]);
+            return(1);
+         }
+         if (((i + 1) < argc) && (argv[i + 1][0] != '-'))
+         {
+            i++;
+            if (strcmp(argv[i], "ring") == 0)
+            {
+               migrationTopology = Island::RING;
+            }
+            else if (strcmp(argv[i], "random") == 0)
+            {
+               migrationTopology = Island::RANDOM_ISLAND;
+            }
+            else
+            {
+               printUsageError(argv[i - 3]);
+               return(1);
+            }
+         }
+         continue;
+      }
       if (strcmp(argv[i], "-saveNetworks") == 0)
       {
          saveNetworks = true;
@@ -1415,6 +1896,70 @@ int createHomomorphicNetworks(int argc, char *argv[])
          logFile = argv[i];
          continue;
       }
+      if (strcmp(argv[i], "-logBufferSize") == 0)
+      {
+         i++;
+         if ((i >= argc) || (argv[i][0] == '-'))
+         {
+            printUsageError(argv[i - 1]);
+            return(1);
+         }
+         logBufferSize = atoi(argv[i]);
+         if (logBufferSize <= 0)
+         {
+            printUsageError(argv[i - 1]);
+            return(1);
+         }
+         continue;
+      }
+      if (strcmp(argv[i], "-binaryLog") == 0)
+      {
+         binaryLog = true;
+         continue;
+      }
+      if (strcmp(argv[i], "-duplicates") == 0)
+      {
+         i++;
+         if (i >= argc)
+         {
+            printUsageError(argv[i - 1]);
+            return(1);
+         }
+         if (strcmp(argv[i], "reuse") == 0)
+         {
+            duplicatePolicy = NetworkHomomorphoGenesis::REUSE_DUPLICATES;
+         }
+         else if (strcmp(argv[i], "mutate") == 0)
+         {
+            duplicatePolicy = NetworkHomomorphoGenesis::MUTATE_DUPLICATES;
+         }
+         else if (strcmp(argv[i], "reject") == 0)
+         {
+            duplicatePolicy = NetworkHomomorphoGenesis::REJECT_DUPLICATES;
+         }
+         else
+         {
+            printUsageError(argv[i - 1]);
+            return(1);
+         }
+         continue;
+      }
+      if (strcmp(argv[i], "-timeBudget") == 0)
+      {
+         i++;
+         if ((i >= argc) || (argv[i][0] == '-'))
+         {
+            printUsageError(argv[i - 1]);
+            return(1);
+         }
+         timeBudget = atoi(argv[i]);
+         if (timeBudget <= 0)
+         {
+            printUsageError(argv[i - 1]);
+            return(1);
+         }
+         continue;
+      }
 #ifdef THREADS
       if (strcmp(argv[i], "-numThreads") == 0)
       {
@@ -1508,6 +2053,46 @@ int createHomomorphicNetworks(int argc, char *argv[])
       printUsageError((char *)"conflicting loadBehaviors and undulationMovements options");
       return(1);
    }
+   if ((behaviorsLoadFile == NULL) && (raceSchedule.behaviors != -1))
+   {
+      printUsageError((char *)"racePermutations option requires loadBehaviors option");
+      return(1);
+   }
+   if ((behaviorsLoadFile == NULL) && (optimizer == NetworkHomomorphoGenesis::BPTT_OPTIMIZER))
+   {
+      printUsageError((char *)"bptt optimizer requires loadBehaviors option");
+      return(1);
+   }
+   if ((raceSchedule.behaviors != -1) && (optimizer == NetworkHomomorphoGenesis::BPTT_OPTIMIZER))
+   {
+      printUsageError((char *)"racePermutations option requires permute or cmaes optimizer");
+      return(1);
+   }
+   if (optimizeBudget != -1)
+   {
+      if (optimizer == NetworkHomomorphoGenesis::BPTT_OPTIMIZER)
+      {
+         printUsageError((char *)"optimizeBudget option requires permute or cmaes optimizer");
+         return(1);
+      }
+      if (optimizerBudget != -1)
+      {
+         printUsageError((char *)"optimizeBudget option conflicts with cmaes evaluations");
+         return(1);
+      }
+      optimizerBudget = optimizeBudget;
+   }
+   if ((evalFarmPort != -1) &&
+       ((undulationMovements != -1) || (neuronExecPath != NULL) || (jnmlCmdPath != NULL)))
+   {
+      printUsageError((char *)"conflicting evalFarm and undulationMovements/neuronExec/jnmlCmd options");
+      return(1);
+   }
+   if ((behaviorsLoadFile == NULL) && (evalFarmPort != -1))
+   {
+      printUsageError((char *)"evalFarm option requires loadBehaviors option");
+      return(1);
+   }
    if (undulationMovements != -1)
    {
       if (behaveCutoff != -1)
@@ -1572,6 +2157,16 @@ int createHomomorphicNetworks(int argc, char *argv[])
       printUsageError((char *)"missing save option");
       return(1);
    }
+   if ((islandIndex == -1) != (migrationInterval == -1))
+   {
+      printUsageError((char *)"island and migrate options must be used together");
+      return(1);
+   }
+   if (binaryLog && (logFile == NULL))
+   {
+      printUsageError((char *)"binaryLog option requires logMorph option");
+      return(1);
+   }
 
    vector<Behavior *> behaviors;
    if (behaviorsLoadFile != NULL)
@@ -1812,6 +2407,22 @@ int createHomomorphicNetworks(int argc, char *argv[])
       }
    }
 #endif
+
+   // Load Fourier transform planner wisdom kept with morph files
+   // so undulation member creation skips plan measurement.
+   if (undulationMovements != -1)
+   {
+      if (morphLoadFile != NULL)
+      {
+         wisdomFile = string(morphLoadFile) + ".wisdom";
+         UndulationNetworkHomomorph::loadWisdom((char *)wisdomFile.c_str());
+      }
+      if (morphSaveFile != NULL)
+      {
+         wisdomFile = string(morphSaveFile) + ".wisdom";
+         UndulationNetworkHomomorph::loadWisdom((char *)wisdomFile.c_str());
+      }
+   }
    result = 0;
    if (morphLoadFile == NULL)
    {
@@ -1842,6 +2453,11 @@ int createHomomorphicNetworks(int argc, char *argv[])
          printUsageError((char *)"numOffspring > 0 && populationSize < 2");
          return(1);
       }
+      if (islandIndex != -1)
+      {
+         // Islands sharing a seed would evolve identical populations.
+         randomSeed = Island::seed(randomSeed, islandIndex);
+      }
       homomorph = new Network(networkLoadFile);
       assert(homomorph != NULL);
       if (behaviorsLoadFile != NULL)
@@ -1949,11 +2565,77 @@ int createHomomorphicNetworks(int argc, char *argv[])
          MorphoGenesis->synapseOptimizedPathLength = synapseOptimizedPathLength;
       }
    }
+   MorphoGenesis->raceSchedule = raceSchedule;
+   MorphoGenesis->optimizer = optimizer;
+   MorphoGenesis->optimizerBudget = optimizerBudget;
+   MorphoGenesis->pipelineOffspring = pipelineOffspring;
+   MorphoGenesis->steadyState       = steadyState;
+   MorphoGenesis->numaPlacement     = numaPlacement;
+   MorphoGenesis->numaMigrationRate = numaMigrationRate;
+   MorphoGenesis->logBufferSize     = logBufferSize;
+   MorphoGenesis->binaryLog         = binaryLog;
+   MorphoGenesis->duplicatePolicy   = duplicatePolicy;
+   MorphoGenesis->timeBudget        = timeBudget;
+   MorphoGenesis->timeBudgetStart   = startTime;
+   Island *island = NULL;
+   if (islandIndex != -1)
+   {
+      island = new Island(islandIndex, islandAddresses, migrationTopology,
+                          migrationInterval, numMigrants);
+      assert(island != NULL);
+      if (!island->listen())
+      {
+         delete island;
+         delete MorphoGenesis;
+         MorphoGenesis = NULL;
+         return(1);
+      }
+      MorphoGenesis->island = island;
+   }
+   if (evalFarmPort != -1)
+   {
+      NetworkMorph::evalFarm = new EvalFarm(evalFarmPort, evalFarmInFlight, evalFarmTimeout,
+                                            MorphoGenesis->homomorph, MorphoGenesis->behaviors,
+                                            MorphoGenesis->fitnessMotorList);
+      assert(NetworkMorph::evalFarm != NULL);
+      if (!NetworkMorph::evalFarm->listen())
+      {
+         delete NetworkMorph::evalFarm;
+         NetworkMorph::evalFarm = NULL;
+         if (island != NULL)
+         {
+            delete island;
+         }
+         delete MorphoGenesis;
+         MorphoGenesis = NULL;
+         return(1);
+      }
+   }
+   if (fitnessCacheSize != -1)
+   {
+      NetworkMorph::fitnessCache = new FitnessCache(fitnessCacheSize);
+      assert(NetworkMorph::fitnessCache != NULL);
+   }
 #ifdef THREADS
    MorphoGenesis->morph(numGenerations, numThreads, behaveCutoff, logFile, morphSaveFile);
 #else
    MorphoGenesis->morph(numGenerations, behaveCutoff, logFile, morphSaveFile);
 #endif
+   if (NetworkMorph::fitnessCache != NULL)
+   {
+      delete NetworkMorph::fitnessCache;
+      NetworkMorph::fitnessCache = NULL;
+   }
+   if (NetworkMorph::evalFarm != NULL)
+   {
+      delete NetworkMorph::evalFarm;
+      NetworkMorph::evalFarm = NULL;
+   }
+   if (island != NULL)
+   {
+      delete island;
+      MorphoGenesis->island = NULL;
+   }
    if (morphSaveFile != NULL)
    {
       if (!MorphoGenesis->save(morphSaveFile))
@@ -1968,6 +2650,15 @@ int createHomomorphicNetworks(int argc, char *argv[])
    }
    delete MorphoGenesis;
    MorphoGenesis = NULL;
+   if (undulationMovements != -1)
+   {
+      if ((morphSaveFile != NULL) &&
+          !UndulationNetworkHomomorph::saveWisdom((char *)wisdomFile.c_str()))
+      {
+         fprintf(stderr, "Cannot save Fourier transform wisdom to file %s\n", wisdomFile.c_str());
+      }
+      UndulationNetworkHomomorph::destroyPlans();
+   }
    for (i = 0, n = (int)behaviors.size(); i < n; i++)
    {
       delete behaviors[i];
@@ -1981,6 +2672,76 @@ int createHomomorphicNetworks(int argc, char *argv[])
 }
 
 
+// Evaluate homomorphic network behaviors for evaluation farm.
+int evalWorker(int argc, char *argv[])
+{
+   char *masterAddress = NULL;
+
+   for (int i = 1; i < argc; i++)
+   {
+      if (strcmp(argv[i], "-evalWorker") == 0)
+      {
+         i++;
+         if ((i >= argc) || (argv[i][0] == '-'))
+         {
+            printUsageError(argv[i - 1]);
+            return(1);
+         }
+         masterAddress = argv[i];
+         continue;
+      }
+      printUsageError((char *)"invalid option");
+      return(1);
+   }
+   if (masterAddress == NULL)
+   {
+      printUsageError((char *)"missing required option");
+      return(1);
+   }
+   return(EvalFarm::work(masterAddress));
+}
+
+
+// Decode binary morph log to standard output.
+int decodeLog(int argc, char *argv[])
+{
+   char *logFile = NULL;
+   bool csv      = false;
+
+   for (int i = 1; i < argc; i++)
+   {
+      if (strcmp(argv[i], "-decodeLog") == 0)
+      {
+         i++;
+         if ((i >= argc) || (argv[i][0] == '-'))
+         {
+            printUsageError(argv[i - 1]);
+            return(1);
+         }
+         logFile = argv[i];
+         continue;
+      }
+      if (strcmp(argv[i], "-csv") == 0)
+      {
+         csv = true;
+         continue;
+      }
+      printUsageError((char *)"invalid option");
+      return(1);
+   }
+   if (logFile == NULL)
+   {
+      printUsageError((char *)"missing required option");
+      return(1);
+   }
+   if (!MorphLog::decode(logFile, stdout, csv))
+   {
+      return(1);
+   }
+   return(0);
+}
+
+
 // Merge homomorphic networks.
 int mergeHomomorphicNetworks(int argc, char *argv[])
 {
@@ -2560,8 +3321,11 @@ int main(int argc, char *argv[])
       CREATE_NETWORK_BEHAVIORS,
       TEST_NETWORK_BEHAVIORS,
       PRINT_NETWORK_BEHAVIORS,
+      CONVERT_NETWORK_BEHAVIORS,
       CREATE_HOMOMORPHIC_NETWORKS,
       MERGE_HOMOMORPHIC_NETWORKS,
+      EVAL_WORKER,
+      DECODE_LOG,
       CREATE_ISOMORPHIC_NETWORKS,
       BEHAVIOR_SEARCH,
       UNASSIGNED
@@ -2650,6 +3414,18 @@ int main(int argc, char *argv[])
             return(1);
          }
       }
+      if (strcmp(argv[i], "-convertNetworkBehaviors") == 0)
+      {
+         if (command == UNASSIGNED)
+         {
+            command = CONVERT_NETWORK_BEHAVIORS;
+         }
+         else
+         {
+            printUsageError((char *)"multiple commands");
+            return(1);
+         }
+      }
       if (strcmp(argv[i], "-createHomomorphicNetworks") == 0)
       {
          if (command == UNASSIGNED)
@@ -2674,6 +3450,30 @@ int main(int argc, char *argv[])
             return(1);
          }
       }
+      if (strcmp(argv[i], "-evalWorker") == 0)
+      {
+         if (command == UNASSIGNED)
+         {
+            command = EVAL_WORKER;
+         }
+         else
+         {
+            printUsageError((char *)"multiple commands");
+            return(1);
+         }
+      }
+      if (strcmp(argv[i], "-decodeLog") == 0)
+      {
+         if (command == UNASSIGNED)
+         {
+            command = DECODE_LOG;
+         }
+         else
+         {
+            printUsageError((char *)"multiple commands");
+            return(1);
+         }
+      }
       if (strcmp(argv[i], "-createIsomorphicNetworks") == 0)
       {
          if (command == UNASSIGNED)
@@ -2751,12 +3551,21 @@ int main(int argc, char *argv[])
    case PRINT_NETWORK_BEHAVIORS:
       return(printNetworkBehaviors(argc, argv));
 
+   case CONVERT_NETWORK_BEHAVIORS:
+      return(convertNetworkBehaviors(argc, argv));
+
    case CREATE_HOMOMORPHIC_NETWORKS:
       return(createHomomorphicNetworks(argc, argv));
 
    case MERGE_HOMOMORPHIC_NETWORKS:
       return(mergeHomomorphicNetworks(argc, argv));
 
+   case EVAL_WORKER:
+      return(evalWorker(argc, argv));
+
+   case DECODE_LOG:
+      return(decodeLog(argc, argv));
+
    case CREATE_ISOMORPHIC_NETWORKS:
       return(createIsomorphicNetworks(argc, argv));
 
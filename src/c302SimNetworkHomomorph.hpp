@@ -33,8 +33,17 @@ public:
    // c302 simulation fitness evaluation.
    void evaluate(c302Sim *modelSim, c302Sim *evalSim);
 
-   // Clone.
-   c302SimNetworkHomomorph *clone(int tag = (-1));
+   // Clone, optionally drawing from given randomizer.
+   c302SimNetworkHomomorph *clone(int tag = (-1), Random *randomizer = NULL);
+
+   // Reinitialize in place as constructed from homomorph, reusing network storage.
+   void init(Network *homomorph,
+             MutableParm& synapseWeightsParm,
+             vector<vector<pair<int, int> > > *motorConnections,
+             Random *randomizer, int tag = (-1));
+
+   // Clone member in place, optionally drawing from given randomizer.
+   void cloneFrom(c302SimNetworkHomomorph *member, int tag = (-1), Random *randomizer = NULL);
 
    // Load.
    void load(FilePointer *fp);
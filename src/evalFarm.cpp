@@ -0,0 +1,806 @@
+// Distributed fitness evaluation farm implementation.
+
+#include "evalFarm.hpp"
+#include "networkMorph.hpp"
+#ifndef WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#endif
+
+// Milliseconds between checks for termination while accepting workers.
+#define ACCEPT_POLL_MSEC       200
+
+// Worker connection attempts while master starts up.
+#define CONNECT_ATTEMPTS       100
+#define CONNECT_RETRY_USEC     100000
+
+// Constructor.
+EvalFarm::EvalFarm(int port, int maxInFlight, int replyTimeout, Network *network,
+                   vector<Behavior *>& behaviors, vector<bool>& fitnessMotorList)
+{
+#ifdef WIN32
+   fprintf(stderr, "Evaluation farm is not supported on Windows\n");
+   exit(1);
+#endif
+#ifndef THREADS
+   fprintf(stderr, "Evaluation farm requires threads\n");
+   exit(1);
+#endif
+   assert(maxInFlight > 0);
+   assert(replyTimeout > 0);
+   this->port             = port;
+   this->maxInFlight      = maxInFlight;
+   this->replyTimeout     = replyTimeout;
+   this->network          = network;
+   this->behaviors        = behaviors;
+   this->fitnessMotorList = fitnessMotorList;
+   nextRequest            = 0;
+   listener               = -1;
+   stop                   = false;
+   remoteCount            = localCount = 0;
+   lostCount              = 0;
+#ifdef THREADS
+   accepting = false;
+   if (pthread_mutex_init(&mutex, NULL) != 0)
+   {
+      fprintf(stderr, "pthread_mutex_init failed, errno=%d\n", errno);
+      exit(1);
+   }
+   if (pthread_cond_init(&replied, NULL) != 0)
+   {
+      fprintf(stderr, "pthread_cond_init failed, errno=%d\n", errno);
+      exit(1);
+   }
+#endif
+#ifndef WIN32
+   // Lost workers are detected by write errors.
+   signal(SIGPIPE, SIG_IGN);
+#endif
+}
+
+
+// Destructor.
+EvalFarm::~EvalFarm()
+{
+   int    i, n;
+   Worker *worker;
+
+   stop = true;
+#ifdef THREADS
+   if (accepting)
+   {
+      pthread_join(acceptor, NULL);
+   }
+#endif
+#ifndef WIN32
+   if (listener != -1)
+   {
+      close(listener);
+   }
+   for (i = 0, n = (int)workers.size(); i < n; i++)
+   {
+      worker = workers[i];
+      shutdown(worker->socket, SHUT_RDWR);
+#ifdef THREADS
+      pthread_join(worker->receiver, NULL);
+      pthread_mutex_destroy(&worker->sendMutex);
+#endif
+      FCLOSE(worker->in);
+      FCLOSE(worker->out);
+      delete worker;
+   }
+#endif
+   workers.clear();
+   for (map<int, Request *>::iterator request = requests.begin(); request != requests.end(); request++)
+   {
+      delete request->second;
+   }
+   requests.clear();
+#ifdef THREADS
+   pthread_cond_destroy(&replied);
+   pthread_mutex_destroy(&mutex);
+#endif
+}
+
+
+// Listen for workers.
+bool EvalFarm::listen()
+{
+#ifndef WIN32
+   int             on;
+   char            service[20];
+   struct addrinfo hints, *info, *p;
+
+   sprintf(service, "%d", port);
+   memset(&hints, 0, sizeof(hints));
+   hints.ai_family   = AF_INET;
+   hints.ai_socktype = SOCK_STREAM;
+   hints.ai_flags    = AI_PASSIVE;
+   if (getaddrinfo(NULL, service, &hints, &info) != 0)
+   {
+      fprintf(stderr, "Cannot resolve evaluation farm port %d\n", port);
+      return(false);
+   }
+   for (p = info; p != NULL && listener == -1; p = p->ai_next)
+   {
+      if ((listener = socket(p->ai_family, p->ai_socktype, p->ai_protocol)) == -1)
+      {
+         continue;
+      }
+      on = 1;
+      setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+      if ((bind(listener, p->ai_addr, p->ai_addrlen) == -1) ||
+          (::listen(listener, SOMAXCONN) == -1))
+      {
+         close(listener);
+         listener = -1;
+      }
+   }
+   freeaddrinfo(info);
+   if (listener == -1)
+   {
+      fprintf(stderr, "Cannot listen on evaluation farm port %d\n", port);
+      return(false);
+   }
+#ifdef THREADS
+   if (pthread_create(&acceptor, NULL, acceptThread, (void *)this) != 0)
+   {
+      fprintf(stderr, "Cannot create evaluation farm thread\n");
+      exit(1);
+   }
+   accepting = true;
+#endif
+   return(true);
+#else
+   return(false);
+#endif
+}
+
+
+#ifdef THREADS
+// Accept workers.
+void *EvalFarm::acceptThread(void *farmPtr)
+{
+#ifndef WIN32
+   int           s, on;
+   EvalFarm      *farm;
+   Worker        *worker;
+   struct pollfd pfd;
+
+   farm = (EvalFarm *)farmPtr;
+   while (!farm->stop)
+   {
+      pfd.fd      = farm->listener;
+      pfd.events  = POLLIN;
+      pfd.revents = 0;
+      if (poll(&pfd, 1, ACCEPT_POLL_MSEC) <= 0)
+      {
+         continue;
+      }
+      if ((s = accept(farm->listener, NULL, NULL)) == -1)
+      {
+         continue;
+      }
+      on = 1;
+      setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+      worker = new Worker();
+      assert(worker != NULL);
+      worker->farm     = farm;
+      worker->socket   = s;
+      worker->alive    = true;
+      worker->inFlight = 0;
+      if (!openStreams(s, worker->in, worker->out))
+      {
+         close(s);
+         delete worker;
+         continue;
+      }
+      if (!farm->handshake(worker))
+      {
+         FCLOSE(worker->in);
+         FCLOSE(worker->out);
+         delete worker;
+         continue;
+      }
+      if (pthread_mutex_init(&worker->sendMutex, NULL) != 0)
+      {
+         fprintf(stderr, "pthread_mutex_init failed, errno=%d\n", errno);
+         exit(1);
+      }
+      pthread_mutex_lock(&farm->mutex);
+      farm->workers.push_back(worker);
+      pthread_mutex_unlock(&farm->mutex);
+      if (pthread_create(&worker->receiver, NULL, receiveThread, (void *)worker) != 0)
+      {
+         fprintf(stderr, "Cannot create evaluation farm thread\n");
+         exit(1);
+      }
+   }
+#endif
+   return(NULL);
+}
+
+
+// Receive worker replies.
+void *EvalFarm::receiveThread(void *worker)
+{
+   ((Worker *)worker)->farm->receive((Worker *)worker);
+   return(NULL);
+}
+
+
+#endif
+
+// Send handshake: format, network, behaviors and fitness motor list.
+bool EvalFarm::handshake(Worker *worker)
+{
+   int  i, n, format;
+   bool b;
+
+   format = FORMAT;
+   FWRITE_INT(&format, worker->out);
+   network->save(worker->out);
+   n = (int)behaviors.size();
+   FWRITE_INT(&n, worker->out);
+   for (i = 0; i < n; i++)
+   {
+      behaviors[i]->save(worker->out);
+   }
+   n = (int)fitnessMotorList.size();
+   FWRITE_INT(&n, worker->out);
+   for (i = 0; i < n; i++)
+   {
+      b = fitnessMotorList[i];
+      FWRITE_BOOL(&b, worker->out);
+   }
+   fflush(worker->out->fp);
+   return(ferror(worker->out->fp) == 0);
+}
+
+
+// Receive worker replies until disconnected.
+void EvalFarm::receive(Worker *worker)
+{
+   int          i, id, n;
+   float        error;
+   bool         behaves, b;
+   vector<bool> motorErrors;
+   Request      *request;
+   map<int, Request *>::iterator pending;
+
+   while (true)
+   {
+      if ((FREAD_INT(&id, worker->in) != 1) ||
+          (FREAD_FLOAT(&error, worker->in) != 1) ||
+          (FREAD_BOOL(&behaves, worker->in) != 1) ||
+          (FREAD_INT(&n, worker->in) != 1) || (n < 0))
+      {
+         break;
+      }
+      motorErrors.resize(n);
+      for (i = 0; i < n; i++)
+      {
+         if (FREAD_BOOL(&b, worker->in) != 1)
+         {
+            break;
+         }
+         motorErrors[i] = b;
+      }
+      if (i < n)
+      {
+         break;
+      }
+#ifdef THREADS
+      pthread_mutex_lock(&mutex);
+#endif
+      if ((pending = worker->pending.find(id)) != worker->pending.end())
+      {
+         request              = pending->second;
+         request->error       = error;
+         request->behaves     = behaves;
+         request->motorErrors = motorErrors;
+         request->done        = true;
+         worker->pending.erase(pending);
+         worker->inFlight--;
+#ifdef THREADS
+         pthread_cond_broadcast(&replied);
+#endif
+      }
+#ifdef THREADS
+      pthread_mutex_unlock(&mutex);
+#endif
+   }
+#ifdef THREADS
+   pthread_mutex_lock(&mutex);
+#endif
+   drop(worker);
+#ifdef THREADS
+   pthread_mutex_unlock(&mutex);
+#endif
+}
+
+
+// Drop worker: call with farm mutex locked.
+void EvalFarm::drop(Worker *worker)
+{
+   map<int, Request *>::iterator pending;
+
+   if (!worker->alive)
+   {
+      return;
+   }
+   worker->alive = false;
+#ifndef WIN32
+   shutdown(worker->socket, SHUT_RDWR);
+#endif
+   for (pending = worker->pending.begin(); pending != worker->pending.end(); pending++)
+   {
+      pending->second->failed = true;
+      pending->second->done   = true;
+   }
+   worker->pending.clear();
+   worker->inFlight = 0;
+   if (!stop)
+   {
+      lostCount++;
+   }
+#ifdef THREADS
+   pthread_cond_broadcast(&replied);
+#endif
+}
+
+
+// Evaluate network on a worker.
+bool EvalFarm::evaluate(Network *network, vector<Behavior *>& behaviors,
+                        vector<bool>& fitnessMotorList, int maxStep,
+                        float& error, bool& behaves, vector<bool>& motorErrors)
+{
+   int id;
+
+   if ((id = submit(network, behaviors, fitnessMotorList, maxStep,
+                    (int)motorErrors.size())) == -1)
+   {
+#ifdef THREADS
+      pthread_mutex_lock(&mutex);
+#endif
+      localCount++;
+#ifdef THREADS
+      pthread_mutex_unlock(&mutex);
+#endif
+      return(false);
+   }
+   return(collect(id, error, behaves, motorErrors));
+}
+
+
+// Submit network evaluation to the least loaded worker with room.
+int EvalFarm::submit(Network *network, vector<Behavior *>& behaviors,
+                     vector<bool>& fitnessMotorList, int maxStep, int numMotorErrors)
+{
+   int           i, n, id;
+   bool          sent;
+   Worker        *worker;
+   Request       *request;
+   vector<float> weights;
+
+   // Workers evaluate only the farm behaviors and network configuration.
+   if ((behaviors.size() != this->behaviors.size()) ||
+       (fitnessMotorList != this->fitnessMotorList) ||
+       (network->numNeurons != this->network->numNeurons))
+   {
+      return(-1);
+   }
+   for (i = 0, n = (int)behaviors.size(); i < n; i++)
+   {
+      if (behaviors[i] != this->behaviors[i])
+      {
+         return(-1);
+      }
+   }
+
+   // Choose least loaded worker with room.
+#ifdef THREADS
+   pthread_mutex_lock(&mutex);
+#endif
+   worker = NULL;
+   for (i = 0, n = (int)workers.size(); i < n; i++)
+   {
+      if (workers[i]->alive && (workers[i]->inFlight < maxInFlight) &&
+          ((worker == NULL) || (workers[i]->inFlight < worker->inFlight)))
+      {
+         worker = workers[i];
+      }
+   }
+   if (worker == NULL)
+   {
+#ifdef THREADS
+      pthread_mutex_unlock(&mutex);
+#endif
+      return(-1);
+   }
+   request = new Request();
+   assert(request != NULL);
+   id              = nextRequest++;
+   request->worker = worker;
+   request->done   = false;
+   request->failed = false;
+   clock_gettime(CLOCK_REALTIME, &request->deadline);
+   request->deadline.tv_sec += replyTimeout;
+   requests[id]        = request;
+   worker->pending[id] = request;
+   worker->inFlight++;
+#ifdef THREADS
+   pthread_mutex_unlock(&mutex);
+#endif
+
+   // Send request.
+   getWeights(network, weights);
+   n = numMotorErrors;
+#ifdef THREADS
+   pthread_mutex_lock(&worker->sendMutex);
+#endif
+   FWRITE_INT(&id, worker->out);
+   FWRITE_INT(&maxStep, worker->out);
+   FWRITE_INT(&n, worker->out);
+   n = (int)weights.size();
+   FWRITE_INT(&n, worker->out);
+   FWRITE_BYTES((unsigned char *)&weights[0], n * (int)sizeof(float), worker->out);
+   fflush(worker->out->fp);
+   sent = (ferror(worker->out->fp) == 0);
+#ifdef THREADS
+   pthread_mutex_unlock(&worker->sendMutex);
+#endif
+   if (!sent)
+   {
+#ifdef THREADS
+      pthread_mutex_lock(&mutex);
+#endif
+      drop(worker);
+#ifdef THREADS
+      pthread_mutex_unlock(&mutex);
+#endif
+   }
+   return(id);
+}
+
+
+// Collect submitted evaluation.
+// A worker that misses the reply deadline is dropped as hung.
+bool EvalFarm::collect(int id, float& error, bool& behaves, vector<bool>& motorErrors)
+{
+   int     i, n;
+   bool    b, failed;
+   Request *request;
+   map<int, Request *>::iterator pending;
+
+#ifdef THREADS
+   pthread_mutex_lock(&mutex);
+#endif
+   pending = requests.find(id);
+   assert(pending != requests.end());
+   request = pending->second;
+   requests.erase(pending);
+#ifdef THREADS
+   while (!request->done)
+   {
+      if (pthread_cond_timedwait(&replied, &mutex, &request->deadline) == ETIMEDOUT)
+      {
+         if (!request->done)
+         {
+            drop(request->worker);
+         }
+      }
+   }
+#endif
+   if (request->failed)
+   {
+      localCount++;
+   }
+   else
+   {
+      remoteCount++;
+   }
+#ifdef THREADS
+   pthread_mutex_unlock(&mutex);
+#endif
+   failed = request->failed;
+   if (!failed)
+   {
+      error   = request->error;
+      behaves = request->behaves;
+      for (i = 0, n = (int)motorErrors.size(); i < n && i < (int)request->motorErrors.size(); i++)
+      {
+         b = request->motorErrors[i];
+         motorErrors[i] = b;
+      }
+   }
+   delete request;
+   return(!failed);
+}
+
+
+// Statistics since last reset.
+void EvalFarm::getStatistics(unsigned long long& remote, unsigned long long& local,
+                             int& workers, int& lost)
+{
+   int i, n;
+
+#ifdef THREADS
+   pthread_mutex_lock(&mutex);
+#endif
+   remote = remoteCount;
+   local  = localCount;
+   lost   = lostCount;
+   for (i = workers = 0, n = (int)this->workers.size(); i < n; i++)
+   {
+      if (this->workers[i]->alive)
+      {
+         workers++;
+      }
+   }
+#ifdef THREADS
+   pthread_mutex_unlock(&mutex);
+#endif
+}
+
+
+void EvalFarm::resetStatistics()
+{
+#ifdef THREADS
+   pthread_mutex_lock(&mutex);
+#endif
+   remoteCount = localCount = 0;
+   lostCount   = 0;
+#ifdef THREADS
+   pthread_mutex_unlock(&mutex);
+#endif
+}
+
+
+// Network neuron biases and synapse weights.
+void EvalFarm::getWeights(Network *network, vector<float>& weights)
+{
+   int i, j, k, n;
+
+   weights.clear();
+   for (i = network->numSensors; i < network->numNeurons; i++)
+   {
+      weights.push_back(network->neurons[i]->bias);
+   }
+   for (i = 0; i < network->numNeurons; i++)
+   {
+      for (j = 0; j < network->numNeurons; j++)
+      {
+         for (k = 0, n = (int)network->synapses[i][j].size(); k < n; k++)
+         {
+            weights.push_back(network->synapses[i][j][k]->weight);
+         }
+      }
+   }
+}
+
+
+void EvalFarm::setWeights(Network *network, vector<float>& weights)
+{
+   int i, j, k, n, w;
+
+   w = 0;
+   for (i = network->numSensors; i < network->numNeurons; i++)
+   {
+      network->neurons[i]->bias = weights[w++];
+   }
+   for (i = 0; i < network->numNeurons; i++)
+   {
+      for (j = 0; j < network->numNeurons; j++)
+      {
+         for (k = 0, n = (int)network->synapses[i][j].size(); k < n; k++)
+         {
+            network->synapses[i][j][k]->setWeight(weights[w++]);
+         }
+      }
+   }
+}
+
+
+// Open binary read and write streams on socket.
+bool EvalFarm::openStreams(int socket, FilePointer *& in, FilePointer *& out)
+{
+#ifndef WIN32
+   int  s;
+   FILE *fp;
+
+   if ((s = dup(socket)) == -1)
+   {
+      return(false);
+   }
+   if ((fp = fdopen(s, "r")) == NULL)
+   {
+      close(s);
+      return(false);
+   }
+   in = new FilePointer(fp, true);
+   assert(in != NULL);
+   if ((fp = fdopen(socket, "w")) == NULL)
+   {
+      FCLOSE(in);
+      return(false);
+   }
+   out = new FilePointer(fp, true);
+   assert(out != NULL);
+   return(true);
+#else
+   return(false);
+#endif
+}
+
+
+// Worker: evaluate master requests until master disconnects.
+int EvalFarm::work(char *masterAddress)
+{
+#ifndef WIN32
+   int                i, n, s, on, id, maxStep, format, count;
+   bool               b;
+   char               *colon;
+   string             host;
+   FilePointer        *in, *out;
+   Network            *network;
+   vector<Behavior *> behaviors;
+   vector<bool>       fitnessMotorList;
+   vector<float>      weights;
+   BehaviorTrie       *behaviorTrie;
+   NetworkMorph       morph;
+   struct addrinfo    hints, *info, *p;
+
+   if ((colon = strrchr(masterAddress, ':')) == NULL)
+   {
+      fprintf(stderr, "Invalid master address %s\n", masterAddress);
+      return(1);
+   }
+   signal(SIGPIPE, SIG_IGN);
+
+   // Connect to master.
+   host.assign(masterAddress, colon - masterAddress);
+   s = -1;
+   for (i = 0; i < CONNECT_ATTEMPTS && s == -1; i++)
+   {
+      memset(&hints, 0, sizeof(hints));
+      hints.ai_family   = AF_UNSPEC;
+      hints.ai_socktype = SOCK_STREAM;
+      if (getaddrinfo(host.c_str(), colon + 1, &hints, &info) == 0)
+      {
+         for (p = info; p != NULL && s == -1; p = p->ai_next)
+         {
+            if ((s = socket(p->ai_family, p->ai_socktype, p->ai_protocol)) == -1)
+            {
+               continue;
+            }
+            if (connect(s, p->ai_addr, p->ai_addrlen) == -1)
+            {
+               close(s);
+               s = -1;
+            }
+         }
+         freeaddrinfo(info);
+      }
+      if (s == -1)
+      {
+         usleep(CONNECT_RETRY_USEC);
+      }
+   }
+   if (s == -1)
+   {
+      fprintf(stderr, "Cannot connect to master %s\n", masterAddress);
+      return(1);
+   }
+   on = 1;
+   setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+   if (!openStreams(s, in, out))
+   {
+      fprintf(stderr, "Cannot open connection to master %s\n", masterAddress);
+      close(s);
+      return(1);
+   }
+
+   // Handshake.
+   format = -1;
+   FREAD_INT(&format, in);
+   if (format != FORMAT)
+   {
+      fprintf(stderr, "Master protocol format %d is incompatible with expected format %d\n",
+              format, FORMAT);
+      FCLOSE(in);
+      FCLOSE(out);
+      return(1);
+   }
+   network = new Network(in);
+   assert(network != NULL);
+   FREAD_INT(&n, in);
+   for (i = 0; i < n; i++)
+   {
+      behaviors.push_back(new Behavior(in));
+      assert(behaviors[i] != NULL);
+   }
+   FREAD_INT(&n, in);
+   for (i = 0; i < n; i++)
+   {
+      FREAD_BOOL(&b, in);
+      fitnessMotorList.push_back(b);
+   }
+   if (ferror(in->fp) || feof(in->fp))
+   {
+      fprintf(stderr, "Cannot receive handshake from master %s\n", masterAddress);
+      FCLOSE(in);
+      FCLOSE(out);
+      return(1);
+   }
+   behaviorTrie = new BehaviorTrie(behaviors);
+   assert(behaviorTrie != NULL);
+   morph.network = network;
+   getWeights(network, weights);
+   printf("Evaluation worker connected to %s\n", masterAddress);
+   fflush(stdout);
+
+   // Evaluate requests.
+   for (count = 0; ; count++)
+   {
+      if ((FREAD_INT(&id, in) != 1) ||
+          (FREAD_INT(&maxStep, in) != 1) ||
+          (FREAD_INT(&n, in) != 1) || (n < 0))
+      {
+         break;
+      }
+      morph.motorErrors.assign(n, false);
+      if ((FREAD_INT(&n, in) != 1) || (n < 0))
+      {
+         break;
+      }
+      if (n != (int)weights.size())
+      {
+         fprintf(stderr, "Request has %d weights, expected %d\n", n, (int)weights.size());
+         break;
+      }
+      if ((n > 0) && (FREAD_BYTES((unsigned char *)&weights[0], n * (int)sizeof(float), in) != 1))
+      {
+         break;
+      }
+      setWeights(network, weights);
+      morph.evaluate(behaviors, fitnessMotorList, maxStep, behaviorTrie);
+      FWRITE_INT(&id, out);
+      FWRITE_FLOAT(&morph.error, out);
+      FWRITE_BOOL(&morph.behaves, out);
+      n = (int)morph.motorErrors.size();
+      FWRITE_INT(&n, out);
+      for (i = 0; i < n; i++)
+      {
+         b = morph.motorErrors[i];
+         FWRITE_BOOL(&b, out);
+      }
+      fflush(out->fp);
+      if (ferror(out->fp))
+      {
+         break;
+      }
+   }
+   printf("Evaluation worker disconnected after %d evaluations\n", count);
+   FCLOSE(in);
+   FCLOSE(out);
+   delete behaviorTrie;
+   for (i = 0, n = (int)behaviors.size(); i < n; i++)
+   {
+      delete behaviors[i];
+   }
+   morph.network = NULL;
+   delete network;
+   return(0);
+#else
+   fprintf(stderr, "Evaluation worker is not supported on Windows\n");
+   return(1);
+#endif
+}
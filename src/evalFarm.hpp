@@ -0,0 +1,154 @@
+// Distributed fitness evaluation farm.
+// A morph master accepts evaluation workers (bionet -evalWorker) on a TCP port.
+// At handshake the master sends the homomorph network, behaviors and fitness
+// motor list; each request then carries only the neuron biases and synapse
+// weights of the network to evaluate, and the reply carries the error,
+// behaves flag and motor errors. Requests are submitted asynchronously and
+// collected later, so a morph thread can keep several requests in flight.
+// Each worker has a bounded number of requests in flight. When no worker can
+// take a request, or a worker is lost or misses its reply deadline, the
+// evaluation falls back to the calling thread.
+
+#ifndef __EVAL_FARM_HPP__
+#define __EVAL_FARM_HPP__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <time.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <atomic>
+#include "network.hpp"
+#include "behavior.hpp"
+#include "fileio.h"
+#ifdef THREADS
+#include <pthread.h>
+#endif
+using namespace std;
+
+class EvalFarm
+{
+public:
+
+   // Protocol format.
+   enum { FORMAT = 1 };
+
+   // Default maximum requests in flight per worker.
+   enum { DEFAULT_MAX_IN_FLIGHT = 4 };
+
+   // Default seconds a worker has to reply before it is dropped.
+   enum { DEFAULT_REPLY_TIMEOUT = 60 };
+
+   // Constructor.
+   EvalFarm(int port, int maxInFlight, int replyTimeout, Network *network,
+            vector<Behavior *>& behaviors, vector<bool>& fitnessMotorList);
+
+   // Destructor: disconnects workers.
+   ~EvalFarm();
+
+   // Listen for workers.
+   bool listen();
+
+   // Evaluate network on a worker.
+   // Returns false if no worker took the evaluation.
+   bool evaluate(Network *network, vector<Behavior *>& behaviors,
+                 vector<bool>& fitnessMotorList, int maxStep,
+                 float& error, bool& behaves, vector<bool>& motorErrors);
+
+   // Submit network evaluation to a worker without waiting for the reply.
+   // Returns request id, or -1 if no worker took the evaluation.
+   int submit(Network *network, vector<Behavior *>& behaviors,
+              vector<bool>& fitnessMotorList, int maxStep, int numMotorErrors);
+
+   // Collect submitted evaluation, waiting until its reply deadline.
+   // Returns false if the evaluation failed and must be done locally.
+   bool collect(int id, float& error, bool& behaves, vector<bool>& motorErrors);
+
+   // Statistics since last reset: remote and local evaluations,
+   // connected and lost workers.
+   void getStatistics(unsigned long long& remote, unsigned long long& local,
+                      int& workers, int& lost);
+   void resetStatistics();
+
+   // Worker: evaluate master requests until master disconnects.
+   static int work(char *masterAddress);
+
+private:
+
+   int                port;
+   int                maxInFlight;
+   int                replyTimeout;
+   Network            *network;
+   vector<Behavior *> behaviors;
+   vector<bool>       fitnessMotorList;
+
+   class Worker;
+
+   // Pending request.
+   class Request
+   {
+   public:
+      Worker          *worker;
+      struct timespec deadline;
+      bool            done;
+      bool            failed;
+      float           error;
+      bool            behaves;
+      vector<bool>    motorErrors;
+   };
+
+   // Connected worker.
+   class Worker
+   {
+   public:
+      EvalFarm          *farm;
+      int               socket;
+      FilePointer       *in, *out;
+      bool              alive;
+      int               inFlight;
+      map<int, Request *> pending;
+#ifdef THREADS
+      pthread_mutex_t sendMutex;
+      pthread_t       receiver;
+#endif
+   };
+   vector<Worker *>    workers;
+   map<int, Request *> requests;
+   int                 nextRequest;
+   int                 listener;
+   atomic<bool>        stop;
+
+   // Statistics.
+   unsigned long long remoteCount, localCount;
+   int                lostCount;
+
+#ifdef THREADS
+   pthread_mutex_t mutex;
+   pthread_cond_t  replied;
+   pthread_t       acceptor;
+   bool            accepting;
+   static void *acceptThread(void *farm);
+   static void *receiveThread(void *worker);
+#endif
+
+   // Send handshake to new worker.
+   bool handshake(Worker *worker);
+
+   // Receive worker replies.
+   void receive(Worker *worker);
+
+   // Drop worker, failing its pending requests.
+   void drop(Worker *worker);
+
+   // Network neuron biases and synapse weights.
+   static void getWeights(Network *network, vector<float>& weights);
+   static void setWeights(Network *network, vector<float>& weights);
+
+   // Open socket streams.
+   static bool openStreams(int socket, FilePointer *& in, FilePointer *& out);
+};
+#endif
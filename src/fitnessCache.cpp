@@ -0,0 +1,188 @@
+// Fitness cache implementation.
+
+#include "fitnessCache.hpp"
+
+// Constructor.
+FitnessCache::FitnessCache(int size)
+{
+   int i;
+
+   assert(size > 0);
+   entries.resize(size);
+   for (i = 0; i < NUM_STRIPES; i++)
+   {
+      lookups[i] = hits[i] = 0;
+#ifdef THREADS
+      if (pthread_mutex_init(&locks[i], NULL) != 0)
+      {
+         fprintf(stderr, "pthread_mutex_init failed, errno=%d\n", errno);
+         exit(1);
+      }
+#endif
+   }
+}
+
+
+// Destructor.
+FitnessCache::~FitnessCache()
+{
+#ifdef THREADS
+   for (int i = 0; i < NUM_STRIPES; i++)
+   {
+      pthread_mutex_destroy(&locks[i]);
+   }
+#endif
+   entries.clear();
+}
+
+
+// Key constructor.
+FitnessCache::Key::Key(int context)
+{
+   hash1 = 0xcbf29ce484222325ULL;
+   hash2 = 0x9e3779b97f4a7c15ULL;
+   add((unsigned long long)context);
+}
+
+
+// Add value to key.
+// FNV-1a and a multiply-xorshift mix give independent hashes.
+void FitnessCache::Key::add(unsigned long long value)
+{
+   int i;
+
+   for (i = 0; i < 8; i++)
+   {
+      hash1 ^= (value >> (i * 8)) & 0xffULL;
+      hash1 *= 0x100000001b3ULL;
+   }
+   hash2 ^= value + 0x9e3779b97f4a7c15ULL + (hash2 << 6) + (hash2 >> 2);
+   hash2 *= 0xbf58476d1ce4e5b9ULL;
+   hash2 ^= (hash2 >> 31);
+}
+
+
+void FitnessCache::Key::add(float value)
+{
+   unsigned int bits;
+
+   memcpy(&bits, &value, sizeof(bits));
+   add((unsigned long long)bits);
+}
+
+
+void FitnessCache::Key::add(void *pointer)
+{
+   add((unsigned long long)pointer);
+}
+
+
+// Add network: structure, neuron biases and synapse weights.
+// Sensor biases are inputs and are excluded.
+void FitnessCache::Key::add(Network *network)
+{
+   int     i, j, k, n;
+   Neuron  *neuron;
+   Synapse *synapse;
+
+   add((unsigned long long)network->numNeurons);
+   add((unsigned long long)network->numSensors);
+   add((unsigned long long)network->numMotors);
+   for (i = 0; i < network->numNeurons; i++)
+   {
+      neuron = network->neurons[i];
+      add((unsigned long long)(neuron->excitatory ? 1 : 0));
+      add((unsigned long long)neuron->function);
+      if (i >= network->numSensors)
+      {
+         add(neuron->bias);
+      }
+   }
+   for (i = 0; i < network->numNeurons; i++)
+   {
+      for (j = 0; j < network->numNeurons; j++)
+      {
+         n = (int)network->synapses[i][j].size();
+         if (n > 0)
+         {
+            add((unsigned long long)i);
+            add((unsigned long long)j);
+            add((unsigned long long)n);
+            for (k = 0; k < n; k++)
+            {
+               synapse = network->synapses[i][j][k];
+               add(synapse->weight);
+               add((unsigned long long)synapse->type);
+            }
+         }
+      }
+   }
+}
+
+
+// Look up value.
+bool FitnessCache::lookup(Key& key, Value& value)
+{
+   int  i, s;
+   bool found;
+
+   i = (int)(key.hash1 % (unsigned long long)entries.size());
+   s = i % NUM_STRIPES;
+#ifdef THREADS
+   pthread_mutex_lock(&locks[s]);
+#endif
+   lookups[s]++;
+   found = false;
+   if (entries[i].valid &&
+       (entries[i].key.hash1 == key.hash1) &&
+       (entries[i].key.hash2 == key.hash2))
+   {
+      value = entries[i].value;
+      found = true;
+      hits[s]++;
+   }
+#ifdef THREADS
+   pthread_mutex_unlock(&locks[s]);
+#endif
+   return(found);
+}
+
+
+// Insert value, replacing existing entry in slot.
+void FitnessCache::insert(Key& key, Value& value)
+{
+   int i, s;
+
+   i = (int)(key.hash1 % (unsigned long long)entries.size());
+   s = i % NUM_STRIPES;
+#ifdef THREADS
+   pthread_mutex_lock(&locks[s]);
+#endif
+   entries[i].valid = true;
+   entries[i].key   = key;
+   entries[i].value = value;
+#ifdef THREADS
+   pthread_mutex_unlock(&locks[s]);
+#endif
+}
+
+
+// Statistics since last reset.
+void FitnessCache::getStatistics(unsigned long long& lookups, unsigned long long& hits)
+{
+   lookups = hits = 0;
+   for (int i = 0; i < NUM_STRIPES; i++)
+   {
+      lookups += this->lookups[i];
+      hits    += this->hits[i];
+   }
+}
+
+
+void FitnessCache::resetStatistics()
+{
+   for (int i = 0; i < NUM_STRIPES; i++)
+   {
+      lookups[i] = hits[i] = 0;
+   }
+}
@@ -0,0 +1,80 @@
+// Fitness cache.
+// Evaluation results keyed by a hash of the network weights and evaluation context,
+// shared by all morph threads.
+
+#ifndef __FITNESS_CACHE_HPP__
+#define __FITNESS_CACHE_HPP__
+
+#include "network.hpp"
+#ifdef THREADS
+#include <pthread.h>
+#endif
+
+class FitnessCache
+{
+public:
+
+   // Constructor.
+   FitnessCache(int size);
+
+   // Destructor.
+   ~FitnessCache();
+
+   // Cache key: two independent 64-bit hashes.
+   class Key
+   {
+   public:
+      unsigned long long hash1;
+      unsigned long long hash2;
+
+      Key(int context);
+      void add(unsigned long long value);
+      void add(float value);
+      void add(void *pointer);
+
+      // Add network: structure, neuron biases and synapse weights.
+      void add(Network *network);
+   };
+
+   // Cached evaluation.
+   class Value
+   {
+   public:
+      float        error;
+      float        fitness;
+      bool         behaves;
+      vector<bool> motorErrors;
+   };
+
+   // Look up value.
+   bool lookup(Key& key, Value& value);
+
+   // Insert value, replacing existing entry in slot.
+   void insert(Key& key, Value& value);
+
+   // Statistics since last reset.
+   void getStatistics(unsigned long long& lookups, unsigned long long& hits);
+   void resetStatistics();
+
+private:
+
+   class Entry
+   {
+   public:
+      bool  valid;
+      Key   key;
+      Value value;
+
+      Entry() : key(0) { valid = false; }
+   };
+   vector<Entry> entries;
+
+   // Entries are locked in stripes.
+   enum { NUM_STRIPES = 64 };
+   unsigned long long lookups[NUM_STRIPES];
+   unsigned long long hits[NUM_STRIPES];
+#ifdef THREADS
+   pthread_mutex_t    locks[NUM_STRIPES];
+#endif
+};
+#endif
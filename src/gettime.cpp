@@ -1,5 +1,6 @@
 /*
  * Get time in milliseconds since the initial call.
+ * Get time in microseconds for measuring short intervals.
  */
 
 #include "gettime.h"
@@ -40,3 +41,18 @@ TIME gettime()
    }
 #endif
 }
+
+
+TIME getmicrotime()
+{
+#ifdef WIN32
+   LARGE_INTEGER count, frequency;
+   QueryPerformanceCounter(&count);
+   QueryPerformanceFrequency(&frequency);
+   return((TIME)((count.QuadPart * 1000000) / frequency.QuadPart));
+#else
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return(((TIME)tv.tv_sec * 1000000) + (TIME)tv.tv_usec);
+#endif
+}
@@ -1,5 +1,6 @@
 /*
  * Get time in milliseconds since the initial call.
+ * Get time in microseconds for measuring short intervals.
  */
 
 #ifdef WIN32
@@ -13,3 +14,4 @@
 typedef unsigned long long   TIME;
 #define INVALID_TIME    ((unsigned long long)(-1))
 TIME gettime();
+TIME getmicrotime();
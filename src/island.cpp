@@ -0,0 +1,571 @@
+// Island model migration transport implementation.
+
+#include "island.hpp"
+#ifndef WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#endif
+
+// Connection attempts while target island starts up.
+#define CONNECT_ATTEMPTS    50
+#define CONNECT_RETRY_USEC  100000
+
+// Seconds to wait for rest of an accepted message.
+#define RECEIVE_TIMEOUT     10
+
+// Milliseconds between receiver checks for stop.
+#define RECEIVE_POLL_MSEC   100
+
+// Constructor.
+Island::Island(int index, vector<string>& addresses, TOPOLOGY topology,
+               int migrationInterval, int numMigrants)
+{
+#ifdef WIN32
+   fprintf(stderr, "Island migration is not supported on Windows\n");
+   exit(1);
+#endif
+   assert(index >= 0 && index < (int)addresses.size());
+   this->index             = index;
+   this->addresses         = addresses;
+   this->topology          = topology;
+   this->migrationInterval = migrationInterval;
+   this->numMigrants       = numMigrants;
+   listener   = -1;
+   sendIsland = -1;
+   sending    = delivering = false;
+   sent       = received = lost = 0;
+#ifdef THREADS
+   receiving = stop = false;
+   if (pthread_mutex_init(&mutex, NULL) != 0)
+   {
+      fprintf(stderr, "pthread_mutex_init failed, errno=%d\n", errno);
+      exit(1);
+   }
+#endif
+}
+
+
+// Destructor.
+Island::~Island()
+{
+   wait();
+#ifdef THREADS
+   if (receiving)
+   {
+      lock();
+      stop = true;
+      unlock();
+      pthread_join(receiver, NULL);
+   }
+   pthread_mutex_destroy(&mutex);
+#endif
+#ifndef WIN32
+   if (listener != -1)
+   {
+      close(listener);
+      if (addresses[index].find(':') == string::npos)
+      {
+         unlink(addresses[index].c_str());
+      }
+   }
+#endif
+}
+
+
+// Listen for migrants.
+bool Island::listen()
+{
+   if ((listener = bindTo(addresses[index])) == -1)
+   {
+      fprintf(stderr, "Cannot listen on island address %s\n", addresses[index].c_str());
+      return(false);
+   }
+#ifdef THREADS
+   if (pthread_create(&receiver, NULL, receiverThread, (void *)this) != 0)
+   {
+      fprintf(stderr, "Cannot create island receiver thread\n");
+      exit(1);
+   }
+   receiving = true;
+#endif
+   return(true);
+}
+
+
+// Target island for generation migration.
+int Island::target(int generation, RANDOM randomSeed)
+{
+   int    n, t;
+   Random random;
+
+   n = (int)addresses.size();
+   if (topology == RING)
+   {
+      return((index + 1) % n);
+   }
+
+   // Random target depends only on seed, generation and island.
+   random.SRAND_STREAM(randomSeed, (RANDOM)generation, (RANDOM)index);
+   t = random.RAND_CHOICE(n - 1);
+   if (t >= index)
+   {
+      t++;
+   }
+   return(t);
+}
+
+
+// Island random seed derived from morph seed and island index.
+RANDOM Island::seed(RANDOM randomSeed, int index)
+{
+   Random random;
+
+   random.SRAND_STREAM(randomSeed, (RANDOM)index, 0);
+   return(random.RAND());
+}
+
+
+// Send message to island.
+// A message sent while the previous one is being delivered, or that is
+// too long, is dropped.
+void Island::send(int island, vector<unsigned char>& message)
+{
+   unsigned int header[2];
+   bool         drop;
+
+   lock();
+   drop = delivering || (message.size() > (size_t)MAX_MESSAGE_LENGTH);
+   if (drop)
+   {
+      lost++;
+   }
+   unlock();
+   if (drop)
+   {
+      return;
+   }
+   wait();
+   header[0] = htonl((unsigned int)message.size());
+   header[1] = htonl(message.size() > 0 ? checksum(&message[0], (int)message.size()) : 0);
+   sendIsland = island;
+   sendMessage.resize(HEADER_LENGTH + message.size());
+   memcpy(&sendMessage[0], header, HEADER_LENGTH);
+   if (message.size() > 0)
+   {
+      memcpy(&sendMessage[HEADER_LENGTH], &message[0], message.size());
+   }
+   sending    = true;
+   delivering = true;
+#ifdef THREADS
+   if (pthread_create(&sender, NULL, senderThread, (void *)this) != 0)
+   {
+      fprintf(stderr, "Cannot create island sender thread\n");
+      exit(1);
+   }
+#else
+   deliver();
+#endif
+}
+
+
+#ifdef THREADS
+// Sender thread.
+void *Island::senderThread(void *island)
+{
+   ((Island *)island)->deliver();
+   return(NULL);
+}
+
+
+// Receiver thread: accept messages into inbox until stopped.
+void *Island::receiverThread(void *arg)
+{
+   Island                *island = (Island *)arg;
+   struct pollfd         ready;
+   vector<unsigned char> message;
+
+   while (true)
+   {
+      island->lock();
+      if (island->stop)
+      {
+         island->unlock();
+         break;
+      }
+      island->unlock();
+      ready.fd      = island->listener;
+      ready.events  = POLLIN;
+      ready.revents = 0;
+      if (poll(&ready, 1, RECEIVE_POLL_MSEC) <= 0)
+      {
+         continue;
+      }
+      while (island->acceptMessage(message) != -1)
+      {
+         if (message.size() > 0)
+         {
+            island->lock();
+            island->inbox.push_back(message);
+            island->received++;
+            island->unlock();
+         }
+      }
+   }
+   return(NULL);
+}
+
+
+#endif
+
+// Deliver pending message.
+void Island::deliver()
+{
+#ifndef WIN32
+   int  s, i, n, w, flags;
+   bool delivered;
+
+   s = -1;
+   for (i = 0; i < CONNECT_ATTEMPTS && s == -1; i++)
+   {
+      if ((s = connectTo(addresses[sendIsland])) == -1)
+      {
+         usleep(CONNECT_RETRY_USEC);
+      }
+   }
+   delivered = false;
+   if (s != -1)
+   {
+#ifdef MSG_NOSIGNAL
+      flags = MSG_NOSIGNAL;
+#else
+      flags = 0;
+#endif
+      n = (int)sendMessage.size();
+      for (i = 0; i < n; i += w)
+      {
+         if ((w = (int)::send(s, &sendMessage[i], n - i, flags)) <= 0)
+         {
+            break;
+         }
+      }
+      delivered = (i == n);
+      close(s);
+   }
+   lock();
+   if (delivered)
+   {
+      sent++;
+   }
+   else
+   {
+      lost++;
+   }
+   delivering = false;
+   unlock();
+#endif
+}
+
+
+// Wait for pending send.
+void Island::wait()
+{
+   if (sending)
+   {
+#ifdef THREADS
+      pthread_join(sender, NULL);
+#endif
+      sending = false;
+   }
+}
+
+
+// Receive pending message.
+bool Island::receive(vector<unsigned char>& message)
+{
+   message.clear();
+#ifdef THREADS
+   if (!receiving)
+   {
+      return(false);
+   }
+   lock();
+   if (inbox.size() == 0)
+   {
+      unlock();
+      return(false);
+   }
+   message.swap(inbox.front());
+   inbox.pop_front();
+   unlock();
+   return(true);
+
+#else
+   while (acceptMessage(message) != -1)
+   {
+      if (message.size() > 0)
+      {
+         received++;
+         return(true);
+      }
+   }
+   return(false);
+#endif
+}
+
+
+// Accept pending connection and read its framed message.
+// A discarded message is returned empty.
+int Island::acceptMessage(vector<unsigned char>& message)
+{
+#ifndef WIN32
+   int            s, length;
+   unsigned int   header[2];
+   unsigned char  extra;
+   bool           valid;
+   struct timeval timeout;
+
+   message.clear();
+   if (listener == -1)
+   {
+      return(-1);
+   }
+   while ((s = accept(listener, NULL, NULL)) == -1)
+   {
+      if (errno != EINTR)
+      {
+         return(-1);
+      }
+   }
+
+   // Accepted sockets may inherit non-blocking mode.
+   fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) & ~O_NONBLOCK);
+   timeout.tv_sec  = RECEIVE_TIMEOUT;
+   timeout.tv_usec = 0;
+   setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+   // Message must have its framed length and checksum, and end there.
+   valid = false;
+   if (readFully(s, (unsigned char *)header, HEADER_LENGTH))
+   {
+      length = (int)ntohl(header[0]);
+      if ((length > 0) && (length <= MAX_MESSAGE_LENGTH))
+      {
+         message.resize(length);
+         if (readFully(s, &message[0], length) &&
+             (recv(s, &extra, 1, 0) == 0) &&
+             (checksum(&message[0], length) == ntohl(header[1])))
+         {
+            valid = true;
+         }
+      }
+   }
+   close(s);
+   if (!valid)
+   {
+      message.clear();
+      return(0);
+   }
+   return(1);
+
+#else
+   return(-1);
+#endif
+}
+
+
+// Read length bytes from socket.
+bool Island::readFully(int s, unsigned char *buffer, int length)
+{
+#ifndef WIN32
+   int i, r;
+
+   for (i = 0; i < length; i += r)
+   {
+      if ((r = (int)recv(s, &buffer[i], length - i, 0)) <= 0)
+      {
+         return(false);
+      }
+   }
+   return(true);
+
+#else
+   return(false);
+#endif
+}
+
+
+// Message checksum: 32-bit FNV-1a hash.
+unsigned int Island::checksum(const unsigned char *data, int length)
+{
+   unsigned int hash = 2166136261u;
+
+   for (int i = 0; i < length; i++)
+   {
+      hash ^= data[i];
+      hash *= 16777619u;
+   }
+   return(hash);
+}
+
+
+// Statistics.
+void Island::getStatistics(int& sent, int& received, int& lost)
+{
+   lock();
+   sent     = this->sent;
+   received = this->received;
+   lost     = this->lost;
+   unlock();
+}
+
+
+void Island::lock()
+{
+#ifdef THREADS
+   pthread_mutex_lock(&mutex);
+#endif
+}
+
+
+void Island::unlock()
+{
+#ifdef THREADS
+   pthread_mutex_unlock(&mutex);
+#endif
+}
+
+
+// Connect to island address.
+int Island::connectTo(string& address)
+{
+#ifndef WIN32
+   int                s;
+   size_t             colon;
+   string             host, port;
+   struct addrinfo    hints, *info, *p;
+   struct sockaddr_un unixAddress;
+
+   if ((colon = address.rfind(':')) == string::npos)
+   {
+      if ((s = socket(AF_UNIX, SOCK_STREAM, 0)) == -1)
+      {
+         return(-1);
+      }
+      memset(&unixAddress, 0, sizeof(unixAddress));
+      unixAddress.sun_family = AF_UNIX;
+      strncpy(unixAddress.sun_path, address.c_str(), sizeof(unixAddress.sun_path) - 1);
+      if (connect(s, (struct sockaddr *)&unixAddress, sizeof(unixAddress)) == -1)
+      {
+         close(s);
+         return(-1);
+      }
+      return(s);
+   }
+   host = address.substr(0, colon);
+   port = address.substr(colon + 1);
+   memset(&hints, 0, sizeof(hints));
+   hints.ai_family   = AF_UNSPEC;
+   hints.ai_socktype = SOCK_STREAM;
+   if (getaddrinfo(host.c_str(), port.c_str(), &hints, &info) != 0)
+   {
+      return(-1);
+   }
+   s = -1;
+   for (p = info; p != NULL && s == -1; p = p->ai_next)
+   {
+      if ((s = socket(p->ai_family, p->ai_socktype, p->ai_protocol)) == -1)
+      {
+         continue;
+      }
+      if (connect(s, p->ai_addr, p->ai_addrlen) == -1)
+      {
+         close(s);
+         s = -1;
+      }
+   }
+   freeaddrinfo(info);
+   return(s);
+#else
+   return(-1);
+#endif
+}
+
+
+// Bind non-blocking listening socket to address.
+int Island::bindTo(string& address)
+{
+#ifndef WIN32
+   int                s, on;
+   size_t             colon;
+   string             port;
+   struct addrinfo    hints, *info, *p;
+   struct sockaddr_un unixAddress;
+
+   if ((colon = address.rfind(':')) == string::npos)
+   {
+      if ((s = socket(AF_UNIX, SOCK_STREAM, 0)) == -1)
+      {
+         return(-1);
+      }
+      unlink(address.c_str());
+      memset(&unixAddress, 0, sizeof(unixAddress));
+      unixAddress.sun_family = AF_UNIX;
+      strncpy(unixAddress.sun_path, address.c_str(), sizeof(unixAddress.sun_path) - 1);
+      if (bind(s, (struct sockaddr *)&unixAddress, sizeof(unixAddress)) == -1)
+      {
+         close(s);
+         return(-1);
+      }
+   }
+   else
+   {
+      // Listen on all interfaces at address port.
+      port = address.substr(colon + 1);
+      memset(&hints, 0, sizeof(hints));
+      hints.ai_family   = AF_INET;
+      hints.ai_socktype = SOCK_STREAM;
+      hints.ai_flags    = AI_PASSIVE;
+      if (getaddrinfo(NULL, port.c_str(), &hints, &info) != 0)
+      {
+         return(-1);
+      }
+      s = -1;
+      for (p = info; p != NULL && s == -1; p = p->ai_next)
+      {
+         if ((s = socket(p->ai_family, p->ai_socktype, p->ai_protocol)) == -1)
+         {
+            continue;
+         }
+         on = 1;
+         setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+         if (bind(s, p->ai_addr, p->ai_addrlen) == -1)
+         {
+            close(s);
+            s = -1;
+         }
+      }
+      freeaddrinfo(info);
+      if (s == -1)
+      {
+         return(-1);
+      }
+   }
+   if (::listen(s, SOMAXCONN) == -1)
+   {
+      close(s);
+      return(-1);
+   }
+   fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+   return(s);
+#else
+   return(-1);
+#endif
+}
@@ -0,0 +1,119 @@
+// Island model migration transport.
+// Each island is a bionet process evolving its own population. Every
+// migration interval an island sends its top members to a target island
+// and takes in any migrants that have arrived from other islands.
+// Island addresses are "host:port" for TCP or a path for a Unix socket.
+// Messages are framed by their length and checksum, and a message whose
+// size or checksum does not match is discarded. Messages are sent and
+// received by background threads so that islands never block on each
+// other: a message sent while the previous one is still being delivered
+// is dropped, and received messages wait in an inbox.
+
+#ifndef __ISLAND_HPP__
+#define __ISLAND_HPP__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include "random.hpp"
+#ifdef THREADS
+#include <pthread.h>
+#endif
+using namespace std;
+
+class Island
+{
+public:
+
+   // Migration topology.
+   enum TOPOLOGY { RING, RANDOM_ISLAND };
+
+   // Constructor.
+   Island(int index, vector<string>& addresses, TOPOLOGY topology,
+          int migrationInterval, int numMigrants);
+
+   // Destructor: waits for pending send and stops receiving.
+   ~Island();
+
+   // Island index and addresses.
+   int            index;
+   vector<string> addresses;
+
+   // Migration parameters.
+   TOPOLOGY topology;
+   int      migrationInterval;
+   int      numMigrants;
+
+   // Listen for migrants.
+   bool listen();
+
+   // Target island for generation migration.
+   int target(int generation, RANDOM randomSeed);
+
+   // Island random seed derived from morph seed and island index.
+   static RANDOM seed(RANDOM randomSeed, int index);
+
+   // Send message to island without waiting.
+   void send(int island, vector<unsigned char>& message);
+
+   // Receive pending message without waiting, returning false if none.
+   bool receive(vector<unsigned char>& message);
+
+   // Statistics: messages sent, received, and undeliverable or dropped.
+   // Truncated or corrupt messages are discarded and not counted.
+   void getStatistics(int& sent, int& received, int& lost);
+
+   // Maximum message length.
+   enum { MAX_MESSAGE_LENGTH = 1 << 28 };
+
+private:
+
+   int listener;
+
+   // Pending framed message, delivered by sender thread.
+   int                   sendIsland;
+   vector<unsigned char> sendMessage;
+   bool                  sending;
+   bool                  delivering;
+   void deliver();
+   void wait();
+
+   // Received messages.
+   deque<vector<unsigned char> > inbox;
+
+   // Accept pending connection and read its message: returns -1 if none
+   // is pending, 0 if the message is discarded, and 1 if read.
+   int acceptMessage(vector<unsigned char>& message);
+   bool readFully(int s, unsigned char *buffer, int length);
+
+   // Message frame header: length and checksum, in network byte order.
+   enum { HEADER_LENGTH = 8 };
+   static unsigned int checksum(const unsigned char *data, int length);
+
+#ifdef THREADS
+   pthread_t       sender;
+   pthread_t       receiver;
+   bool            receiving;
+   bool            stop;
+   pthread_mutex_t mutex;
+   static void *senderThread(void *island);
+   static void *receiverThread(void *island);
+#endif
+   void lock();
+   void unlock();
+
+   // Statistics.
+   int sent, received, lost;
+
+   // Connect to island address, returning socket or -1.
+   int connectTo(string& address);
+
+   // Bind listening socket to address, returning socket or -1.
+   int bindTo(string& address);
+};
+#endif
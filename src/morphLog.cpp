@@ -0,0 +1,621 @@
+// Morph log writer implementation.
+
+#include "morphLog.hpp"
+#ifdef THREADS
+#include <sys/time.h>
+#endif
+
+// Minimum thread buffer size (bytes).
+#define MIN_RING_SIZE         (4 * BUFSIZ)
+
+// Milliseconds between writer passes when not woken.
+#define WRITE_INTERVAL_MSEC   100
+
+// Binary log record size and text alignment.
+#define EVENT_SIZE            ((int)sizeof(MorphEvent))
+#define TEXT_ALIGN            8
+
+// Binary log file identifier.
+const char *MorphLog::MAGIC = "BIONETML";
+
+// CSV header.
+const char *MorphEvent::CSV_HEADER =
+   "time,generation,type,member,tag,parent1,parent2,error,meanError,fitness,"
+   "replacementError,replacementMeanError,replacementFitness";
+
+// Event type names.
+static const char *EVENT_TYPE_NAMES[] =
+{
+   "text", "population", "mate", "mutate", "optimize", "prune", "replace", "steady", "migrate"
+};
+
+// Constructor.
+MorphEvent::MorphEvent()
+{
+   memset((void *)this, 0, sizeof(MorphEvent));
+   parent1 = parent2 = -1;
+}
+
+
+// Format member value.
+static void formatValue(string& text, int value, float error, float meanError, float fitness)
+{
+   char buf[BUFSIZ];
+
+   switch (value)
+   {
+   case MorphEvent::FITNESS_VALUE:
+      sprintf(buf, "%f", fitness);
+      break;
+
+   case MorphEvent::MEAN_ERROR_VALUE:
+      sprintf(buf, "%.2f (%.2f)", error, meanError);
+      break;
+
+   default:
+      sprintf(buf, "%f", error);
+      break;
+   }
+   text += buf;
+}
+
+
+// Format as morph log text.
+string MorphEvent::format()
+{
+   char   buf[BUFSIZ];
+   string text;
+
+   sprintf(buf, "%d\t%d\t\t", member, tag);
+   text = buf;
+   formatValue(text, value, error, meanError, fitness);
+   if (type == REPLACE)
+   {
+      text += "\t";
+      formatValue(text, value, replacementError, replacementMeanError, replacementFitness);
+   }
+   else if (parent1 != -1)
+   {
+      sprintf(buf, "\t%d", parent1);
+      text += buf;
+      if (parent2 != -1)
+      {
+         sprintf(buf, " %d", parent2);
+         text += buf;
+      }
+   }
+   text += "\n";
+   return(text);
+}
+
+
+// Format as CSV line.
+string MorphEvent::formatCSV()
+{
+   char buf[BUFSIZ];
+
+   sprintf(buf, "%llu,%d,%s,%d,%d,%d,%d,%f,%f,%f,%f,%f,%f\n",
+           time, generation,
+           (type >= TEXT && type <= MIGRATE) ? EVENT_TYPE_NAMES[type] : "unknown",
+           member, tag, parent1, parent2, error, meanError, fitness,
+           replacementError, replacementMeanError, replacementFitness);
+   return(string(buf));
+}
+
+
+// Constructor.
+MorphLog::MorphLog(FILE *fp, int numThreads, int bufferSize, bool binary)
+{
+   int    i;
+   size_t ringSize;
+
+   assert(fp != NULL);
+   assert(numThreads > 0);
+   assert(bufferSize > 0);
+   assert(EVENT_SIZE == 64);
+   this->fp         = fp;
+   this->numThreads = numThreads;
+   this->binary     = binary;
+   startTime        = getmicrotime();
+   if (binary)
+   {
+      // File header: identifier, format and record size.
+      i = FORMAT;
+      fwrite(MAGIC, 1, strlen(MAGIC), fp);
+      fwrite(&i, sizeof(int), 1, fp);
+      i = EVENT_SIZE;
+      fwrite(&i, sizeof(int), 1, fp);
+   }
+
+   // Half of budget for thread buffers, half for records held for ordering.
+   numRings = numThreads + 1;
+   ringSize = (((size_t)bufferSize * 1024) / 2) / (size_t)numRings;
+   if (ringSize < MIN_RING_SIZE)
+   {
+      ringSize = MIN_RING_SIZE;
+   }
+   rings = new Ring[numRings];
+   assert(rings != NULL);
+   for (i = 0; i < numRings; i++)
+   {
+      rings[i].buffer.resize(ringSize);
+      rings[i].head = 0;
+      rings[i].tail = 0;
+   }
+   currentSection = 0;
+   sequence       = 0;
+   entriesSize    = 0;
+   entriesBudget  = ((size_t)bufferSize * 1024) / 2;
+   stalls         = 0;
+   overflows      = 0;
+#ifdef THREADS
+   if (pthread_key_create(&threadRing, NULL) != 0)
+   {
+      fprintf(stderr, "pthread_key_create failed, errno=%d\n", errno);
+      exit(1);
+   }
+   if ((pthread_mutex_init(&sharedMutex, NULL) != 0) ||
+       (pthread_mutex_init(&mutex, NULL) != 0))
+   {
+      fprintf(stderr, "pthread_mutex_init failed, errno=%d\n", errno);
+      exit(1);
+   }
+   if ((pthread_cond_init(&wakeup, NULL) != 0) ||
+       (pthread_cond_init(&drained, NULL) != 0))
+   {
+      fprintf(stderr, "pthread_cond_init failed, errno=%d\n", errno);
+      exit(1);
+   }
+   stop     = false;
+   flushing = false;
+   if (pthread_create(&writer, NULL, writeThread, (void *)this) != 0)
+   {
+      fprintf(stderr, "Cannot create morph log writer thread\n");
+      exit(1);
+   }
+#endif
+}
+
+
+// Destructor.
+MorphLog::~MorphLog()
+{
+#ifdef THREADS
+   pthread_mutex_lock(&mutex);
+   stop = true;
+   pthread_cond_signal(&wakeup);
+   pthread_mutex_unlock(&mutex);
+   pthread_join(writer, NULL);
+#endif
+   write(true);
+   fflush(fp);
+#ifdef THREADS
+   pthread_cond_destroy(&drained);
+   pthread_cond_destroy(&wakeup);
+   pthread_mutex_destroy(&mutex);
+   pthread_mutex_destroy(&sharedMutex);
+   pthread_key_delete(threadRing);
+#endif
+   delete [] rings;
+}
+
+
+// Attach calling thread to its buffer.
+void MorphLog::attach(int threadNum)
+{
+   assert(threadNum >= 0 && threadNum < numThreads);
+#ifdef THREADS
+   pthread_setspecific(threadRing, (void *)&rings[threadNum]);
+#endif
+}
+
+
+// Print in arrival order.
+void MorphLog::print(const char *format, ...)
+{
+   va_list args;
+
+   va_start(args, format);
+   record(-1, -1, format, args);
+   va_end(args);
+}
+
+
+// Print offspring record.
+void MorphLog::record(int part, int index, const char *format, ...)
+{
+   va_list args;
+
+   va_start(args, format);
+   record(part, index, format, args);
+   va_end(args);
+}
+
+
+void MorphLog::record(int part, int index, const char *format, va_list args)
+{
+   int        n;
+   char       buf[BUFSIZ];
+   string     text;
+   va_list    copy;
+   MorphEvent event;
+
+   va_copy(copy, args);
+   n = vsnprintf(buf, BUFSIZ, format, copy);
+   va_end(copy);
+   if (n < 0)
+   {
+      return;
+   }
+   if (n >= BUFSIZ)
+   {
+      text.resize(n + 1);
+      vsnprintf(&text[0], n + 1, format, args);
+      text.resize(n);
+   }
+   else
+   {
+      text.assign(buf, n);
+   }
+   if (binary)
+   {
+      // Text event followed by aligned text.
+      event.type   = MorphEvent::TEXT;
+      event.time   = getmicrotime() - startTime;
+      event.length = n;
+      text.insert(0, (const char *)&event, EVENT_SIZE);
+      text.resize(((text.size() + TEXT_ALIGN - 1) / TEXT_ALIGN) * TEXT_ALIGN, '\0');
+   }
+   store(part, index, text.data(), (int)text.size());
+}
+
+
+// Log member event.
+void MorphLog::event(int part, int index, MorphEvent& event)
+{
+   string text;
+
+   event.time = getmicrotime() - startTime;
+   if (binary)
+   {
+      store(part, index, (const char *)&event, EVENT_SIZE);
+   }
+   else
+   {
+      text = event.format();
+      store(part, index, text.data(), (int)text.size());
+   }
+}
+
+
+// Store record in calling thread's ring.
+void MorphLog::store(int part, int index, const char *data, int length)
+{
+   Header header;
+   Ring   *ring;
+
+   header.section  = currentSection.load(memory_order_acquire);
+   header.part     = part;
+   header.index    = index;
+   header.length   = length;
+   header.sequence = sequence.fetch_add(1);
+#ifdef THREADS
+   if ((ring = (Ring *)pthread_getspecific(threadRing)) == NULL)
+   {
+      ring = &rings[numThreads];
+      pthread_mutex_lock(&sharedMutex);
+      append(ring, header, data);
+      pthread_mutex_unlock(&sharedMutex);
+      return;
+   }
+#else
+   ring = &rings[0];
+#endif
+   append(ring, header, data);
+}
+
+
+// Append record to ring, waiting for writer while full.
+void MorphLog::append(Ring *ring, Header& header, const char *data)
+{
+   size_t size, tail, capacity;
+
+   capacity = ring->buffer.size();
+   size     = sizeof(Header) + (size_t)header.length;
+   if (size > capacity)
+   {
+      // Truncate record to buffer.
+      header.length = (int)(capacity - sizeof(Header));
+      size          = capacity;
+   }
+   tail = ring->tail.load(memory_order_relaxed);
+   if ((tail + size - ring->head.load(memory_order_acquire)) > capacity)
+   {
+      stalls++;
+#ifdef THREADS
+      pthread_mutex_lock(&mutex);
+      while ((tail + size - ring->head.load(memory_order_acquire)) > capacity)
+      {
+         pthread_cond_signal(&wakeup);
+         pthread_cond_wait(&drained, &mutex);
+      }
+      pthread_mutex_unlock(&mutex);
+#else
+      write(false);
+#endif
+   }
+   put(ring, tail, &header, sizeof(Header));
+   put(ring, tail + sizeof(Header), data, (size_t)header.length);
+   ring->tail.store(tail + size, memory_order_release);
+}
+
+
+// Copy data into ring at position.
+void MorphLog::put(Ring *ring, size_t position, const void *data, size_t size)
+{
+   size_t capacity, offset, n;
+
+   capacity = ring->buffer.size();
+   offset   = position % capacity;
+   n        = capacity - offset;
+   if (n > size)
+   {
+      n = size;
+   }
+   memcpy(&ring->buffer[offset], data, n);
+   if (n < size)
+   {
+      memcpy(&ring->buffer[0], (const char *)data + n, size - n);
+   }
+}
+
+
+// Copy data from ring at position.
+void MorphLog::get(Ring *ring, size_t position, void *data, size_t size)
+{
+   size_t capacity, offset, n;
+
+   capacity = ring->buffer.size();
+   offset   = position % capacity;
+   n        = capacity - offset;
+   if (n > size)
+   {
+      n = size;
+   }
+   memcpy(data, &ring->buffer[offset], n);
+   if (n < size)
+   {
+      memcpy((char *)data + n, &ring->buffer[0], size - n);
+   }
+}
+
+
+// Close section.
+void MorphLog::section()
+{
+   currentSection.fetch_add(1, memory_order_release);
+}
+
+
+// Close section and write closed sections.
+void MorphLog::flush()
+{
+   section();
+#ifdef THREADS
+   pthread_mutex_lock(&mutex);
+   flushing = true;
+   pthread_cond_signal(&wakeup);
+   pthread_mutex_unlock(&mutex);
+#else
+   write(false);
+   fflush(fp);
+#endif
+}
+
+
+// Statistics.
+void MorphLog::getStatistics(int& stalls, int& overflows)
+{
+   stalls    = this->stalls;
+   overflows = this->overflows;
+}
+
+
+// Entry order: section, part, index, arrival.
+bool MorphLog::Entry::operator<(const Entry& other) const
+{
+   if (section != other.section)
+   {
+      return(section < other.section);
+   }
+   if (part != other.part)
+   {
+      return(part < other.part);
+   }
+   if (index != other.index)
+   {
+      return(index < other.index);
+   }
+   return(sequence < other.sequence);
+}
+
+
+// Move ring records to entries.
+void MorphLog::drain()
+{
+   int    i;
+   size_t head, tail;
+   Header header;
+   Entry  entry;
+
+   for (i = 0; i < numRings; i++)
+   {
+      head = rings[i].head.load(memory_order_relaxed);
+      tail = rings[i].tail.load(memory_order_acquire);
+      while (head < tail)
+      {
+         get(&rings[i], head, &header, sizeof(Header));
+         entry.section  = header.section;
+         entry.part     = header.part;
+         entry.index    = header.index;
+         entry.sequence = header.sequence;
+         entry.text.resize(header.length);
+         if (header.length > 0)
+         {
+            get(&rings[i], head + sizeof(Header), &entry.text[0], (size_t)header.length);
+         }
+         entries.push_back(entry);
+         entriesSize += (size_t)header.length;
+         head        += sizeof(Header) + (size_t)header.length;
+      }
+      rings[i].head.store(head, memory_order_release);
+   }
+}
+
+
+// Write closed sections, or all records, in one buffered write.
+void MorphLog::write(bool all)
+{
+   int    i, n, closed;
+   string output;
+
+   // Records of closed sections are in rings before section is closed.
+   closed = currentSection.load(memory_order_acquire);
+   drain();
+   if (entries.size() == 0)
+   {
+      return;
+   }
+   std::sort(entries.begin(), entries.end());
+   if (!all && (entriesSize > entriesBudget))
+   {
+      // Over budget: write open section records early.
+      all = true;
+      overflows++;
+   }
+   for (i = 0, n = (int)entries.size(); i < n; i++)
+   {
+      if (!all && (entries[i].section >= closed))
+      {
+         break;
+      }
+      output      += entries[i].text;
+      entriesSize -= entries[i].text.size();
+   }
+   entries.erase(entries.begin(), entries.begin() + i);
+   if (output.size() > 0)
+   {
+      fwrite(output.data(), 1, output.size(), fp);
+   }
+}
+
+
+// Decode binary log to text or CSV.
+bool MorphLog::decode(char *logFile, FILE *out, bool csv)
+{
+   int        format, size, length;
+   char       magic[BUFSIZ];
+   string     text;
+   FILE       *fp;
+   MorphEvent event;
+
+   if ((fp = fopen(logFile, "rb")) == NULL)
+   {
+      fprintf(stderr, "Cannot open binary morph log file %s\n", logFile);
+      return(false);
+   }
+   length = (int)strlen(MAGIC);
+   if ((fread(magic, 1, length, fp) != (size_t)length) ||
+       (strncmp(magic, MAGIC, length) != 0) ||
+       (fread(&format, sizeof(int), 1, fp) != 1) ||
+       (fread(&size, sizeof(int), 1, fp) != 1))
+   {
+      fprintf(stderr, "File %s is not a binary morph log\n", logFile);
+      fclose(fp);
+      return(false);
+   }
+   if ((format != FORMAT) || (size != EVENT_SIZE))
+   {
+      fprintf(stderr, "Binary morph log %s has format %d, record size %d; expected format %d, record size %d\n",
+              logFile, format, size, FORMAT, EVENT_SIZE);
+      fclose(fp);
+      return(false);
+   }
+   if (csv)
+   {
+      fprintf(out, "%s\n", MorphEvent::CSV_HEADER);
+   }
+   while (fread(&event, EVENT_SIZE, 1, fp) == 1)
+   {
+      if (event.type == MorphEvent::TEXT)
+      {
+         length = ((event.length + TEXT_ALIGN - 1) / TEXT_ALIGN) * TEXT_ALIGN;
+         text.resize(length);
+         if ((length > 0) && (fread(&text[0], 1, length, fp) != (size_t)length))
+         {
+            fprintf(stderr, "Binary morph log %s is truncated\n", logFile);
+            fclose(fp);
+            return(false);
+         }
+         if (!csv)
+         {
+            fwrite(text.data(), 1, event.length, out);
+         }
+      }
+      else if (csv)
+      {
+         text = event.formatCSV();
+         fputs(text.c_str(), out);
+      }
+      else
+      {
+         text = event.format();
+         fputs(text.c_str(), out);
+      }
+   }
+   fclose(fp);
+   return(true);
+}
+
+
+#ifdef THREADS
+// Writer thread.
+void *MorphLog::writeThread(void *arg)
+{
+   MorphLog        *morphLog = (MorphLog *)arg;
+   bool            flush;
+   struct timeval  now;
+   struct timespec timeout;
+
+   pthread_mutex_lock(&morphLog->mutex);
+   while (!morphLog->stop)
+   {
+      if (!morphLog->flushing)
+      {
+         gettimeofday(&now, NULL);
+         timeout.tv_sec  = now.tv_sec;
+         timeout.tv_nsec = (now.tv_usec * 1000) + (WRITE_INTERVAL_MSEC * 1000000);
+         if (timeout.tv_nsec >= 1000000000)
+         {
+            timeout.tv_sec++;
+            timeout.tv_nsec -= 1000000000;
+         }
+         pthread_cond_timedwait(&morphLog->wakeup, &morphLog->mutex, &timeout);
+      }
+      flush              = morphLog->flushing;
+      morphLog->flushing = false;
+      pthread_mutex_unlock(&morphLog->mutex);
+      morphLog->write(false);
+      if (flush)
+      {
+         fflush(morphLog->fp);
+      }
+      pthread_mutex_lock(&morphLog->mutex);
+      pthread_cond_broadcast(&morphLog->drained);
+   }
+   pthread_mutex_unlock(&morphLog->mutex);
+   return(NULL);
+}
+
+
+#endif
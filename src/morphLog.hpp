@@ -0,0 +1,191 @@
+// Morph log writer.
+// Each morph thread appends log records to its own lock-free ring buffer
+// and a background writer drains the buffers to the log file.
+// The log is divided into sections, one per morph phase. Records of a
+// section are written once it is closed, ordered by part, then offspring
+// index, then arrival, so the log does not depend on thread scheduling.
+// Records that are not offspring records are ordered by arrival.
+// Memory is bounded: a thread whose buffer is full waits for the writer,
+// and if records held for ordering exceed their budget they are written
+// early in the best order available.
+// A binary log stores fixed-size member events and text events instead of
+// formatted text; "bionet -decodeLog" converts it to text or CSV.
+
+#ifndef __MORPH_LOG_HPP__
+#define __MORPH_LOG_HPP__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include "gettime.h"
+#ifdef THREADS
+#include <pthread.h>
+#endif
+using namespace std;
+
+// Morph event: fixed-size binary log record.
+// A text event is followed by its text, padded to 8-byte alignment.
+class MorphEvent
+{
+public:
+
+   // Event types.
+   enum TYPE
+   {
+      TEXT, POPULATION, MATE, MUTATE, OPTIMIZE, PRUNE, REPLACE, STEADY, MIGRATE
+   };
+
+   // Logged member value: error, error with mean error, or fitness.
+   enum VALUE { ERROR_VALUE, MEAN_ERROR_VALUE, FITNESS_VALUE };
+
+   short              type;
+   short              value;
+   int                generation;
+   int                member;
+   int                tag;
+   int                parent1;
+   int                parent2;
+   float              error;
+   float              meanError;
+   float              fitness;
+   float              replacementError;
+   float              replacementMeanError;
+   float              replacementFitness;
+   unsigned long long time;
+   int                length;
+   int                reserved;
+
+   // Constructor.
+   MorphEvent();
+
+   // Format as morph log text.
+   string format();
+
+   // Format as CSV line.
+   string formatCSV();
+   static const char *CSV_HEADER;
+};
+
+class MorphLog
+{
+public:
+
+   // Default memory budget (kilobytes).
+   enum { DEFAULT_BUFFER_SIZE = 4096 };
+
+   // Binary log format.
+   enum { FORMAT = 1 };
+   static const char *MAGIC;
+
+   // Constructor.
+   MorphLog(FILE *fp, int numThreads, int bufferSize = DEFAULT_BUFFER_SIZE,
+            bool binary = false);
+
+   // Destructor: writes remaining records.
+   ~MorphLog();
+
+   // Attach calling thread to its buffer.
+   void attach(int threadNum);
+
+   // Print in arrival order.
+   void print(const char *format, ...);
+
+   // Print offspring record ordered by part and index within section.
+   // Index -1 records precede the part's offspring records.
+   void record(int part, int index, const char *format, ...);
+   void record(int part, int index, const char *format, va_list args);
+
+   // Log member event, ordered as a record.
+   void event(int part, int index, MorphEvent& event);
+
+   // Close section, allowing its records to be written.
+   void section();
+
+   // Close section and write closed sections.
+   void flush();
+
+   // Statistics: buffer full waits and early writes.
+   void getStatistics(int& stalls, int& overflows);
+
+   // Decode binary log to text or CSV.
+   static bool decode(char *logFile, FILE *out, bool csv);
+
+private:
+
+   FILE *fp;
+   int  numThreads;
+   bool binary;
+   TIME startTime;
+
+   // Record header, followed by text in buffer.
+   struct Header
+   {
+      int                section;
+      int                part;
+      int                index;
+      int                length;
+      unsigned long long sequence;
+   };
+
+   // Single producer, single consumer ring buffer.
+   // The shared ring is for threads not attached, serialized by mutex.
+   class Ring
+   {
+   public:
+      vector<char>   buffer;
+      atomic<size_t> head;
+      atomic<size_t> tail;
+   };
+   Ring                       *rings;
+   int                        numRings;
+   atomic<int>                currentSection;
+   atomic<unsigned long long> sequence;
+   void store(int part, int index, const char *data, int length);
+   void append(Ring *ring, Header& header, const char *data);
+   void put(Ring *ring, size_t position, const void *data, size_t size);
+   void get(Ring *ring, size_t position, void *data, size_t size);
+
+   // Records held for ordering.
+   class Entry
+   {
+   public:
+      int                section;
+      int                part;
+      int                index;
+      unsigned long long sequence;
+      string             text;
+
+      bool operator<(const Entry& other) const;
+   };
+   vector<Entry> entries;
+   size_t        entriesSize;
+   size_t        entriesBudget;
+
+   // Drain rings and write closed sections, or all records.
+   void drain();
+   void write(bool all);
+
+   // Statistics.
+   atomic<int> stalls;
+   int         overflows;
+
+#ifdef THREADS
+   pthread_key_t   threadRing;
+   pthread_mutex_t sharedMutex;
+   pthread_mutex_t mutex;
+   pthread_cond_t  wakeup;
+   pthread_cond_t  drained;
+   pthread_t       writer;
+   bool            stop;
+   bool            flushing;
+   static void *writeThread(void *morphLog);
+#endif
+};
+#endif
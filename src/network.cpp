@@ -351,6 +351,47 @@ Network *Network::clone()
 }
 
 
+// Copy network in place.
+void Network::copy(Network *network)
+{
+   int     i, j, k, n;
+   Synapse *synapse;
+
+   assert(numNeurons == network->numNeurons);
+   numSensors = network->numSensors;
+   numMotors  = network->numMotors;
+   for (i = 0; i < numNeurons; i++)
+   {
+      *(neurons[i])       = *(network->neurons[i]);
+      neurons[i]->network = this;
+      for (j = 0; j < numNeurons; j++)
+      {
+         vector<Synapse *>& to   = synapses[i][j];
+         vector<Synapse *>& from = network->synapses[i][j];
+         n = (int)from.size();
+         for (k = n; k < (int)to.size(); k++)
+         {
+            delete to[k];
+         }
+         if ((int)to.size() > n)
+         {
+            to.resize(n);
+         }
+         while ((int)to.size() < n)
+         {
+            synapse = new Synapse();
+            assert(synapse != NULL);
+            to.push_back(synapse);
+         }
+         for (k = 0; k < n; k++)
+         {
+            *(to[k]) = *(from[k]);
+         }
+      }
+   }
+}
+
+
 // Clear network.
 void Network::clear()
 {
@@ -391,6 +432,54 @@ void Network::step()
 }
 
 
+// Get network state.
+void Network::getState(vector<float>& state)
+{
+   int i, j, k, n;
+
+   state.clear();
+   for (i = 0; i < numNeurons; i++)
+   {
+      state.push_back(neurons[i]->bias);
+      state.push_back(neurons[i]->activation);
+   }
+   for (i = 0; i < numNeurons; i++)
+   {
+      for (j = 0; j < numNeurons; j++)
+      {
+         for (k = 0, n = (int)synapses[i][j].size(); k < n; k++)
+         {
+            state.push_back(synapses[i][j][k]->signal);
+         }
+      }
+   }
+}
+
+
+// Set network state.
+void Network::setState(vector<float>& state)
+{
+   int i, j, k, n, s;
+
+   for (i = s = 0; i < numNeurons; i++)
+   {
+      neurons[i]->bias       = state[s++];
+      neurons[i]->activation = state[s++];
+   }
+   for (i = 0; i < numNeurons; i++)
+   {
+      for (j = 0; j < numNeurons; j++)
+      {
+         for (k = 0, n = (int)synapses[i][j].size(); k < n; k++)
+         {
+            synapses[i][j][k]->signal = state[s++];
+         }
+      }
+   }
+   assert(s == (int)state.size());
+}
+
+
 // Load network.
 bool Network::load(char *filename, bool binary)
 {
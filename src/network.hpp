@@ -43,12 +43,19 @@ public:
    // Clone network.
    Network *clone();
 
+   // Copy network with same number of neurons in place, reusing storage.
+   void copy(Network *network);
+
    // Clear network.
    void clear();
 
    // Step network.
    void step();
 
+   // Get and set network state: neuron biases and activations, synapse signals.
+   void getState(vector<float>& state);
+   void setState(vector<float>& state);
+
    // Load network.
    bool load(char *filename, bool binary = false);
    void load(FilePointer *fp);
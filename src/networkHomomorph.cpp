@@ -2,27 +2,29 @@
 
 #include "networkHomomorph.hpp"
 
+// Synapse group optimizer type and evaluation budget.
+int NetworkHomomorph::synapseOptimizer       = Optimizer::GRID;
+int NetworkHomomorph::synapseOptimizerBudget = -1;
+
 // Constructors.
 NetworkHomomorph::NetworkHomomorph(Network *homomorph,
                                    MutableParm& synapseWeightsParm,
                                    vector<vector<pair<int, int> > > *motorConnections,
                                    Random *randomizer, int tag)
 {
-   this->synapseWeightsParm = synapseWeightsParm;
-   this->synapseWeightsParm.initValue(randomizer);
-   this->motorConnections = motorConnections;
-   this->randomizer       = randomizer;
-   this->tag = tag;
-   network   = homomorph->clone();
-   motorErrors.resize(network->numMotors, false);
+   network = NULL;
+   init(homomorph, synapseWeightsParm, motorConnections, randomizer, tag);
 }
 
 
 NetworkHomomorph::NetworkHomomorph()
 {
-   randomizer = NULL;
-   tag        = -1;
-   network    = NULL;
+   randomizer       = NULL;
+   tag              = -1;
+   network          = NULL;
+   optimizeWork     = optimizeFullWork = 0;
+   raceAudited      = false;
+   raceLoss         = 0.0f;
 }
 
 
@@ -32,6 +34,9 @@ NetworkHomomorph::NetworkHomomorph(FilePointer *fp,
 {
    network          = NULL;
    this->randomizer = randomizer;
+   optimizeWork     = optimizeFullWork = 0;
+   raceAudited      = false;
+   raceLoss         = 0.0f;
    load(fp);
    this->motorConnections = motorConnections;
 }
@@ -69,64 +74,415 @@ void NetworkHomomorph::mutate()
 // Optimize synapses.
 void NetworkHomomorph::optimize(vector<Behavior *>& behaviors,
                                 vector<bool>& fitnessMotorList,
-                                int synapseOptimizedPathLength, int maxStep)
+                                int synapseOptimizedPathLength, int maxStep,
+                                BehaviorTrie *behaviorTrie,
+                                RaceSchedule *raceSchedule, int raceIndex)
 {
-   int   i, j, k, n, p, q;
-   float e;
+   int i, j, k;
 
-   // Initialize optimization.
    vector<vector<Synapse *> > synapses;
-   vector<vector<float> >     permutations;
-   initOptimize(synapses, permutations, synapseOptimizedPathLength);
+   vector<vector<float> >     candidates;
+   vector<float>              scores;
+
+   optimizeWork = optimizeFullWork = 0;
+   raceAudited  = false;
+   raceLoss     = 0.0f;
 
-   // Hill-climb synapse weight permutations.
-   n = 0;
-   e = error;
-   for (i = 1, j = (int)permutations.size(); i < j; i++)
+   // Initialize optimization.
+   Optimizer *optimizer = initOptimize(synapses, synapseOptimizedPathLength);
+   if (optimizer == NULL)
    {
-      for (k = 0; k < (int)synapses.size(); k++)
+      return;
+   }
+
+   // Hill-climb proposed synapse weights.
+   k = behaviorSteps(behaviors, maxStep);
+   while (optimizer->propose(candidates))
+   {
+      j                 = (int)candidates.size();
+      optimizeFullWork += (long long)j * k;
+      if ((raceSchedule != NULL) && (raceSchedule->behaviors != -1) && (j > 1))
+      {
+         race(behaviors, fitnessMotorList, maxStep, behaviorTrie, synapses, candidates,
+              raceSchedule, raceIndex, optimizer->bestScore, scores);
+      }
+      else
       {
-         for (p = 0, q = (int)synapses[k].size(); p < q; p++)
+         scores.resize(j);
+         for (i = 0; i < j; i++)
+         {
+            setPermutation(synapses, candidates[i]);
+            evaluate(behaviors, fitnessMotorList, maxStep, behaviorTrie);
+            scores[i] = error;
+         }
+         optimizeWork += (long long)j * k;
+      }
+      optimizer->update(scores);
+   }
+   setPermutation(synapses, optimizer->best);
+   error = optimizer->bestScore;
+   delete optimizer;
+}
+
+
+// Optimize synapses by gradient descent.
+// Each iteration steps all synapse weights against the gradient, scaled so the
+// largest change is the synapse weight maximum delta and clamped to the weight
+// bounds. The step is halved until the behavior error improves, and
+// optimization stops if it does not.
+void NetworkHomomorph::optimizeGradient(vector<Behavior *>& behaviors,
+                                        vector<bool>& fitnessMotorList,
+                                        int iterations, int maxStep,
+                                        BehaviorTrie *behaviorTrie)
+{
+   int   i, j, k, n, steps;
+   bool  b;
+   float e, scale, weight, gradientMax;
+
+   vector<SynapseEdge> edges;
+   SynapseEdge         edge;
+   vector<float>       gradient, weights;
+   vector<bool>        m;
+
+   optimizeWork = optimizeFullWork = 0;
+   raceAudited  = false;
+   raceLoss     = 0.0f;
+   if (synapseWeightsParm.maxDelta <= 0.0f)
+   {
+      return;
+   }
+
+   // Collect synapses.
+   n = network->numNeurons;
+   for (i = 0; i < n; i++)
+   {
+      for (j = 0; j < n; j++)
+      {
+         for (k = 0; k < (int)network->synapses[i][j].size(); k++)
+         {
+            edge.synapse = network->synapses[i][j][k];
+            edge.source  = i;
+            edge.target  = j;
+            edges.push_back(edge);
+         }
+      }
+   }
+   n = (int)edges.size();
+   if (n == 0)
+   {
+      return;
+   }
+   weights.resize(n);
+
+   // Descend gradient.
+   steps = behaviorSteps(behaviors, maxStep);
+   e     = error;
+   b     = behaves;
+   m     = motorErrors;
+   for (i = 0; i < iterations; i++)
+   {
+      gradientMax   = backpropagate(behaviors, fitnessMotorList, maxStep, edges, gradient);
+      optimizeWork += 2 * steps;
+      if (gradientMax <= 0.0f)
+      {
+         break;
+      }
+      for (j = 0; j < n; j++)
+      {
+         weights[j] = edges[j].synapse->weight;
+      }
+      scale = synapseWeightsParm.maxDelta / gradientMax;
+      for (k = 0; k <= MAX_STEP_HALVINGS; k++, scale *= 0.5f)
+      {
+         for (j = 0; j < n; j++)
          {
-            synapses[k][p]->setWeight(permutations[i][k]);
+            weight = weights[j] - (scale * gradient[j]);
+            if (weight < synapseWeightsParm.minimum)
+            {
+               weight = synapseWeightsParm.minimum;
+            }
+            if (weight > synapseWeightsParm.maximum)
+            {
+               weight = synapseWeightsParm.maximum;
+            }
+            edges[j].synapse->setWeight(weight);
+         }
+         evaluate(behaviors, fitnessMotorList, maxStep, behaviorTrie);
+         optimizeWork += steps;
+         if (error < e)
+         {
+            break;
          }
       }
-      evaluate(behaviors, fitnessMotorList, maxStep);
-      if (error < e)
+      if (k > MAX_STEP_HALVINGS)
       {
-         n = i;
-         e = error;
+         // Restore weights without requantizing.
+         for (j = 0; j < n; j++)
+         {
+            edges[j].synapse->weight = weights[j];
+         }
+         break;
       }
+      e = error;
+      b = behaves;
+      m = motorErrors;
    }
+   error       = e;
+   behaves     = b;
+   motorErrors = m;
+}
+
+
+// Compute surrogate error gradient by backpropagation through time.
+// The surrogate of a motor output delta d is d^2, plus ((|d| - t) / t)^2 beyond
+// the error tolerance t, averaged over evaluated motor outputs.
+float NetworkHomomorph::backpropagate(vector<Behavior *>& behaviors,
+                                      vector<bool>& fitnessMotorList, int maxStep,
+                                      vector<SynapseEdge>& edges, vector<float>& gradient)
+{
+   int    i, j, k, n, m, s, t, e, count;
+   float  a, d, g, gradientMax;
+   Neuron *neuron;
+
+   vector<float> signs, activations, derivatives, adjoints, nextAdjoints;
+
+   n = network->numNeurons;
+   s = network->numSensors;
+   e = (int)edges.size();
+   gradient.assign(e, 0.0f);
+   signs.resize(n);
+   for (i = 0; i < n; i++)
+   {
+      signs[i] = network->neurons[i]->excitatory ? 1.0f : -1.0f;
+   }
+   adjoints.resize(n);
+   count = 0;
+   for (i = 0; i < (int)behaviors.size(); i++)
+   {
+      m = (int)behaviors[i]->sensorSequence.size();
+      if ((maxStep != -1) && ((maxStep + 1) < m))
+      {
+         m = maxStep + 1;
+      }
+
+      // Forward pass, recording activations following the cleared state.
+      activations.assign((m + 1) * n, 0.0f);
+      derivatives.resize(m * n);
+      network->clear();
+      for (t = 0; t < m; t++)
+      {
+         for (j = 0; j < s; j++)
+         {
+            network->neurons[j]->bias = behaviors[i]->sensorSequence[t][j];
+         }
+         network->step();
+         for (j = 0; j < n; j++)
+         {
+            neuron = network->neurons[j];
+            a      = neuron->activation;
+            activations[((t + 1) * n) + j] = a;
+            if (neuron->function == Neuron::LOGISTIC)
+            {
+               derivatives[(t * n) + j] = 8.0f * a * (1.0f - a);
+            }
+            else
+            {
+               derivatives[(t * n) + j] = 1.0f;
+            }
+         }
+      }
+
+      // Backward pass: adjoints are surrogate error derivatives by neuron input.
+      nextAdjoints.assign(n, 0.0f);
+      for (t = m - 1; t >= 0; t--)
+      {
+         fill(adjoints.begin(), adjoints.end(), 0.0f);
+         for (k = 0; k < network->numMotors; k++)
+         {
+            if ((fitnessMotorList.size() > 0) && !fitnessMotorList[k])
+            {
+               continue;
+            }
+            d = activations[((t + 1) * n) + s + k] - behaviors[i]->motorSequence[t][k];
+            g = 2.0f * d;
+            if (fabs(d) > MAX_ERROR_TOLERANCE)
+            {
+               a  = (2.0f * ((float)fabs(d) - MAX_ERROR_TOLERANCE)) /
+                    (MAX_ERROR_TOLERANCE * MAX_ERROR_TOLERANCE);
+               g += d > 0.0f ? a : -a;
+            }
+            adjoints[s + k] = g;
+            count++;
+         }
+         for (j = 0; j < e; j++)
+         {
+            adjoints[edges[j].source] += nextAdjoints[edges[j].target] *
+                                         signs[edges[j].source] * edges[j].synapse->weight;
+         }
+         for (j = 0; j < n; j++)
+         {
+            adjoints[j] *= derivatives[(t * n) + j];
+         }
+         for (j = 0; j < e; j++)
+         {
+            gradient[j] += adjoints[edges[j].target] *
+                           signs[edges[j].source] * activations[(t * n) + edges[j].source];
+         }
+         adjoints.swap(nextAdjoints);
+      }
+   }
+   network->clear();
+
+   gradientMax = 0.0f;
+   for (j = 0; j < e; j++)
+   {
+      if (count > 0)
+      {
+         gradient[j] /= (float)count;
+      }
+      if (fabs(gradient[j]) > gradientMax)
+      {
+         gradientMax = (float)fabs(gradient[j]);
+      }
+   }
+   return(gradientMax);
+}
+
+
+// Race synapse weight permutations.
+// Advancing permutations are scored by full evaluation.
+void NetworkHomomorph::race(vector<Behavior *>& behaviors, vector<bool>& fitnessMotorList,
+                            int maxStep, BehaviorTrie *behaviorTrie,
+                            vector<vector<Synapse *> >& synapses,
+                            vector<vector<float> >& permutations,
+                            RaceSchedule *raceSchedule, int raceIndex, float bestError,
+                            vector<float>& scores)
+{
+   int   i, j, k, n, s, raceStep, fullSteps;
+   float e;
+
+   vector<Behavior *>        subset;
+   vector<pair<float, int> > screen;
+
+   // Select rotating behavior subset.
+   n = (int)behaviors.size();
+   s = raceSchedule->behaviors;
+   if (s > n)
+   {
+      s = n;
+   }
+   for (i = 0, j = ((raceIndex % n) * s) % n; i < s; i++)
+   {
+      subset.push_back(behaviors[(j + i) % n]);
+   }
+   raceStep = maxStep;
+   if ((raceSchedule->steps != -1) &&
+       ((maxStep == -1) || ((raceSchedule->steps - 1) < maxStep)))
+   {
+      raceStep = raceSchedule->steps - 1;
+   }
+
+   // Screen permutations.
+   k = behaviorSteps(subset, raceStep);
+   for (i = 0, j = (int)permutations.size(); i < j; i++)
+   {
+      setPermutation(synapses, permutations[i]);
+      evaluate(subset, fitnessMotorList, raceStep);
+      optimizeWork += k;
+      screen.push_back(pair<float, int>(error, i));
+   }
+   scores.assign(j, FLT_MAX);
+
+   // Advance leaders to full evaluation.
+   k = (int)ceil(raceSchedule->advance * (float)screen.size());
+   if (k < 1)
+   {
+      k = 1;
+   }
+   if (k > (int)screen.size())
+   {
+      k = (int)screen.size();
+   }
+   partial_sort(screen.begin(), screen.begin() + k, screen.end());
+   fullSteps = behaviorSteps(behaviors, maxStep);
+   for (i = 0; i < k; i++)
+   {
+      setPermutation(synapses, permutations[screen[i].second]);
+      evaluate(behaviors, fitnessMotorList, maxStep, behaviorTrie);
+      optimizeWork            += fullSteps;
+      scores[screen[i].second] = error;
+      if (error < bestError)
+      {
+         bestError = error;
+      }
+   }
+
+   // Audit: fully evaluate eliminated permutations to measure loss.
+   if ((raceSchedule->auditInterval > 0) && ((raceIndex % raceSchedule->auditInterval) == 0))
+   {
+      raceAudited = true;
+      e           = bestError;
+      for (i = k, j = (int)screen.size(); i < j; i++)
+      {
+         setPermutation(synapses, permutations[screen[i].second]);
+         evaluate(behaviors, fitnessMotorList, maxStep, behaviorTrie);
+         if (error < e)
+         {
+            e = error;
+         }
+      }
+      raceLoss += bestError - e;
+   }
+}
+
+
+// Set synapse weight permutation.
+void NetworkHomomorph::setPermutation(vector<vector<Synapse *> >& synapses,
+                                      vector<float>&             permutation)
+{
+   int k, p, q;
+
    for (k = 0; k < (int)synapses.size(); k++)
    {
       for (p = 0, q = (int)synapses[k].size(); p < q; p++)
       {
-         synapses[k][p]->setWeight(permutations[n][k]);
+         synapses[k][p]->setWeight(permutation[k]);
       }
    }
-   error = e;
+}
+
+
+// Count behavior steps evaluated.
+int NetworkHomomorph::behaviorSteps(vector<Behavior *>& behaviors, int maxStep)
+{
+   int i, n, m, steps;
+
+   for (i = steps = 0, n = (int)behaviors.size(); i < n; i++)
+   {
+      m = (int)behaviors[i]->sensorSequence.size();
+      if ((maxStep != -1) && ((maxStep + 1) < m))
+      {
+         m = maxStep + 1;
+      }
+      steps += m;
+   }
+   return(steps);
 }
 
 
 // Initialize synapse optimization.
-void NetworkHomomorph::initOptimize(vector<vector<Synapse *> >& synapses,
-                                    vector<vector<float> >&     permutations,
-                                    int                         synapseOptimizedPathLength)
+Optimizer *NetworkHomomorph::initOptimize(vector<vector<Synapse *> >& synapses,
+                                          int                         synapseOptimizedPathLength)
 {
-   int   i, j, k, n, p, q, s;
-   bool  forward;
-   float weight;
+   int  i, j, k, n, p, q, s;
+   bool forward;
 
    vector<pair<int, int> > visited;
    Synapse                 *synapse;
    vector<Synapse *>       chemSynapses, elecSynapses;
-   vector<vector<float> >  weightRanges;
-   vector<float>           weightRange;
-   vector<float>           permutation;
+   vector<MutableParm>     weights;
 
    synapses.clear();
-   permutations.clear();
 
    // Randomly select starting neuron with synapse.
    i = randomNeuron();
@@ -179,7 +535,7 @@ void NetworkHomomorph::initOptimize(vector<vector<Synapse *> >& synapses,
    }
    if (s == n)
    {
-      return;
+      return(NULL);
    }
 
    // Select synapse path.
@@ -287,39 +643,17 @@ void NetworkHomomorph::initOptimize(vector<vector<Synapse *> >& synapses,
 
    if (synapses.size() == 0)
    {
-      return;
+      return(NULL);
    }
 
-   // Compose synapse weight permutations.
+   // Synapse group weights share the synapse weights parameter bounds.
    for (i = 0, j = (int)synapses.size(); i < j; i++)
    {
-      weightRange.clear();
-      weight = synapses[i][0]->weight;
-      weightRange.push_back(weight);
-      if (synapseWeightsParm.maxDelta > 0.0f)
-      {
-         weight = synapses[i][0]->weight -
-                  (float)randomizer->RAND_INTERVAL(0.0f, synapseWeightsParm.maxDelta);
-         if (weight < synapseWeightsParm.minimum)
-         {
-            weight = synapseWeightsParm.minimum;
-         }
-      }
-      weightRange.push_back(weight);
-      if (synapseWeightsParm.maxDelta > 0.0f)
-      {
-         weight = synapses[i][0]->weight +
-                  (float)randomizer->RAND_INTERVAL(0.0f, synapseWeightsParm.maxDelta);
-         if (weight > synapseWeightsParm.maximum)
-         {
-            weight = synapseWeightsParm.maximum;
-         }
-      }
-      weightRange.push_back(weight);
-      weightRanges.push_back(weightRange);
+      weights.push_back(synapseWeightsParm);
+      weights[i].value = synapses[i][0]->weight;
    }
-   permutation.resize((int)synapses.size());
-   permuteWeights(weightRanges, permutations, permutation, 0, (int)synapses.size() - 1);
+   return(Optimizer::create(synapseOptimizer, weights, error, randomizer,
+                            synapseOptimizerBudget));
 }
 
 
@@ -379,36 +713,15 @@ int NetworkHomomorph::randomNeuron(bool nonMotor)
 }
 
 
-// Permute weights.
-void NetworkHomomorph::permuteWeights(vector<vector<float> >& weightRanges,
-                                      vector<vector<float> >& permutations,
-                                      vector<float>& permutation,
-                                      int level, int depth)
-{
-   for (int i = 0; i < 3; i++)
-   {
-      permutation[level] = weightRanges[level][i];
-      if (level < depth)
-      {
-         permuteWeights(weightRanges, permutations, permutation, level + 1, depth);
-      }
-      else
-      {
-         permutations.push_back(permutation);
-      }
-   }
-}
-
-
 // Clone.
-NetworkHomomorph *NetworkHomomorph::clone(int tag)
+NetworkHomomorph *NetworkHomomorph::clone(int tag, Random *randomizer)
 {
    int              i, n;
    NetworkHomomorph *networkMorph;
 
    networkMorph = new NetworkHomomorph(
       network, synapseWeightsParm,
-      motorConnections, randomizer, tag);
+      motorConnections, randomizer != NULL ? randomizer : this->randomizer, tag);
    assert(networkMorph != NULL);
    networkMorph->error = error;
    for (i = 0, n = (int)motorErrors.size(); i < n; i++)
@@ -420,6 +733,48 @@ NetworkHomomorph *NetworkHomomorph::clone(int tag)
 }
 
 
+// Reinitialize in place as constructed from homomorph.
+void NetworkHomomorph::init(Network *homomorph,
+                            MutableParm& synapseWeightsParm,
+                            vector<vector<pair<int, int> > > *motorConnections,
+                            Random *randomizer, int tag)
+{
+   this->synapseWeightsParm = synapseWeightsParm;
+   this->synapseWeightsParm.initValue(randomizer);
+   this->motorConnections = motorConnections;
+   this->randomizer       = randomizer;
+   this->tag = tag;
+   if (network == NULL)
+   {
+      network = homomorph->clone();
+   }
+   else
+   {
+      network->copy(homomorph);
+   }
+   motorErrors.assign(network->numMotors, false);
+   error            = 0.0f;
+   behaves          = false;
+   offspringCount   = 0;
+   node             = 0;
+   fingerprinted    = false;
+   optimizeWork     = optimizeFullWork = 0;
+   raceAudited      = false;
+   raceLoss         = 0.0f;
+}
+
+
+// Clone member in place.
+void NetworkHomomorph::cloneFrom(NetworkHomomorph *member, int tag, Random *randomizer)
+{
+   init(member->network, member->synapseWeightsParm, member->motorConnections,
+        randomizer != NULL ? randomizer : member->randomizer, tag);
+   error       = member->error;
+   motorErrors = member->motorErrors;
+   behaves     = member->behaves;
+}
+
+
 // Load.
 void NetworkHomomorph::load(FilePointer *fp)
 {
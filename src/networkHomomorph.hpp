@@ -5,6 +5,9 @@
 #define __NETWORK_HOMOMORPH_HPP__
 
 #include "networkMorph.hpp"
+#include "optimizer.hpp"
+#include <algorithm>
+#include <float.h>
 
 // Network homomorph.
 class NetworkHomomorph : public NetworkMorph
@@ -30,12 +33,67 @@ public:
    // Mutate synapses.
    void mutate();
 
+   // Synapse permutation racing schedule.
+   // Permutations are screened on a rotating subset of behaviors, optionally
+   // truncated to a number of steps, and the leading fraction advances to
+   // full evaluation.
+   class RaceSchedule
+   {
+   public:
+      int   behaviors;       // Behaviors per screening subset (-1 = no racing).
+      int   steps;           // Screening steps (-1 = entire sequences).
+      float advance;         // Fraction of permutations advancing to full evaluation.
+      int   auditInterval;   // Fully evaluate all permutations every n races (0 = never).
+
+      // Default audit interval.
+      enum { DEFAULT_AUDIT_INTERVAL = 10 };
+
+      RaceSchedule()
+      {
+         behaviors     = -1;
+         steps         = -1;
+         advance       = 1.0f;
+         auditInterval = DEFAULT_AUDIT_INTERVAL;
+      }
+   };
+
+   // Synapse group optimizer type and evaluation budget (-1 = optimizer default).
+   static int synapseOptimizer;
+   static int synapseOptimizerBudget;
+
    // Optimize synapses.
    void optimize(vector<Behavior *>& behaviors, vector<bool>& fitnessMotorList,
-                 int synapseOptimizedPathLength, int maxStep);
+                 int synapseOptimizedPathLength, int maxStep,
+                 BehaviorTrie *behaviorTrie = NULL,
+                 RaceSchedule *raceSchedule = NULL, int raceIndex = 0);
+
+   // Optimize synapses by gradient descent, with gradients of a smooth
+   // surrogate of the behavior error computed by backpropagation through time.
+   void optimizeGradient(vector<Behavior *>& behaviors, vector<bool>& fitnessMotorList,
+                         int iterations, int maxStep, BehaviorTrie *behaviorTrie = NULL);
+
+   // Default gradient descent iterations.
+   enum { DEFAULT_GRADIENT_ITERATIONS = 10 };
+
+   // Optimization work (behavior steps simulated) and exhaustive evaluation equivalent.
+   long long optimizeWork;
+   long long optimizeFullWork;
+
+   // Racing audit: error loss versus exhaustive evaluation.
+   bool  raceAudited;
+   float raceLoss;
+
+   // Clone, optionally drawing from given randomizer.
+   NetworkHomomorph *clone(int tag = (-1), Random *randomizer = NULL);
+
+   // Reinitialize in place as constructed from homomorph, reusing network storage.
+   void init(Network *homomorph,
+             MutableParm& synapseWeightsParm,
+             vector<vector<pair<int, int> > > *motorConnections,
+             Random *randomizer, int tag = (-1));
 
-   // Clone.
-   NetworkHomomorph *clone(int tag = (-1));
+   // Clone member in place, optionally drawing from given randomizer.
+   void cloneFrom(NetworkHomomorph *member, int tag = (-1), Random *randomizer = NULL);
 
    // Load.
    void load(FilePointer *fp);
@@ -51,17 +109,38 @@ public:
 
 protected:
 
-   // Initialize synapse optimization.
-   void initOptimize(vector<vector<Synapse *> >& synapses,
-                     vector<vector<float> >& permutations, int synapseOptimizedPathLength);
+   // Initialize synapse optimization, returning optimizer for selected
+   // synapse group weights, or NULL if no synapses were selected.
+   Optimizer *initOptimize(vector<vector<Synapse *> >& synapses, int synapseOptimizedPathLength);
+
+   // Race synapse weight permutations, scoring eliminated permutations FLT_MAX.
+   void race(vector<Behavior *>& behaviors, vector<bool>& fitnessMotorList, int maxStep,
+             BehaviorTrie *behaviorTrie, vector<vector<Synapse *> >& synapses, vector<vector<float> >& permutations,
+             RaceSchedule *raceSchedule, int raceIndex, float bestError, vector<float>& scores);
+
+   // Set synapse weight permutation.
+   void setPermutation(vector<vector<Synapse *> >& synapses, vector<float>& permutation);
+
+   // Count behavior steps evaluated.
+   int behaviorSteps(vector<Behavior *>& behaviors, int maxStep);
+
+   // Synapse with source and target neuron indices.
+   struct SynapseEdge
+   {
+      Synapse *synapse;
+      int     source;
+      int     target;
+   };
+
+   // Gradient step halvings before giving up on an iteration.
+   enum { MAX_STEP_HALVINGS = 3 };
+
+   // Compute surrogate error gradient with respect to synapse weights,
+   // returning the largest gradient magnitude.
+   float backpropagate(vector<Behavior *>& behaviors, vector<bool>& fitnessMotorList,
+                       int maxStep, vector<SynapseEdge>& edges, vector<float>& gradient);
 
    // Select random neuron.
    int randomNeuron(bool nonMotor = false);
-
-   // Permute weights.
-   void permuteWeights(vector<vector<float> >& weightRanges,
-                       vector<vector<float> >& permutations,
-                       vector<float>& permutation,
-                       int level, int depth);
 };
 #endif
@@ -1,6 +1,7 @@
 // Network homomorphogenesis implementation.
 
 #include "networkHomomorphoGenesis.hpp"
+#include <stdarg.h>
 #ifdef WIN32
 #include <direct.h>
 #else
@@ -37,6 +38,7 @@ NetworkHomomorphoGenesis::NetworkHomomorphoGenesis(vector<Behavior *>& behaviors
    {
       this->behaviors.push_back(behaviors[i]);
    }
+   compileBehaviors();
    if (fitnessMotorList.size() > 0)
    {
       n = homomorph->numMotors;
@@ -216,12 +218,6 @@ void NetworkHomomorphoGenesis::init(Network *homomorph,
                                     int synapseOptimizedPathLength,
                                     RANDOM randomSeed)
 {
-   int          i, j, k, n, p, q;
-   float        r;
-   NetworkMorph *networkMorph;
-   Network      *network;
-   Synapse      *synapse;
-
    this->randomSeed = randomSeed;
    randomizer       = new Random(randomSeed);
    assert(randomizer != NULL);
@@ -234,54 +230,28 @@ void NetworkHomomorphoGenesis::init(Network *homomorph,
    this->mutationRate    = mutationRate;
    this->synapseCrossoverBondStrength = synapseCrossoverBondStrength;
    this->synapseOptimizedPathLength   = synapseOptimizedPathLength;
+   this->synapseWeightsParm           = synapseWeightsParm;
    getMotorConnections();
+   getSynapseAdjacency();
    generation = 0;
-   for (i = 0; i < populationSize; i++)
-   {
-      if (undulationBehavior)
-      {
-         networkMorph = (NetworkMorph *)new UndulationNetworkHomomorph(
-            undulationMovements, homomorph, synapseWeightsParm,
-            &motorConnections, randomizer, NetworkMorphoGenesis::tagGenerator++);
-      }
-      else if (neuronSimulation)
-      {
-         networkMorph = (NetworkMorph *)new NeuronSimNetworkHomomorph(
-            homomorph, synapseWeightsParm,
-            &motorConnections, randomizer, NetworkMorphoGenesis::tagGenerator++);
-      }
-      else if (c302Simulation)
-      {
-         networkMorph = (NetworkMorph *)new c302SimNetworkHomomorph(
-            homomorph, synapseWeightsParm,
-            &motorConnections, randomizer, NetworkMorphoGenesis::tagGenerator++);
-      }
-      else
-      {
-         networkMorph = (NetworkMorph *)new NetworkHomomorph(
-            homomorph, synapseWeightsParm,
-            &motorConnections, randomizer, NetworkMorphoGenesis::tagGenerator++);
-      }
-      assert(networkMorph != NULL);
-      network = networkMorph->network;
-      n       = network->numNeurons;
-      for (j = 0; j < n; j++)
-      {
-         for (k = 0; k < n; k++)
-         {
-            // Assume that multiple synapses weights between a source and target are equal.
-            r = (float)randomizer->RAND_INTERVAL(
-               synapseWeightsParm.minimum, synapseWeightsParm.maximum);
-            for (p = 0, q = (int)network->synapses[j][k].size(); p < q; p++)
-            {
-               synapse = network->synapses[j][k][p];
-               synapse->setWeight(r);
-            }
-         }
-      }
-      population.push_back(networkMorph);
-   }
-   sigterm = false;
+
+   // Members are built by the morph thread team.
+   sigterm           = false;
+   pipelineOffspring = false;
+   steadyState       = false;
+   island            = NULL;
+   numaPlacement     = false;
+   logBufferSize     = MorphLog::DEFAULT_BUFFER_SIZE;
+   binaryLog         = false;
+   memberPoolSize    = 0;
+   duplicatePolicy   = KEEP_DUPLICATES;
+   timeBudget        = -1;
+   timeBudgetStart   = INVALID_TIME;
+   optimizer         = PERMUTE_OPTIMIZER;
+   optimizerBudget   = -1;
+   duplicateCount    = 0;
+   genomeIndexed     = false;
+   numaMigrationRate = Numa::DEFAULT_MIGRATION_RATE;
 }
 
 
@@ -299,16 +269,33 @@ NetworkHomomorphoGenesis::NetworkHomomorphoGenesis(
    c302ModelSim        = NULL;
    randomizer          = NULL;
    sigterm             = false;
+   pipelineOffspring   = false;
+   steadyState         = false;
+   island              = NULL;
+   numaPlacement       = false;
+   logBufferSize       = MorphLog::DEFAULT_BUFFER_SIZE;
+   binaryLog           = false;
+   memberPoolSize      = 0;
+   duplicatePolicy     = KEEP_DUPLICATES;
+   timeBudget          = -1;
+   timeBudgetStart     = INVALID_TIME;
+   optimizer           = PERMUTE_OPTIMIZER;
+   optimizerBudget     = -1;
+   duplicateCount      = 0;
+   genomeIndexed       = false;
+   numaMigrationRate   = Numa::DEFAULT_MIGRATION_RATE;
    for (i = 0, j = (int)behaviors.size(); i < j; i++)
    {
       this->behaviors.push_back(behaviors[i]);
    }
+   compileBehaviors();
    if (!load(filename, binary))
    {
       fprintf(stderr, "Cannot load morph from file %s\n", filename);
       exit(1);
    }
    getMotorConnections();
+   getSynapseAdjacency();
 }
 
 
@@ -324,12 +311,28 @@ NetworkHomomorphoGenesis::NetworkHomomorphoGenesis(int undulationMovements,
    c302ModelSim = NULL;
    randomizer   = NULL;
    sigterm      = false;
+   pipelineOffspring = false;
+   steadyState       = false;
+   island            = NULL;
+   numaPlacement     = false;
+   logBufferSize     = MorphLog::DEFAULT_BUFFER_SIZE;
+   binaryLog         = false;
+   memberPoolSize    = 0;
+   duplicatePolicy   = KEEP_DUPLICATES;
+   timeBudget        = -1;
+   timeBudgetStart   = INVALID_TIME;
+   optimizer         = PERMUTE_OPTIMIZER;
+   optimizerBudget   = -1;
+   duplicateCount    = 0;
+   genomeIndexed     = false;
+   numaMigrationRate = Numa::DEFAULT_MIGRATION_RATE;
    if (!load(filename, binary))
    {
       fprintf(stderr, "Cannot load morph from file %s\n", filename);
       exit(1);
    }
    getMotorConnections();
+   getSynapseAdjacency();
 }
 
 
@@ -352,12 +355,28 @@ NetworkHomomorphoGenesis::NetworkHomomorphoGenesis(char *neuronExecPath, char *s
    c302ModelSim        = NULL;
    randomizer          = NULL;
    sigterm             = false;
+   pipelineOffspring   = false;
+   steadyState         = false;
+   island              = NULL;
+   numaPlacement       = false;
+   logBufferSize       = MorphLog::DEFAULT_BUFFER_SIZE;
+   binaryLog           = false;
+   memberPoolSize      = 0;
+   duplicatePolicy     = KEEP_DUPLICATES;
+   timeBudget          = -1;
+   timeBudgetStart     = INVALID_TIME;
+   optimizer           = PERMUTE_OPTIMIZER;
+   optimizerBudget     = -1;
+   duplicateCount      = 0;
+   genomeIndexed       = false;
+   numaMigrationRate   = Numa::DEFAULT_MIGRATION_RATE;
    if (!load(filename, binary))
    {
       fprintf(stderr, "Cannot load morph from file %s\n", filename);
       exit(1);
    }
    getMotorConnections();
+   getSynapseAdjacency();
    string workDir = neuronSimDir;
    workDir.append("/model");
    neuronModelSim = new NeuronSim(this->neuronExecPath, workDir, neuronSimHocFile);
@@ -385,12 +404,28 @@ NetworkHomomorphoGenesis::NetworkHomomorphoGenesis(char *jnmlCmdPath, char *simD
    neuronModelSim      = NULL;
    randomizer          = NULL;
    sigterm             = false;
+   pipelineOffspring   = false;
+   steadyState         = false;
+   island              = NULL;
+   numaPlacement       = false;
+   logBufferSize       = MorphLog::DEFAULT_BUFFER_SIZE;
+   binaryLog           = false;
+   memberPoolSize      = 0;
+   duplicatePolicy     = KEEP_DUPLICATES;
+   timeBudget          = -1;
+   timeBudgetStart     = INVALID_TIME;
+   optimizer           = PERMUTE_OPTIMIZER;
+   optimizerBudget     = -1;
+   duplicateCount      = 0;
+   genomeIndexed       = false;
+   numaMigrationRate   = Numa::DEFAULT_MIGRATION_RATE;
    if (!load(filename, binary))
    {
       fprintf(stderr, "Cannot load morph from file %s\n", filename);
       exit(1);
    }
    getMotorConnections();
+   getSynapseAdjacency();
    string workDir = c302SimDir;
    workDir.append("/");
    workDir.append(c302RelativePath);
@@ -405,6 +440,7 @@ NetworkHomomorphoGenesis::NetworkHomomorphoGenesis(char *jnmlCmdPath, char *simD
 // Destructor.
 NetworkHomomorphoGenesis::~NetworkHomomorphoGenesis()
 {
+   clearMemberPool();
    if (undulationBehavior)
    {
       for (int i = 0, j = (int)population.size(); i < j; i++)
@@ -543,6 +579,41 @@ void NetworkHomomorphoGenesis::getMotorConnectionsSub(
 }
 
 
+// Get synapse adjacency of homomorph neurons.
+void NetworkHomomorphoGenesis::getSynapseAdjacency()
+{
+   int       i, j, n;
+   Adjacency adjacency;
+
+   n = homomorph->numNeurons;
+   synapseAdjacency.clear();
+   synapseAdjacency.resize(n);
+   synapseTargets.clear();
+   synapseTargets.resize(n);
+   for (i = 0; i < n; i++)
+   {
+      for (j = 0; j < n; j++)
+      {
+         if (homomorph->synapses[i][j].size() > 0)
+         {
+            synapseTargets[i].push_back(j);
+         }
+         if (j == i)
+         {
+            continue;
+         }
+         adjacency.neuron   = j;
+         adjacency.outgoing = (homomorph->synapses[i][j].size() > 0);
+         adjacency.incoming = (homomorph->synapses[j][i].size() > 0);
+         if (adjacency.outgoing || adjacency.incoming)
+         {
+            synapseAdjacency[i].push_back(adjacency);
+         }
+      }
+   }
+}
+
+
 // Morph networks.
 #ifdef THREADS
 void NetworkHomomorphoGenesis::morph(int numGenerations, int numThreads,
@@ -552,17 +623,35 @@ void NetworkHomomorphoGenesis::morph(int numGenerations, int behaveCutoff,
                                      char *logFile, char *saveFile)
 #endif
 {
-   int i, g, n;
-   int behaveCount;
-   int maxBehaviorStep;
-   UndulationNetworkHomomorph *undulationNetworkMorph;
-   NeuronSimNetworkHomomorph  *neuronSimNetworkMorph;
-   c302SimNetworkHomomorph    *c302SimNetworkMorph;
+   int  i, g, n;
+   int  behaveCount;
+   int  maxBehaviorStep;
+   int  stalls, overflows;
+   TIME breedTime, saveStart;
+#ifdef THREADS
+   bool pinned;
+#endif
 
+   if (timeBudgetStart == INVALID_TIME)
+   {
+      timeBudgetStart = gettime();
+   }
+   budgetDeadline     = timeBudgetStart + ((TIME)timeBudget * 1000);
+   budgetOffspring    = numOffspring;
+   budgetWaveTime     = INVALID_TIME;
+   budgetOverheadTime = budgetSaveTime = 0;
+   genomeIndexed      = false;
    if (logFile != NULL)
    {
-      startMorphLog(logFile);
+      startMorphLog(logFile, binaryLog);
    }
+#ifdef THREADS
+   morphLog = new MorphLog(morphfp, numThreads, logBufferSize, binaryLog && (logFile != NULL));
+#else
+   morphLog = new MorphLog(morphfp, 1, logBufferSize, binaryLog && (logFile != NULL));
+#endif
+   assert(morphLog != NULL);
+   morphLog->attach(0);
 #ifdef THREADS
    if (neuronSimulation)
    {
@@ -579,6 +668,21 @@ void NetworkHomomorphoGenesis::morph(int numGenerations, int behaveCutoff,
    assert(numThreads > 0);
    terminate        = false;
    this->numThreads = numThreads;
+   taskQueue        = new TaskQueue(numThreads);
+   assert(taskQueue != NULL);
+   morphLockHold    = populationLockHold = 0;
+   morphLockCount   = populationLockCount = 0;
+   numa             = NULL;
+   if (numaPlacement)
+   {
+      // Pin threads to node cores and steal tasks within nodes first.
+      numa = new Numa(numThreads, numaMigrationRate);
+      assert(numa != NULL);
+      taskQueue->setNodes(numa->threadNodes);
+      pinned = numa->pin(0);
+      morphLog->print("NUMA nodes=%d, migration rate=%f, pinned=%s\n",
+                      numa->numNodes, numa->migrationRate, pinned ? "true" : "false");
+   }
    if (numThreads > 1)
    {
       if (pthread_barrier_init(&morphBarrier, NULL, numThreads) != 0)
@@ -586,11 +690,18 @@ void NetworkHomomorphoGenesis::morph(int numGenerations, int behaveCutoff,
          fprintf(stderr, "pthread_barrier_init failed, errno=%d\n", errno);
          exit(1);
       }
-      if (pthread_mutex_init(&morphMutex, NULL) != 0)
+      if ((pthread_mutex_init(&morphMutex, NULL) != 0) ||
+          (pthread_mutex_init(&poolMutex, NULL) != 0) ||
+          (pthread_mutex_init(&steadyMutex, NULL) != 0))
       {
          fprintf(stderr, "pthread_mutex_init failed, errno=%d\n", errno);
          exit(1);
       }
+      if (pthread_rwlock_init(&populationLock, NULL) != 0)
+      {
+         fprintf(stderr, "pthread_rwlock_init failed, errno=%d\n", errno);
+         exit(1);
+      }
       threads = new pthread_t[numThreads - 1];
       assert(threads != NULL);
       struct ThreadInfo *info;
@@ -607,7 +718,7 @@ void NetworkHomomorphoGenesis::morph(int numGenerations, int behaveCutoff,
          }
       }
    }
-   fprintf(morphfp, "Threads=%d\n", numThreads);
+   morphLog->print("Threads=%d\n", numThreads);
 #else
    if (neuronSim)
    {
@@ -626,42 +737,53 @@ void NetworkHomomorphoGenesis::morph(int numGenerations, int behaveCutoff,
          }
       }
    }
-   evaluate();
-   sort();
-   fprintf(morphfp, "Generation=%d\n", generation);
-   fprintf(morphfp, "Population:\n");
-   fprintf(morphfp, "Member\tid\t\tfitness\n");
-   if (undulationBehavior)
+   if (behaviorTrie != NULL)
    {
-      for (i = 0, n = (int)population.size(); i < n; i++)
-      {
-         undulationNetworkMorph = (UndulationNetworkHomomorph *)population[i];
-         fprintf(morphfp, "%d\t%d\t\t%f\n", i, undulationNetworkMorph->tag, undulationNetworkMorph->fitness);
-      }
+      morphLog->print("Behavior trie steps=%d/%d\n",
+                      behaviorTrie->trieSteps(), behaviorTrie->behaviorSteps());
    }
-   else if (neuronSimulation)
+   if (!undulationBehavior && !neuronSimulation && !c302Simulation &&
+       (raceSchedule.behaviors != -1))
    {
-      for (i = 0, n = (int)population.size(); i < n; i++)
-      {
-         neuronSimNetworkMorph = (NeuronSimNetworkHomomorph *)population[i];
-         fprintf(morphfp, "%d\t%d\t\t%.2f (%.2f)\n", i, neuronSimNetworkMorph->tag,
-                 neuronSimNetworkMorph->error, neuronSimNetworkMorph->meanError);
-      }
+      morphLog->print("Permutation racing: behaviors=%d, steps=%d, advance=%f, audit interval=%d\n",
+                      raceSchedule.behaviors, raceSchedule.steps, raceSchedule.advance,
+                      raceSchedule.auditInterval);
    }
-   else if (c302Simulation)
+   if (!undulationBehavior && !neuronSimulation && !c302Simulation &&
+       (optimizer == BPTT_OPTIMIZER))
    {
-      for (i = 0, n = (int)population.size(); i < n; i++)
-      {
-         c302SimNetworkMorph = (c302SimNetworkHomomorph *)population[i];
-         fprintf(morphfp, "%d\t%d\t\t%.2f (%.2f)\n", i, c302SimNetworkMorph->tag,
-                 c302SimNetworkMorph->error, c302SimNetworkMorph->meanError);
-      }
+      morphLog->print("Gradient descent optimizer: iterations=%d\n",
+                      optimizerBudget != -1 ? optimizerBudget : (int)NetworkHomomorph::DEFAULT_GRADIENT_ITERATIONS);
    }
-   else
+   if (optimizer == CMAES_OPTIMIZER)
+   {
+      morphLog->print("CMA-ES optimizer: evaluations=%d\n",
+                      optimizerBudget != -1 ? optimizerBudget : (int)CMAESOptimizer::DEFAULT_BUDGET);
+   }
+   if ((optimizer == PERMUTE_OPTIMIZER) && (optimizerBudget != -1))
+   {
+      morphLog->print("Permutation budget: evaluations=%d\n", optimizerBudget);
+   }
+   NetworkHomomorph::synapseOptimizer       = (optimizer == CMAES_OPTIMIZER ? Optimizer::CMAES : Optimizer::GRID);
+   NetworkHomomorph::synapseOptimizerBudget = optimizerBudget;
+   if ((int)population.size() < populationSize)
+   {
+      build();
+   }
+   evaluate();
+   sort();
+   morphLog->print("Generation=%d\n", generation);
+   morphLog->print("Population:\n");
+   morphLog->print("Member\tid\t\tfitness\n");
+   behaveCount = 0;
+   for (i = 0, n = (int)population.size(); i < n; i++)
+   {
+      logMember(MorphEvent::POPULATION, -1, -1, i, population[i]);
+   }
+   if (!undulationBehavior && !neuronSimulation && !c302Simulation)
    {
       for (i = behaveCount = 0, n = (int)population.size(); i < n; i++)
       {
-         fprintf(morphfp, "%d\t%d\t\t%f\n", i, population[i]->tag, population[i]->error);
          if (population[i]->behaves)
          {
             behaveCount++;
@@ -669,105 +791,81 @@ void NetworkHomomorphoGenesis::morph(int numGenerations, int behaveCutoff,
       }
       if (behaviorStep != -1)
       {
-         fprintf(morphfp, "Behavior testing step=%d\n", behaviorStep);
+         morphLog->print("Behavior testing step=%d\n", behaviorStep);
       }
    }
-   fflush(morphfp);
-   for (g = 0; g < numGenerations; g++)
+   if (timeBudget != -1)
    {
-      if (sigterm)
-      {
-         fprintf(morphfp, "Termination signal\n");
-         fflush(morphfp);
-         break;
-      }
-      if ((behaveCutoff != -1) && ((behaviorStep == -1) || (behaviorStep == maxBehaviorStep)))
+      morphLog->print("Time budget=%ds\n", timeBudget);
+   }
+   morphLog->flush();
+   if (steadyState && (numOffspring > 0))
+   {
+      steadyMorph(numGenerations, behaveCutoff, behaveCount, maxBehaviorStep, saveFile);
+   }
+   else
+   {
+      for (g = 0; g < numGenerations; g++)
       {
-         if (behaveCount >= behaveCutoff)
+         if (sigterm)
          {
-            fprintf(morphfp, "Reached behaving member cutoff=%d\n", behaveCutoff);
-            fflush(morphfp);
+            morphLog->print("Termination signal\n");
+            morphLog->flush();
             break;
          }
-      }
-      generation++;
-      fprintf(morphfp, "Generation=%d\n", generation);
-      offspring.resize(numOffspring);
-      mate();
-      mutate();
-      optimize();
-      prune();
-      fprintf(morphfp, "Population:\n");
-      fprintf(morphfp, "Member\tid\t\tfitness\n");
-      if (undulationBehavior)
-      {
-         for (i = 0, n = (int)population.size(); i < n; i++)
+         if ((behaveCutoff != -1) && ((behaviorStep == -1) || (behaviorStep == maxBehaviorStep)))
          {
-            undulationNetworkMorph = (UndulationNetworkHomomorph *)population[i];
-            fprintf(morphfp, "%d\t%d\t\t%f\n", i, undulationNetworkMorph->tag, undulationNetworkMorph->fitness);
+            if (behaveCount >= behaveCutoff)
+            {
+               morphLog->print("Reached behaving member cutoff=%d\n", behaveCutoff);
+               morphLog->flush();
+               break;
+            }
          }
-      }
-      else if (neuronSimulation)
-      {
-         for (i = 0, n = (int)population.size(); i < n; i++)
+         if ((timeBudget != -1) && !budgetGeneration())
          {
-            neuronSimNetworkMorph = (NeuronSimNetworkHomomorph *)population[i];
-            fprintf(morphfp, "%d\t%d\t\t%.2f (%.2f)\n", i, neuronSimNetworkMorph->tag,
-                    neuronSimNetworkMorph->error, neuronSimNetworkMorph->meanError);
+            morphLog->flush();
+            break;
          }
-      }
-      else if (c302Simulation)
-      {
-         for (i = 0, n = (int)population.size(); i < n; i++)
+         generation++;
+         generationStart = gettime();
+         morphLog->print("Generation=%d\n", generation);
+         if (timeBudget != -1)
          {
-            c302SimNetworkMorph = (c302SimNetworkHomomorph *)population[i];
-            fprintf(morphfp, "%d\t%d\t\t%.2f (%.2f)\n", i, c302SimNetworkMorph->tag,
-                    c302SimNetworkMorph->error, c302SimNetworkMorph->meanError);
+            morphLog->print("Time budget remaining=%llums, offspring=%d\n",
+                            budgetDeadline > generationStart ? budgetDeadline - generationStart : 0,
+                            numOffspring);
          }
-      }
-      else
-      {
-         for (i = behaveCount = 0, n = (int)population.size(); i < n; i++)
+         offspring.resize(numOffspring);
+         if (pipelineOffspring && (NetworkMorph::evalFarm == NULL))
          {
-            fprintf(morphfp, "%d\t%d\t\t%f\n", i, population[i]->tag, population[i]->error);
-            if (population[i]->behaves)
-            {
-               behaveCount++;
-            }
+            breed();
          }
-         if (behaviorStep != -1)
+         else
          {
-            fprintf(morphfp, "Behavior testing step=%d\n", behaviorStep);
-            bool maxGenerations = false;
-            if (behaveQuorumMaxGenerations != -1)
-            {
-               behaveQuorumGenerationCount++;
-               if (behaveQuorumGenerationCount >= behaveQuorumMaxGenerations)
-               {
-                  maxGenerations = true;
-                  behaveQuorumGenerationCount = 0;
-               }
-            }
-            if (((behaveCount >= behaveQuorum) || maxGenerations) &&
-                (behaviorStep < maxBehaviorStep))
-            {
-               behaviorStep++;
-               evaluate();
-               sort();
-               for (i = behaveCount = 0, n = (int)population.size(); i < n; i++)
-               {
-                  if (population[i]->behaves)
-                  {
-                     behaveCount++;
-                  }
-               }
-            }
+            mate();
+            mutate();
+            optimize();
+         }
+         breedTime = gettime() - generationStart;
+         prune();
+         numOffspring = budgetOffspring;
+         if ((island != NULL) && ((generation % island->migrationInterval) == 0))
+         {
+            migrate(0);
+         }
+         behaveCount = reportGeneration(population, maxBehaviorStep);
+         saveStart   = gettime();
+         if (saveFile != NULL)
+         {
+            save(saveFile);
+            budgetSaveTime = gettime() - saveStart;
+         }
+         if (timeBudget != -1)
+         {
+            budgetWaveTime     = breedTime / (TIME)budgetWaves;
+            budgetOverheadTime = gettime() - generationStart - breedTime;
          }
-      }
-      fflush(morphfp);
-      if (saveFile != NULL)
-      {
-         save(saveFile);
       }
    }
 
@@ -777,18 +875,37 @@ void NetworkHomomorphoGenesis::morph(int numGenerations, int behaveCutoff,
    {
       // Unblock threads waiting on morph barrier.
       terminate = true;
-      mate(0);
+      runPhase(0);
       for (int i = 0; i < numThreads - 1; i++)
       {
          pthread_join(threads[i], NULL);
          pthread_detach(threads[i]);
       }
       delete threads;
+      pthread_rwlock_destroy(&populationLock);
+      pthread_mutex_destroy(&steadyMutex);
+      pthread_mutex_destroy(&poolMutex);
       pthread_mutex_destroy(&morphMutex);
       pthread_barrier_destroy(&morphBarrier);
    }
+   delete taskQueue;
+   taskQueue = NULL;
+   if (numa != NULL)
+   {
+      delete numa;
+      numa = NULL;
+   }
+   nodeMembers.clear();
 #endif
 
+   // Write remaining log records.
+   morphLog->getStatistics(stalls, overflows);
+   if ((stalls > 0) || (overflows > 0))
+   {
+      morphLog->print("Morph log buffer stalls=%d, early writes=%d\n", stalls, overflows);
+   }
+   delete morphLog;
+   morphLog = NULL;
    if (logFile != NULL)
    {
       stopMorphLog();
@@ -796,101 +913,1351 @@ void NetworkHomomorphoGenesis::morph(int numGenerations, int behaveCutoff,
 }
 
 
-#ifdef THREADS
-// Morphogenesis thread.
-void *NetworkHomomorphoGenesis::morphThread(void *arg)
+// Fit generation offspring to the time budget, returning false if no
+// generation fits. Offspring are created in waves of one per thread: the
+// requested offspring are rounded up to keep all threads busy, and reduced
+// to the waves that fit in the remaining time, reserving time for a final
+// save. The first generation is a one wave probe measuring offspring cost.
+bool NetworkHomomorphoGenesis::budgetGeneration()
 {
-   struct ThreadInfo        *info          = (struct ThreadInfo *)arg;
-   NetworkHomomorphoGenesis *morphoGenesis = info->morphoGenesis;
-   int threadNum = info->threadNum;
+   int  threads, waves, n;
+   TIME now, remaining, generationTime;
 
-   delete info;
-   while (true)
+#ifdef THREADS
+   threads = numThreads;
+#else
+   threads = 1;
+#endif
+   now       = gettime();
+   remaining = budgetDeadline > now ? budgetDeadline - now : 0;
+   if (remaining <= budgetMargin(budgetSaveTime))
    {
-      morphoGenesis->mate(threadNum);
-      morphoGenesis->mutate(threadNum);
-      morphoGenesis->optimize(threadNum);
+      morphLog->print("Time budget reached\n");
+      return(false);
    }
-   return(NULL);
+   remaining -= budgetMargin(budgetSaveTime);
+   n          = ((budgetOffspring + threads - 1) / threads) * threads;
+   if (n > populationSize)
+   {
+      n = populationSize;
+   }
+   waves = (n + threads - 1) / threads;
+   if (budgetWaveTime == INVALID_TIME)
+   {
+      // Probe generation.
+      waves = 1;
+      if (n > threads)
+      {
+         n = threads;
+      }
+   }
+   else
+   {
+      generationTime = budgetMargin(((TIME)waves * budgetWaveTime) + budgetOverheadTime);
+      if (generationTime > remaining)
+      {
+         // Reduce to waves that fit.
+         morphLog->print("Time budget available=%llums, generation=%llums, wave=%llums\n",
+                         remaining, generationTime, budgetWaveTime);
+         if (budgetMargin(budgetWaveTime + budgetOverheadTime) > remaining)
+         {
+            morphLog->print("Time budget reached\n");
+            return(false);
+         }
+         for (waves--; budgetMargin(((TIME)waves * budgetWaveTime) + budgetOverheadTime) > remaining;
+              waves--)
+         {
+         }
+         n = waves * threads;
+      }
+   }
+   numOffspring = n;
+   budgetWaves  = waves;
+   return(true);
 }
 
 
-#endif
+// Time with budget safety margin.
+TIME NetworkHomomorphoGenesis::budgetMargin(TIME time)
+{
+   return(time + ((time * BUDGET_MARGIN_PERCENT) / 100));
+}
 
-// Initialize NEURON evaluation simulations.
-void NetworkHomomorphoGenesis::initNeuronEvaluationSims(int numSims)
+
+// Report generation: log members, advance behavior testing step on quorum,
+// and log cache and thread statistics. Returns number of behaving members.
+// A steady-state report runs while other threads breed: on quorum it stops
+// breeding for the step to be advanced by steadyMorph.
+int NetworkHomomorphoGenesis::reportGeneration(vector<NetworkMorph *>& members,
+                                               int maxBehaviorStep, bool steady)
 {
-   int       n;
-   NeuronSim *evalSim;
-   char      evalDir[BUFSIZ], modelDir[BUFSIZ];
-   char      evalFile[BUFSIZ], modelFile[BUFSIZ];
+   int i, n, behaveCount;
+   unsigned long long cacheLookups, cacheHits;
+   unsigned long long remoteEvaluations, localEvaluations;
+   int  workers, lostWorkers;
+   TIME idleTime, threadTime;
+   int  steals;
 
-   // Remove extra simulations.
-   for (n = (int)neuronEvaluationSims.size(); n > numSims; n--)
+   behaveCount = 0;
+   morphLog->print("Population:\n");
+   morphLog->print("Member\tid\t\tfitness\n");
+   for (i = 0, n = (int)members.size(); i < n; i++)
    {
-      delete neuronEvaluationSims[n - 1];
-      neuronEvaluationSims.pop_back();
+      logMember(MorphEvent::POPULATION, -1, -1, i, members[i]);
    }
-
-#ifdef WIN32
-   WIN32_FIND_DATA fileinfo;
-   HANDLE          hp;
-   sprintf(modelDir, "%s/model", neuronSimDir.c_str());
-   for (int i = n; i < numSims; i++)
+   if (!undulationBehavior && !neuronSimulation && !c302Simulation)
    {
-      sprintf(evalDir, "%s/eval%d", neuronSimDir.c_str(), i);
-
-      // Remove possible stale simulation files.
-      sprintf(evalFile, "%s\\*.*", evalDir);
-      hp = FindFirstFile(evalFile, &fileinfo);
-      if (hp != INVALID_HANDLE_VALUE)
+      for (i = behaveCount = 0, n = (int)members.size(); i < n; i++)
       {
-         while (FindNextFile(hp, &fileinfo))
+         if (members[i]->behaves)
          {
-            if (strcmp(fileinfo.cFileName, "..") != 0)
-            {
-               sprintf(evalFile, "%s\\%s", evalDir, fileinfo.cFileName);
-               DeleteFile(evalFile);
-            }
+            behaveCount++;
          }
-         FindClose(hp);
-         _rmdir(evalDir);
       }
-
-      // Copy fresh model files.
-      _mkdir(evalDir);
-      sprintf(modelFile, "%s\\*.*", modelDir);
-      hp = FindFirstFile(modelFile, &fileinfo);
-      if (hp != INVALID_HANDLE_VALUE)
+      if (behaviorStep != -1)
       {
-         while (FindNextFile(hp, &fileinfo))
+         morphLog->print("Behavior testing step=%d\n", behaviorStep);
+         bool maxGenerations = false;
+         if (behaveQuorumMaxGenerations != -1)
          {
-            if (strcmp(fileinfo.cFileName, "..") != 0)
+            behaveQuorumGenerationCount++;
+            if (behaveQuorumGenerationCount >= behaveQuorumMaxGenerations)
             {
-               sprintf(modelFile, "%s/%s", modelDir, fileinfo.cFileName);
-               sprintf(evalFile, "%s/%s", evalDir, fileinfo.cFileName);
-               CopyFile(modelFile, evalFile, FALSE);
+               maxGenerations = true;
+               behaveQuorumGenerationCount = 0;
+            }
+         }
+         if (((behaveCount >= behaveQuorum) || maxGenerations) &&
+             (behaviorStep < maxBehaviorStep))
+         {
+            if (steady)
+            {
+               steadyRestep = true;
+            }
+            else
+            {
+               behaviorStep++;
+               evaluate();
+               sort();
+               for (i = behaveCount = 0, n = (int)population.size(); i < n; i++)
+               {
+                  if (population[i]->behaves)
+                  {
+                     behaveCount++;
+                  }
+               }
             }
          }
-         FindClose(hp);
       }
-#else
-   char buf[BUFSIZ];
-   sprintf(modelDir, "%s/model", neuronSimDir.c_str());
-   for (int i = n; i < numSims; i++)
+   }
+   if (duplicatePolicy != KEEP_DUPLICATES)
    {
-      sprintf(evalDir, "%s/eval%d", neuronSimDir.c_str(), i);
-
-      // Remove possible stale simulation.
-      sprintf(buf, "/bin/rm -fr %s", evalDir);
-      int result = system(buf);
-
-      // Copy fresh model files.
-      mkdir(evalDir, 0755);
-      sprintf(buf, "/bin/cp -r %s/* %s", modelDir, evalDir);
-      result = system(buf);
-#endif
-      // Add simulation.
+      morphLog->print("Duplicate offspring=%d (%s)\n", (int)duplicateCount,
+                      duplicatePolicy == REUSE_DUPLICATES ? "reused" :
+                      duplicatePolicy == MUTATE_DUPLICATES ? "mutated" : "rejected");
+      duplicateCount = 0;
+   }
+   if (NetworkMorph::fitnessCache != NULL)
+   {
+      NetworkMorph::fitnessCache->getStatistics(cacheLookups, cacheHits);
+      morphLog->print("Fitness cache lookups=%llu, hits=%llu (%.1f%%)\n",
+                      cacheLookups, cacheHits,
+                      cacheLookups > 0 ? ((double)cacheHits * 100.0) / (double)cacheLookups : 0.0);
+      NetworkMorph::fitnessCache->resetStatistics();
+   }
+   if (NetworkMorph::evalFarm != NULL)
+   {
+      NetworkMorph::evalFarm->getStatistics(remoteEvaluations, localEvaluations, workers, lostWorkers);
+      morphLog->print("Evaluation farm workers=%d, lost=%d, remote evaluations=%llu, local=%llu\n",
+                      workers, lostWorkers, remoteEvaluations, localEvaluations);
+      NetworkMorph::evalFarm->resetStatistics();
+   }
+#ifdef THREADS
+   if ((numThreads > 1) && !steadyState)
+   {
+      taskQueue->getStatistics(idleTime, steals);
+      threadTime = (gettime() - generationStart) * (TIME)numThreads;
+      morphLog->print("Thread idle=%llums/%llums (%.1f%%), steals=%d\n",
+                      idleTime, threadTime,
+                      threadTime > 0 ? ((double)idleTime * 100.0) / (double)threadTime : 0.0, steals);
+      taskQueue->resetStatistics();
+   }
+   if (numa != NULL)
+   {
+      vector<int> nodeOffspring;
+      TIME        elapsed = gettime() - generationStart;
+      numa->getStatistics(nodeOffspring);
+      morphLog->print("NUMA node offspring/s:");
+      for (i = 0; i < numa->numNodes; i++)
+      {
+         morphLog->print("%s %d=%.1f", i > 0 ? "," : "", i,
+                         elapsed > 0 ? ((double)nodeOffspring[i] * 1000.0) / (double)elapsed : 0.0);
+      }
+      morphLog->print("\n");
+      numa->resetStatistics();
+   }
+   if (numThreads > 1)
+   {
+      // Steady-state breeding threads update lock statistics under the locks.
+      if (steady)
+      {
+         lockPopulation(true);
+         lockMorph();
+      }
+      TIME morphHold       = morphLockHold;
+      TIME populationHold  = populationLockHold;
+      int  morphCount      = morphLockCount;
+      int  populationCount = populationLockCount;
+      morphLockHold  = populationLockHold = 0;
+      morphLockCount = populationLockCount = 0;
+      if (steady)
+      {
+         unlockMorph();
+         unlockPopulation(true);
+      }
+      if ((morphCount > 0) || (populationCount > 0))
+      {
+         morphLog->print("Lock hold morph=%lluus (%d), population=%lluus (%d)\n",
+                         morphHold, morphCount, populationHold, populationCount);
+      }
+   }
+#endif
+   morphLog->flush();
+   return(behaveCount);
+}
+
+
+// Steady-state morph: threads breed children continuously, each child replacing
+// the worst member, without generational barriers.
+// A generation is counted for each numOffspring children completed.
+void NetworkHomomorphoGenesis::steadyMorph(int numGenerations, int behaveCutoff, int behaveCount,
+                                           int maxBehaviorStep, char *saveFile)
+{
+   int i, n;
+
+   if (sigterm)
+   {
+      morphLog->print("Termination signal\n");
+      morphLog->flush();
+      return;
+   }
+   if ((behaveCutoff != -1) && ((behaviorStep == -1) || (behaviorStep == maxBehaviorStep)) &&
+       (behaveCount >= behaveCutoff))
+   {
+      morphLog->print("Reached behaving member cutoff=%d\n", behaveCutoff);
+      morphLog->flush();
+      return;
+   }
+   if (numGenerations <= 0)
+   {
+      return;
+   }
+   if (parentLongevity != -1)
+   {
+      morphLog->print("Parent longevity is not applied in steady-state evolution\n");
+   }
+   steadyStop            = false;
+   steadyRestep          = false;
+   steadyChildren        = steadyCompleted = 0;
+   steadyFirstGeneration = generation + 1;
+   steadyLastGeneration  = generation + numGenerations;
+   steadyBehaveCutoff    = behaveCutoff;
+   steadyMaxBehaviorStep = maxBehaviorStep;
+   steadySaveFile        = saveFile;
+   generation++;
+   generationStart = gettime();
+   morphLog->print("Generation=%d\n", generation);
+   morphLog->print("Offspring:\n");
+   morphLog->print("Member\tid\t\tfitness\t\tparents\n");
+   morphLog->flush();
+#ifdef THREADS
+   n = numThreads;
+#else
+   n = 1;
+#endif
+   seedOffspringRandomizers(n);
+   if (duplicatePolicy != KEEP_DUPLICATES)
+   {
+      fingerprintPopulation();
+   }
+   do
+   {
+      steadyRestep = false;
+      runPhase(STEADY, n);
+      if (steadyRestep && !sigterm)
+      {
+         // Advance behavior testing step and re-evaluate population with the thread team.
+         behaviorStep++;
+         evaluate();
+         sort();
+         for (i = behaveCount = 0; i < (int)population.size(); i++)
+         {
+            if (population[i]->behaves)
+            {
+               behaveCount++;
+            }
+         }
+         steadyNextGeneration(population, behaveCount);
+      }
+   }
+   while (steadyRestep && !steadyStop && !sigterm);
+   if (sigterm)
+   {
+      morphLog->print("Termination signal\n");
+      morphLog->flush();
+   }
+}
+
+
+// Breed steady-state children until stopped.
+void NetworkHomomorphoGenesis::steadyBreed(int threadNum)
+{
+   int          child, p1, p2, tag, rejects;
+   bool         duplicate, completed;
+   NetworkMorph *offspring;
+   Random       *random;
+
+   random  = offspringRandomizers[threadNum];
+   rejects = 0;
+   while (!steadyStop && !steadyRestep && !sigterm)
+   {
+      // Clone and mate parents from the ranked population.
+      lockPopulation(false);
+      lockMorph();
+      child = steadyChildren++;
+      tag   = NetworkMorphoGenesis::tagGenerator++;
+
+      // Child random stream depends only on child number.
+      random->SRAND_STREAM(randomSeed, (RANDOM)(steadyFirstGeneration + (child / numOffspring)),
+                           (RANDOM)(child % numOffspring));
+      p1 = random->RAND_CHOICE(populationSize);
+      p2 = -1;
+      population[p1]->offspringCount++;
+      if (random->RAND_CHANCE(crossoverRate))
+      {
+         while ((p2 = random->RAND_CHOICE(populationSize)) == p1)
+         {
+         }
+         population[p2]->offspringCount++;
+      }
+      unlockMorph();
+#ifdef THREADS
+      if (numa != NULL)
+      {
+         offspring       = cloneMember(population[p1], tag, random, numa->threadNodes[threadNum]);
+         offspring->node = numa->threadNodes[threadNum];
+      }
+      else
+      {
+         offspring = cloneMember(population[p1], tag, random);
+      }
+#else
+      offspring = cloneMember(population[p1], tag, random);
+#endif
+      if (p2 != -1)
+      {
+         crossoverParents(offspring->network, population[p1]->network,
+                          population[p2]->network, random);
+         p2 = population[p2]->tag;
+      }
+      p1        = population[p1]->tag;
+      duplicate = duplicateMember(offspring);
+      unlockPopulation(false);
+
+      // Reject duplicate, up to the re-mate limit.
+      if (duplicate && (duplicatePolicy == REJECT_DUPLICATES) && (rejects < MAX_REMATES))
+      {
+         rejects++;
+         deleteMember(offspring);
+         continue;
+      }
+      rejects = 0;
+
+      // Mutate, evaluate once and optimize child.
+      // A duplicate keeps its twin's evaluation unless mutated.
+      // A stale child's mutation targets neurons by its parent's motor errors.
+      offspring->stale = ((p2 != -1) && !duplicate);
+      if (random->RAND_CHANCE(mutationRate) ||
+          (duplicate && (duplicatePolicy == MUTATE_DUPLICATES)))
+      {
+         ((NetworkHomomorph *)offspring)->mutate();
+         if (duplicatePolicy != KEEP_DUPLICATES)
+         {
+            lockPopulation(false);
+            duplicate = duplicateMember(offspring);
+            unlockPopulation(false);
+         }
+         offspring->stale = !duplicate;
+      }
+      if (!duplicate)
+      {
+         if (offspring->stale)
+         {
+            evaluateMember(offspring, threadNum);
+         }
+         optimizeMember(offspring, child, threadNum);
+         if (duplicatePolicy != KEEP_DUPLICATES)
+         {
+            offspring->setFingerprint();
+         }
+      }
+
+      // Replace worst member.
+      completed = false;
+      lockPopulation(true);
+      if (steadyStop || steadyRestep)
+      {
+         // Fitness is stale once the behavior testing step is to advance.
+         deleteMember(offspring);
+      }
+      else
+      {
+         steadyInsert(offspring, p1, p2);
+         steadyCompleted++;
+         completed = ((steadyCompleted % numOffspring) == 0);
+      }
+      unlockPopulation(true);
+      if (completed)
+      {
+         steadyGeneration(threadNum);
+      }
+   }
+}
+
+
+// Insert child in rank order, replacing worst member, or discard it if not fitter.
+void NetworkHomomorphoGenesis::steadyInsert(NetworkMorph *child, int parent1, int parent2)
+{
+   int n, rank;
+   bool (*before)(NetworkMorph *, NetworkMorph *);
+   vector<NetworkMorph *>::iterator position;
+
+   if (undulationBehavior)
+   {
+      before = fitterThan;
+   }
+   else
+   {
+      before = ranksBefore;
+   }
+   n    = (int)population.size();
+   rank = -1;
+   if (before(child, population[n - 1]))
+   {
+      unindexGenome(population[n - 1]);
+      deleteMember(population[n - 1]);
+      population.pop_back();
+      position = upper_bound(population.begin(), population.end(), child, before);
+      rank     = (int)(position - population.begin());
+      population.insert(position, child);
+      indexGenome(child);
+   }
+
+   // Log rank (-1 if discarded), id, fitness and parents.
+   logMember(MorphEvent::STEADY, -1, -1, rank, child, parent1, parent2);
+   if (rank == -1)
+   {
+      deleteMember(child);
+   }
+}
+
+
+// Complete steady-state generation while other threads breed: migrate, then
+// report and checkpoint a population snapshot, and start the next generation.
+void NetworkHomomorphoGenesis::steadyGeneration(int threadNum)
+{
+   int                    i, n, behaveCount;
+   vector<NetworkMorph *> snapshot;
+
+   lockSteady();
+   if (!steadyStop && !steadyRestep)
+   {
+      if ((island != NULL) && ((generation % island->migrationInterval) == 0))
+      {
+         migrate(threadNum);
+      }
+      snapshotPopulation(snapshot, threadNum);
+      behaveCount = reportGeneration(snapshot, steadyMaxBehaviorStep, true);
+      if (!steadyRestep)
+      {
+         steadyNextGeneration(snapshot, behaveCount);
+      }
+      for (i = 0, n = (int)snapshot.size(); i < n; i++)
+      {
+         deleteMember(snapshot[i]);
+      }
+   }
+   unlockSteady();
+}
+
+
+// Checkpoint members, check termination and start next steady-state generation.
+void NetworkHomomorphoGenesis::steadyNextGeneration(vector<NetworkMorph *>& members,
+                                                    int behaveCount)
+{
+   TIME now;
+
+   now = gettime();
+   if (steadySaveFile != NULL)
+   {
+      save(steadySaveFile, members);
+      budgetSaveTime = gettime() - now;
+   }
+   now = gettime();
+   if (generation >= steadyLastGeneration)
+   {
+      steadyStop = true;
+   }
+   else if ((steadyBehaveCutoff != -1) &&
+            ((behaviorStep == -1) || (behaviorStep == steadyMaxBehaviorStep)) &&
+            (behaveCount >= steadyBehaveCutoff))
+   {
+      morphLog->print("Reached behaving member cutoff=%d\n", steadyBehaveCutoff);
+      steadyStop = true;
+   }
+   else if ((timeBudget != -1) &&
+            ((now + budgetMargin((now - generationStart) + budgetSaveTime)) > budgetDeadline))
+   {
+      // Another generation and a final save do not fit in the time budget.
+      morphLog->print("Time budget reached\n");
+      steadyStop = true;
+   }
+   else if (!sigterm)
+   {
+      // Inserted children are logged with their generation.
+      lockPopulation(true);
+      generation++;
+      unlockPopulation(true);
+      generationStart = gettime();
+      morphLog->print("Generation=%d\n", generation);
+      morphLog->print("Offspring:\n");
+      morphLog->print("Member\tid\t\tfitness\t\tparents\n");
+   }
+   morphLog->flush();
+}
+
+
+// Snapshot population members, with their evaluations and offspring counts.
+void NetworkHomomorphoGenesis::snapshotPopulation(vector<NetworkMorph *>& snapshot, int threadNum)
+{
+   int          i, n;
+   NetworkMorph *member;
+
+   lockPopulation(false);
+   n = (int)population.size();
+   snapshot.resize(n);
+   for (i = 0; i < n; i++)
+   {
+      member      = population[i];
+      snapshot[i] = cloneMember(member, member->tag, offspringRandomizers[threadNum], member->node);
+      ((NetworkHomomorph *)snapshot[i])->synapseWeightsParm =
+         ((NetworkHomomorph *)member)->synapseWeightsParm;
+      snapshot[i]->error   = member->error;
+      snapshot[i]->behaves = member->behaves;
+   }
+
+   // Offspring counts are updated under the morph mutex.
+   lockMorph();
+   for (i = 0; i < n; i++)
+   {
+      snapshot[i]->offspringCount = population[i]->offspringCount;
+   }
+   unlockMorph();
+   unlockPopulation(false);
+}
+
+
+// Exchange migrants with other islands.
+void NetworkHomomorphoGenesis::migrate(int threadNum)
+{
+   int sent, received, lost;
+
+   sendMigrants();
+   receiveMigrants(threadNum);
+   island->getStatistics(sent, received, lost);
+   morphLog->print("Island migrations sent=%d, received=%d, lost=%d\n", sent, received, lost);
+}
+
+
+// Send copies of top members to target island.
+// Members are encoded with the morph file member format.
+void NetworkHomomorphoGenesis::sendMigrants()
+{
+   int         i, n, format, target;
+   long        size;
+   FILE        *fp;
+   FilePointer *filePointer;
+   vector<unsigned char> message;
+
+   if ((fp = tmpfile()) == NULL)
+   {
+      fprintf(stderr, "Cannot create migrant buffer file\n");
+      return;
+   }
+   filePointer = new FilePointer(fp, true);
+   assert(filePointer != NULL);
+   format = FORMAT;
+   FWRITE_INT(&format, filePointer);
+   FWRITE_INT(&island->index, filePointer);
+   lockPopulation(false);
+   n = island->numMigrants;
+   if (n > (int)population.size())
+   {
+      n = (int)population.size();
+   }
+   FWRITE_INT(&n, filePointer);
+   for (i = 0; i < n; i++)
+   {
+      if (undulationBehavior)
+      {
+         ((UndulationNetworkHomomorph *)population[i])->save(filePointer);
+      }
+      else if (neuronSimulation)
+      {
+         ((NeuronSimNetworkHomomorph *)population[i])->save(filePointer);
+      }
+      else if (c302Simulation)
+      {
+         ((c302SimNetworkHomomorph *)population[i])->save(filePointer);
+      }
+      else
+      {
+         ((NetworkHomomorph *)population[i])->save(filePointer);
+      }
+   }
+   unlockPopulation(false);
+   size = ftell(fp);
+   message.resize(size);
+   rewind(fp);
+   if ((size > 0) && (fread(&message[0], 1, size, fp) != (size_t)size))
+   {
+      fprintf(stderr, "Cannot read migrant buffer file\n");
+      FCLOSE(filePointer);
+      return;
+   }
+   FCLOSE(filePointer);
+   target = island->target(generation, randomSeed);
+   island->send(target, message);
+   morphLog->print("Migrants to island %d: %d\n", target, n);
+}
+
+
+// Receive migrants: each replaces the worst member if it ranks before it.
+// A message whose migrant count or networks do not match this island's
+// morph is discarded.
+void NetworkHomomorphoGenesis::receiveMigrants(int threadNum)
+{
+   int          i, j, n, format, source, tag;
+   bool         valid;
+   FILE         *fp;
+   FilePointer  *filePointer;
+   NetworkMorph *migrant;
+   vector<NetworkMorph *> migrants;
+   vector<unsigned char>  message;
+
+   while (island->receive(message))
+   {
+      if ((fp = tmpfile()) == NULL)
+      {
+         fprintf(stderr, "Cannot create migrant buffer file\n");
+         return;
+      }
+      if ((message.size() > 0) && (fwrite(&message[0], 1, message.size(), fp) != message.size()))
+      {
+         fprintf(stderr, "Cannot write migrant buffer file\n");
+         fclose(fp);
+         return;
+      }
+      rewind(fp);
+      filePointer = new FilePointer(fp, true);
+      assert(filePointer != NULL);
+      format = -1;
+      FREAD_INT(&format, filePointer);
+      if (format != FORMAT)
+      {
+         morphLog->print("Discarded migrants with format %d\n", format);
+         FCLOSE(filePointer);
+         continue;
+      }
+      source = n = -1;
+      FREAD_INT(&source, filePointer);
+      FREAD_INT(&n, filePointer);
+      if ((n < 0) || (n > populationSize))
+      {
+         morphLog->print("Discarded migrants from island %d: count=%d\n", source, n);
+         FCLOSE(filePointer);
+         continue;
+      }
+      migrants.clear();
+      for (i = 0, valid = true; i < n && valid; i++)
+      {
+         if (undulationBehavior)
+         {
+            migrant = new UndulationNetworkHomomorph(filePointer, undulationMovements,
+                                                     &motorConnections, randomizer);
+         }
+         else if (neuronSimulation)
+         {
+            migrant = new NeuronSimNetworkHomomorph(filePointer, &motorConnections, randomizer);
+         }
+         else if (c302Simulation)
+         {
+            migrant = new c302SimNetworkHomomorph(filePointer, &motorConnections, randomizer);
+         }
+         else
+         {
+            migrant = new NetworkHomomorph(filePointer, &motorConnections, randomizer);
+         }
+         assert(migrant != NULL);
+         migrants.push_back(migrant);
+         valid = sameTopology(migrant->network);
+      }
+      if (valid && (ftell(fp) != (long)message.size()))
+      {
+         valid = false;
+      }
+      FCLOSE(filePointer);
+      if (!valid)
+      {
+         morphLog->print("Discarded migrants from island %d: network mismatch\n", source);
+         for (i = 0, n = (int)migrants.size(); i < n; i++)
+         {
+            destroyMember(migrants[i]);
+         }
+         continue;
+      }
+      morphLog->print("Migrants from island %d:\n", source);
+      morphLog->print("Member\tid\t\tfitness\t\tisland id\n");
+      for (i = 0; i < n; i++)
+      {
+         migrant = migrants[i];
+
+         // Evaluate in this island's behavior testing step under a local tag.
+         tag = migrant->tag;
+         lockMorph();
+         migrant->tag = NetworkMorphoGenesis::tagGenerator++;
+         unlockMorph();
+         evaluateMember(migrant, threadNum);
+         lockPopulation(true);
+         population.push_back(migrant);
+         indexGenome(migrant);
+         rank((int)population.size() - 1);
+         for (j = 0; population[j] != migrant; j++)
+         {
+         }
+         if (j == (int)population.size() - 1)
+         {
+            j = -1;
+         }
+         logMember(MorphEvent::MIGRATE, -1, -1, j, migrant, tag);
+         unindexGenome(population.back());
+         deleteMember(population.back());
+         population.pop_back();
+         unlockPopulation(true);
+      }
+   }
+}
+
+
+// Network has the homomorph's neurons and synapse connections.
+bool NetworkHomomorphoGenesis::sameTopology(Network *network)
+{
+   int i, j, n;
+
+   if ((network->numNeurons != homomorph->numNeurons) ||
+       (network->numSensors != homomorph->numSensors) ||
+       (network->numMotors != homomorph->numMotors))
+   {
+      return(false);
+   }
+   n = network->numNeurons;
+   for (i = 0; i < n; i++)
+   {
+      for (j = 0; j < n; j++)
+      {
+         if (network->synapses[i][j].size() != homomorph->synapses[i][j].size())
+         {
+            return(false);
+         }
+      }
+   }
+   return(true);
+}
+
+
+// Delete member, recycling it for new members unless the pool is full.
+void NetworkHomomorphoGenesis::deleteMember(NetworkMorph *member)
+{
+   int node;
+
+#ifdef THREADS
+   if (numThreads > 1)
+   {
+      pthread_mutex_lock(&poolMutex);
+   }
+#endif
+   if (memberPoolSize < (populationSize + numOffspring))
+   {
+      node = member->node;
+      if (node >= (int)memberPool.size())
+      {
+         memberPool.resize(node + 1);
+      }
+      memberPool[node].push_back(member);
+      memberPoolSize++;
+      member = NULL;
+   }
+#ifdef THREADS
+   if (numThreads > 1)
+   {
+      pthread_mutex_unlock(&poolMutex);
+   }
+#endif
+   if (member != NULL)
+   {
+      destroyMember(member);
+   }
+}
+
+
+// Destroy member.
+void NetworkHomomorphoGenesis::destroyMember(NetworkMorph *member)
+{
+   if (undulationBehavior)
+   {
+      delete (UndulationNetworkHomomorph *)member;
+   }
+   else if (neuronSimulation)
+   {
+      delete (NeuronSimNetworkHomomorph *)member;
+   }
+   else if (c302Simulation)
+   {
+      delete (c302SimNetworkHomomorph *)member;
+   }
+   else
+   {
+      delete (NetworkHomomorph *)member;
+   }
+}
+
+
+// Get recycled member, preferably from node, or NULL if none.
+NetworkMorph *NetworkHomomorphoGenesis::recycleMember(int node)
+{
+   NetworkMorph *member = NULL;
+
+#ifdef THREADS
+   if (numThreads > 1)
+   {
+      pthread_mutex_lock(&poolMutex);
+   }
+#endif
+   if (memberPoolSize > 0)
+   {
+      if ((node >= (int)memberPool.size()) || (memberPool[node].size() == 0))
+      {
+         for (node = 0; memberPool[node].size() == 0; node++)
+         {
+         }
+      }
+      member = memberPool[node].back();
+      memberPool[node].pop_back();
+      memberPoolSize--;
+   }
+#ifdef THREADS
+   if (numThreads > 1)
+   {
+      pthread_mutex_unlock(&poolMutex);
+   }
+#endif
+   return(member);
+}
+
+
+// Destroy recycled members.
+void NetworkHomomorphoGenesis::clearMemberPool()
+{
+   for (int i = 0, j = (int)memberPool.size(); i < j; i++)
+   {
+      for (int k = 0, n = (int)memberPool[i].size(); k < n; k++)
+      {
+         destroyMember(memberPool[i][k]);
+      }
+   }
+   memberPool.clear();
+   memberPoolSize = 0;
+}
+
+
+// Lock population for reading or exclusively for updating.
+void NetworkHomomorphoGenesis::lockPopulation(bool exclusive)
+{
+#ifdef THREADS
+   if (numThreads > 1)
+   {
+      if (exclusive)
+      {
+         pthread_rwlock_wrlock(&populationLock);
+         populationLockStart = getmicrotime();
+      }
+      else
+      {
+         pthread_rwlock_rdlock(&populationLock);
+      }
+   }
+#endif
+}
+
+
+void NetworkHomomorphoGenesis::unlockPopulation(bool exclusive)
+{
+#ifdef THREADS
+   if (numThreads > 1)
+   {
+      if (exclusive)
+      {
+         populationLockHold += getmicrotime() - populationLockStart;
+         populationLockCount++;
+      }
+      pthread_rwlock_unlock(&populationLock);
+   }
+#endif
+}
+
+
+// Lock morph mutex, measuring hold time.
+void NetworkHomomorphoGenesis::lockMorph()
+{
+#ifdef THREADS
+   if (numThreads > 1)
+   {
+      pthread_mutex_lock(&morphMutex);
+      morphLockStart = getmicrotime();
+   }
+#endif
+}
+
+
+void NetworkHomomorphoGenesis::unlockMorph()
+{
+#ifdef THREADS
+   if (numThreads > 1)
+   {
+      morphLockHold += getmicrotime() - morphLockStart;
+      morphLockCount++;
+      pthread_mutex_unlock(&morphMutex);
+   }
+#endif
+}
+
+// Lock steady mutex.
+void NetworkHomomorphoGenesis::lockSteady()
+{
+#ifdef THREADS
+   if (numThreads > 1)
+   {
+      pthread_mutex_lock(&steadyMutex);
+   }
+#endif
+}
+
+
+void NetworkHomomorphoGenesis::unlockSteady()
+{
+#ifdef THREADS
+   if (numThreads > 1)
+   {
+      pthread_mutex_unlock(&steadyMutex);
+   }
+#endif
+}
+
+
+#ifdef THREADS
+// Morphogenesis thread.
+void *NetworkHomomorphoGenesis::morphThread(void *arg)
+{
+   struct ThreadInfo        *info          = (struct ThreadInfo *)arg;
+   NetworkHomomorphoGenesis *morphoGenesis = info->morphoGenesis;
+   int threadNum = info->threadNum;
+
+   delete info;
+   morphoGenesis->morphLog->attach(threadNum);
+   if (morphoGenesis->numa != NULL)
+   {
+      morphoGenesis->numa->pin(threadNum);
+   }
+   while (true)
+   {
+      morphoGenesis->runPhase(threadNum);
+   }
+   return(NULL);
+}
+
+
+#endif
+
+// Run phase tasks with thread team.
+void NetworkHomomorphoGenesis::runPhase(PHASE phase, int numTasks)
+{
+   this->phase = phase;
+   phaseTasks  = numTasks;
+#ifdef THREADS
+   taskQueue->reset(numTasks);
+#endif
+   runPhase(0);
+   morphLog->section();
+}
+
+
+void NetworkHomomorphoGenesis::runPhase(int threadNum)
+{
+   int i;
+
+#ifdef THREADS
+   // Synchronize threads.
+   if (numThreads > 1)
+   {
+      i = pthread_barrier_wait(&morphBarrier);
+      if ((i != PTHREAD_BARRIER_SERIAL_THREAD) && (i != 0))
+      {
+         fprintf(stderr, "pthread_barrier_wait failed, errno=%d\n", errno);
+         exit(1);
+      }
+      if (terminate)
+      {
+         if (threadNum == 0)
+         {
+            return;
+         }
+         pthread_exit(NULL);
+      }
+   }
+
+   // Take tasks, stealing from other threads when out of work.
+   for (i = taskQueue->next(threadNum); i != -1; i = taskQueue->next(threadNum))
+   {
+      runTask(i, threadNum);
+   }
+
+   // Re-group threads, measuring idle time.
+   if (numThreads > 1)
+   {
+      TIME idleStart = gettime();
+      pthread_barrier_wait(&morphBarrier);
+      taskQueue->addIdle(threadNum, gettime() - idleStart);
+   }
+#else
+   for (i = 0; i < phaseTasks; i++)
+   {
+      runTask(i, threadNum);
+   }
+#endif
+}
+
+
+// Run phase task.
+void NetworkHomomorphoGenesis::runTask(int index, int threadNum)
+{
+   switch (phase)
+   {
+   case MATE:
+      mateOffspring(index);
+      break;
+
+   case MUTATE:
+      mutateOffspring(index);
+      break;
+
+   case OPTIMIZE:
+      optimizeOffspring(index, threadNum);
+      break;
+
+   case BREED:
+      mateOffspring(index);
+      mutateOffspring(index);
+      optimizeOffspring(index, threadNum);
+      break;
+
+   case BUILD:
+      buildMember(index);
+      break;
+
+   case EVALUATE:
+      evaluateMember(population[index], threadNum);
+      break;
+
+   case REPLACE:
+      replaceMember(index, threadNum);
+      break;
+
+   case STEADY:
+      steadyBreed(threadNum);
+      break;
+   }
+}
+
+
+// Build population.
+// Member random streams and tags depend only on member index.
+void NetworkHomomorphoGenesis::build()
+{
+   population.resize(populationSize, NULL);
+   seedOffspringRandomizers(populationSize);
+   tagBase = NetworkMorphoGenesis::tagGenerator;
+   runPhase(BUILD, populationSize);
+   NetworkMorphoGenesis::tagGenerator = tagBase + populationSize;
+}
+
+
+// Build member with random synapse weights.
+void NetworkHomomorphoGenesis::buildMember(int index)
+{
+   int          j, k, n, p, q;
+   float        r;
+   NetworkMorph *networkMorph;
+   Network      *network;
+   Synapse      *synapse;
+   Random       *random;
+
+   random = offspringRandomizers[index];
+#ifdef THREADS
+   networkMorph = newMember(synapseWeightsParm, random, tagBase + index, offspringNode(index));
+#else
+   networkMorph = newMember(synapseWeightsParm, random, tagBase + index, 0);
+#endif
+   network = networkMorph->network;
+   n       = network->numNeurons;
+   for (j = 0; j < n; j++)
+   {
+      for (k = 0; k < n; k++)
+      {
+         // Assume that multiple synapses weights between a source and target are equal.
+         r = (float)random->RAND_INTERVAL(
+            synapseWeightsParm.minimum, synapseWeightsParm.maximum);
+         for (p = 0, q = (int)network->synapses[j][k].size(); p < q; p++)
+         {
+            synapse = network->synapses[j][k][p];
+            synapse->setWeight(r);
+         }
+      }
+   }
+   population[index] = networkMorph;
+}
+
+
+// Evaluate member with thread's simulator.
+void NetworkHomomorphoGenesis::evaluateMember(NetworkMorph *member, int threadNum)
+{
+   if (undulationBehavior)
+   {
+      ((UndulationNetworkHomomorph *)member)->evaluate();
+   }
+   else if (neuronSimulation)
+   {
+      ((NeuronSimNetworkHomomorph *)member)->evaluate(neuronModelSim, neuronEvaluationSims[threadNum]);
+   }
+   else if (c302Simulation)
+   {
+      ((c302SimNetworkHomomorph *)member)->evaluate(c302ModelSim, c302EvaluationSims[threadNum]);
+   }
+   else
+   {
+      member->evaluate(behaviors, fitnessMotorList, behaviorStep, behaviorTrie);
+   }
+   member->stale = false;
+}
+
+
+// Submit member evaluations to the evaluation farm, keeping several requests
+// in flight while the thread team collects them as it evaluates the members.
+void NetworkHomomorphoGenesis::submitEvaluations(vector<NetworkMorph *>& members, bool staleOnly)
+{
+   if (NetworkMorph::evalFarm == NULL)
+   {
+      return;
+   }
+
+   // Workers evaluate behaviors only: other simulators are rejected with evalFarm.
+   assert(!undulationBehavior && !neuronSimulation && !c302Simulation);
+   for (int i = 0, n = (int)members.size(); i < n; i++)
+   {
+      if (!staleOnly || members[i]->stale)
+      {
+         members[i]->submitEvaluation(behaviors, fitnessMotorList, behaviorStep);
+      }
+   }
+}
+
+
+// Replace longevity-expired member with new member.
+void NetworkHomomorphoGenesis::replaceMember(int index, int threadNum)
+{
+   int          i;
+   NetworkMorph *member;
+   Random       *random;
+
+   i      = replaceIndices[index];
+   member = replacedMembers[index];
+   random = offspringRandomizers[numOffspring + index];
+#ifdef THREADS
+   population[i] = newMember(((NetworkHomomorph *)member)->synapseWeightsParm,
+                             random, tagBase + index, offspringNode(index));
+#else
+   population[i] = newMember(((NetworkHomomorph *)member)->synapseWeightsParm,
+                             random, tagBase + index, 0);
+#endif
+   evaluateMember(population[i], threadNum);
+}
+
+
+// Create homomorph member on node, reusing a recycled member if available.
+NetworkMorph *NetworkHomomorphoGenesis::newMember(MutableParm& synapseWeightsParm,
+                                                  Random *random, int tag, int node)
+{
+   NetworkMorph *member;
+
+   member = recycleMember(node);
+   if (undulationBehavior)
+   {
+      if (member == NULL)
+      {
+         member = (NetworkMorph *)new UndulationNetworkHomomorph(
+            undulationMovements, homomorph, synapseWeightsParm,
+            &motorConnections, random, tag);
+      }
+      else
+      {
+         ((UndulationNetworkHomomorph *)member)->init(
+            undulationMovements, homomorph, synapseWeightsParm,
+            &motorConnections, random, tag);
+      }
+   }
+   else if (neuronSimulation)
+   {
+      if (member == NULL)
+      {
+         member = (NetworkMorph *)new NeuronSimNetworkHomomorph(
+            homomorph, synapseWeightsParm,
+            &motorConnections, random, tag);
+      }
+      else
+      {
+         ((NeuronSimNetworkHomomorph *)member)->init(
+            homomorph, synapseWeightsParm,
+            &motorConnections, random, tag);
+      }
+   }
+   else if (c302Simulation)
+   {
+      if (member == NULL)
+      {
+         member = (NetworkMorph *)new c302SimNetworkHomomorph(
+            homomorph, synapseWeightsParm,
+            &motorConnections, random, tag);
+      }
+      else
+      {
+         ((c302SimNetworkHomomorph *)member)->init(
+            homomorph, synapseWeightsParm,
+            &motorConnections, random, tag);
+      }
+   }
+   else
+   {
+      if (member == NULL)
+      {
+         member = (NetworkMorph *)new NetworkHomomorph(
+            homomorph, synapseWeightsParm,
+            &motorConnections, random, tag);
+      }
+      else
+      {
+         ((NetworkHomomorph *)member)->init(
+            homomorph, synapseWeightsParm,
+            &motorConnections, random, tag);
+      }
+   }
+   assert(member != NULL);
+   member->node = node;
+   return(member);
+}
+
+// Initialize NEURON evaluation simulations.
+void NetworkHomomorphoGenesis::initNeuronEvaluationSims(int numSims)
+{
+   int       n;
+   NeuronSim *evalSim;
+   char      evalDir[BUFSIZ], modelDir[BUFSIZ];
+   char      evalFile[BUFSIZ], modelFile[BUFSIZ];
+
+   // Remove extra simulations.
+   for (n = (int)neuronEvaluationSims.size(); n > numSims; n--)
+   {
+      delete neuronEvaluationSims[n - 1];
+      neuronEvaluationSims.pop_back();
+   }
+
+#ifdef WIN32
+   WIN32_FIND_DATA fileinfo;
+   HANDLE          hp;
+   sprintf(modelDir, "%s/model", neuronSimDir.c_str());
+   for (int i = n; i < numSims; i++)
+   {
+      sprintf(evalDir, "%s/eval%d", neuronSimDir.c_str(), i);
+
+      // Remove possible stale simulation files.
+      sprintf(evalFile, "%s\\*.*", evalDir);
+      hp = FindFirstFile(evalFile, &fileinfo);
+      if (hp != INVALID_HANDLE_VALUE)
+      {
+         while (FindNextFile(hp, &fileinfo))
+         {
+            if (strcmp(fileinfo.cFileName, "..") != 0)
+            {
+               sprintf(evalFile, "%s\\%s", evalDir, fileinfo.cFileName);
+               DeleteFile(evalFile);
+            }
+         }
+         FindClose(hp);
+         _rmdir(evalDir);
+      }
+
+      // Copy fresh model files.
+      _mkdir(evalDir);
+      sprintf(modelFile, "%s\\*.*", modelDir);
+      hp = FindFirstFile(modelFile, &fileinfo);
+      if (hp != INVALID_HANDLE_VALUE)
+      {
+         while (FindNextFile(hp, &fileinfo))
+         {
+            if (strcmp(fileinfo.cFileName, "..") != 0)
+            {
+               sprintf(modelFile, "%s/%s", modelDir, fileinfo.cFileName);
+               sprintf(evalFile, "%s/%s", evalDir, fileinfo.cFileName);
+               CopyFile(modelFile, evalFile, FALSE);
+            }
+         }
+         FindClose(hp);
+      }
+#else
+   char buf[BUFSIZ];
+   sprintf(modelDir, "%s/model", neuronSimDir.c_str());
+   for (int i = n; i < numSims; i++)
+   {
+      sprintf(evalDir, "%s/eval%d", neuronSimDir.c_str(), i);
+
+      // Remove possible stale simulation.
+      sprintf(buf, "/bin/rm -fr %s", evalDir);
+      int result = system(buf);
+
+      // Copy fresh model files.
+      mkdir(evalDir, 0755);
+      sprintf(buf, "/bin/cp -r %s/* %s", modelDir, evalDir);
+      result = system(buf);
+#endif
+      // Add simulation.
       evalSim = new NeuronSim(neuronExecPath, evalDir, neuronSimHocFile);
       assert(evalSim != NULL);
       neuronEvaluationSims.push_back(evalSim);
@@ -981,601 +2348,796 @@ void NetworkHomomorphoGenesis::initc302EvaluationSims(int numSims)
 
 
 // Mate members.
+// Mate and mutate records are logged with optimize records, once
+// offspring are evaluated.
 void NetworkHomomorphoGenesis::mate()
 {
-   fprintf(morphfp, "Mate:\n");
-   fprintf(morphfp, "Member\tid\t\tfitness\t\tparents\n");
-   mate(0);
+   // Offspring random streams and tags depend only on offspring index.
+   assert(populationSize > 1);
+   seedOffspringRandomizers(numOffspring);
+   tagBase = NetworkMorphoGenesis::tagGenerator;
+   offspringParents.assign(numOffspring, make_pair(-1, -1));
+   offspringParentTags.assign(numOffspring, make_pair(-1, -1));
+   offspringMutated.assign(numOffspring, 0);
+   if (duplicatePolicy != KEEP_DUPLICATES)
+   {
+      fingerprintPopulation();
+      offspringDuplicates.assign(numOffspring, 0);
+   }
+#ifdef THREADS
+   shardPopulation();
+#endif
+   runPhase(MATE, numOffspring);
+   NetworkMorphoGenesis::tagGenerator = tagBase + numOffspring;
+   countOffspring();
 }
 
 
-void NetworkHomomorphoGenesis::mate(int threadNum)
+// Count offspring of parents.
+void NetworkHomomorphoGenesis::countOffspring()
 {
-   int     i, j, k, n, p1, p2;
-   Network *parent1, *parent2, *parent, *child;
-   UndulationNetworkHomomorph *undulationNetworkMorph;
-   NeuronSimNetworkHomomorph  *neuronSimNetworkMorph;
-   c302SimNetworkHomomorph    *c302SimNetworkMorph;
+   int i, n;
 
-#ifdef THREADS
-   // Synchronize threads.
-   if (numThreads > 1)
+   for (i = 0, n = (int)offspringParents.size(); i < n; i++)
    {
-      i = pthread_barrier_wait(&morphBarrier);
-      if ((i != PTHREAD_BARRIER_SERIAL_THREAD) && (i != 0))
+      if (offspringParents[i].first != -1)
       {
-         fprintf(stderr, "pthread_barrier_wait failed, errno=%d\n", errno);
-         exit(1);
+         population[offspringParents[i].first]->offspringCount++;
       }
-      if (terminate)
+      if (offspringParents[i].second != -1)
       {
-         if (threadNum == 0)
-         {
-            return;
-         }
-         pthread_exit(NULL);
+         population[offspringParents[i].second]->offspringCount++;
       }
    }
-#endif
+   offspringParents.clear();
+}
 
-   assert(populationSize > 1);
-   for (i = 0; i < numOffspring; i++)
+
+// Mate offspring, marking a crossed-over child's evaluation stale.
+// Under the reject policy a duplicate child is re-mated.
+void NetworkHomomorphoGenesis::mateOffspring(int i)
+{
+   int    p1, p2, remates;
+   Random *random;
+
+   // Parents are only read while mating, so cloning needs no lock.
+   random = offspringRandomizers[i];
+   for (remates = 0; ; remates++)
    {
+      p1 = chooseParent(i, random);
+      p2 = -1;
 #ifdef THREADS
-      // Divide work among threads.
-      if ((i % numThreads) != threadNum)
-      {
-         continue;
-      }
+      offspring[i]       = cloneMember(population[p1], tagBase + i, random, offspringNode(i));
+      offspring[i]->node = offspringNode(i);
+#else
+      offspring[i] = cloneMember(population[p1], tagBase + i, random);
 #endif
 
-      p1      = randomizer->RAND_CHOICE(populationSize);
-      parent1 = population[p1]->network;
-#ifdef THREADS
-      if (numThreads > 1)
+      // Mate parents?
+      if (random->RAND_CHANCE(crossoverRate))
       {
-         pthread_mutex_lock(&morphMutex);
+         while ((p2 = chooseParent(i, random)) == p1)
+         {
+         }
+         crossoverParents(offspring[i]->network, population[p1]->network,
+                          population[p2]->network, random);
       }
-#endif
+      if (!duplicateOffspring(i) || (duplicatePolicy != REJECT_DUPLICATES) ||
+          (remates == MAX_REMATES))
+      {
+         break;
+      }
+      deleteMember(offspring[i]);
+   }
+   offspringParents[i]    = make_pair(p1, p2);
+   offspringParentTags[i] = make_pair(population[p1]->tag, p2 != -1 ? population[p2]->tag : -1);
+
+   // A duplicate keeps its twin's evaluation.
+   offspring[i]->stale = ((p2 != -1) &&
+                          ((duplicatePolicy == KEEP_DUPLICATES) || !offspringDuplicates[i]));
+}
+
+
+// Clone member, reusing a recycled member if available.
+NetworkMorph *NetworkHomomorphoGenesis::cloneMember(NetworkMorph *member, int tag, Random *random, int node)
+{
+   NetworkMorph *clone;
+
+   if ((clone = recycleMember(node)) == NULL)
+   {
       if (undulationBehavior)
       {
-         offspring[i] = (NetworkMorph *)((UndulationNetworkHomomorph *)population[p1])->clone(
-            NetworkMorphoGenesis::tagGenerator++);
+         return((NetworkMorph *)((UndulationNetworkHomomorph *)member)->clone(tag, random));
       }
       else if (neuronSimulation)
       {
-         offspring[i] = (NetworkMorph *)((NeuronSimNetworkHomomorph *)population[p1])->clone(
-            NetworkMorphoGenesis::tagGenerator++);
+         return((NetworkMorph *)((NeuronSimNetworkHomomorph *)member)->clone(tag, random));
       }
       else if (c302Simulation)
       {
-         offspring[i] = (NetworkMorph *)((c302SimNetworkHomomorph *)population[p1])->clone(
-            NetworkMorphoGenesis::tagGenerator++);
+         return((NetworkMorph *)((c302SimNetworkHomomorph *)member)->clone(tag, random));
       }
       else
       {
-         offspring[i] = (NetworkMorph *)((NetworkHomomorph *)population[p1])->clone(
-            NetworkMorphoGenesis::tagGenerator++);
+         return((NetworkMorph *)((NetworkHomomorph *)member)->clone(tag, random));
       }
-      population[p1]->offspringCount++;
+   }
+   if (undulationBehavior)
+   {
+      ((UndulationNetworkHomomorph *)clone)->cloneFrom((UndulationNetworkHomomorph *)member, tag, random);
+   }
+   else if (neuronSimulation)
+   {
+      ((NeuronSimNetworkHomomorph *)clone)->cloneFrom((NeuronSimNetworkHomomorph *)member, tag, random);
+   }
+   else if (c302Simulation)
+   {
+      ((c302SimNetworkHomomorph *)clone)->cloneFrom((c302SimNetworkHomomorph *)member, tag, random);
+   }
+   else
+   {
+      ((NetworkHomomorph *)clone)->cloneFrom((NetworkHomomorph *)member, tag, random);
+   }
+   return(clone);
+}
+
+
+// Choose parent of offspring.
+// With NUMA placement, parents usually come from the offspring's node.
+int NetworkHomomorphoGenesis::chooseParent(int index, Random *random)
+{
 #ifdef THREADS
-      if (numThreads > 1)
+   vector<int> *members;
+
+   if (numa != NULL)
+   {
+      members = &nodeMembers[offspringNode(index)];
+      if ((members->size() > 1) && !random->RAND_CHANCE(numa->migrationRate))
       {
-         pthread_mutex_unlock(&morphMutex);
+         return((*members)[random->RAND_CHOICE((int)members->size())]);
       }
+   }
 #endif
+   return(random->RAND_CHOICE(populationSize));
+}
 
-      // Mate parents?
-      if (randomizer->RAND_CHANCE(crossoverRate))
-      {
-         while ((p2 = randomizer->RAND_CHOICE(populationSize)) == p1)
-         {
-         }
-         population[p2]->offspringCount++;
-         parent2 = population[p2]->network;
-         child   = offspring[i]->network;
-         n       = child->numNeurons;
-         for (k = 0; k < n; k++)
-         {
-            child->neurons[k]->index = -1;
-         }
 
-         // Crossover connected neurons.
-         while (true)
+#ifdef THREADS
+// Shard population members by node.
+void NetworkHomomorphoGenesis::shardPopulation()
+{
+   int i, n;
+
+   if (numa == NULL)
+   {
+      return;
+   }
+   nodeMembers.assign(numa->numNodes, vector<int>());
+   for (i = 0, n = (int)population.size(); i < n; i++)
+   {
+      nodeMembers[population[i]->node % numa->numNodes].push_back(i);
+   }
+}
+
+
+// Node of thread that offspring or member task is dealt to.
+int NetworkHomomorphoGenesis::offspringNode(int index)
+{
+   if (numa == NULL)
+   {
+      return(0);
+   }
+   return(numa->threadNodes[taskQueue->owner(index)]);
+}
+
+
+#endif
+
+// Crossover parents into child cloned from first parent.
+void NetworkHomomorphoGenesis::crossoverParents(Network *child, Network *parent1,
+                                                Network *parent2, Random *random)
+{
+   int     j, k, n;
+   Network *parent;
+
+   vector<CrossoverVisit> visits;
+
+   n = child->numNeurons;
+   for (k = 0; k < n; k++)
+   {
+      child->neurons[k]->index = -1;
+   }
+
+   // Crossover connected neurons.
+   while (true)
+   {
+      j = random->RAND_CHOICE(child->numNeurons);
+      for (k = 0; k < n; k++)
+      {
+         if (child->neurons[j]->index == -1)
          {
-            j = randomizer->RAND_CHOICE(child->numNeurons);
-            for (k = 0; k < n; k++)
+            if (random->RAND_BOOL())
             {
-               if (child->neurons[j]->index == -1)
-               {
-                  if (randomizer->RAND_BOOL())
-                  {
-                     parent = parent1;
-                  }
-                  else
-                  {
-                     parent = parent2;
-                  }
-                  break;
-               }
-               else
-               {
-                  j++;
-                  j = (j % n);
-               }
+               parent = parent1;
             }
-            if (k == n)
+            else
             {
-               break;
+               parent = parent2;
             }
-            crossover(child, parent, j, 0);
-         }
-         if (undulationBehavior)
-         {
-            undulationNetworkMorph = (UndulationNetworkHomomorph *)offspring[i];
-            undulationNetworkMorph->evaluate();
-            fprintf(morphfp, "%d\t%d\t\t%f\t%d %d\n",
-                    i, undulationNetworkMorph->tag, undulationNetworkMorph->fitness,
-                    population[p1]->tag, population[p2]->tag);
-         }
-         else if (neuronSimulation)
-         {
-            neuronSimNetworkMorph = (NeuronSimNetworkHomomorph *)offspring[i];
-            neuronSimNetworkMorph->evaluate(neuronModelSim, neuronEvaluationSims[threadNum]);
-            fprintf(morphfp, "%d\t%d\t\t%.2f (%.2f)\t%d %d\n",
-                    i, neuronSimNetworkMorph->tag, neuronSimNetworkMorph->error,
-                    neuronSimNetworkMorph->meanError, population[p1]->tag, population[p2]->tag);
-         }
-         else if (c302Simulation)
-         {
-            c302SimNetworkMorph = (c302SimNetworkHomomorph *)offspring[i];
-            c302SimNetworkMorph->evaluate(c302ModelSim, c302EvaluationSims[threadNum]);
-            fprintf(morphfp, "%d\t%d\t\t%.2f (%.2f)\t%d %d\n",
-                    i, c302SimNetworkMorph->tag, c302SimNetworkMorph->error,
-                    c302SimNetworkMorph->meanError, population[p1]->tag, population[p2]->tag);
+            break;
          }
          else
          {
-            offspring[i]->evaluate(behaviors, fitnessMotorList, behaviorStep);
-            fprintf(morphfp, "%d\t%d\t\t%f\t%d %d\n", i, offspring[i]->tag, offspring[i]->error,
-                    population[p1]->tag, population[p2]->tag);
+            j++;
+            j = (j % n);
          }
       }
-      else   // No crossover.
+      if (k == n)
       {
-         if (undulationBehavior)
-         {
-            undulationNetworkMorph = (UndulationNetworkHomomorph *)offspring[i];
-            fprintf(morphfp, "%d\t%d\t\t%f\t%d\n",
-                    i, undulationNetworkMorph->tag, undulationNetworkMorph->fitness, population[p1]->tag);
-         }
-         else if (neuronSimulation)
-         {
-            neuronSimNetworkMorph = (NeuronSimNetworkHomomorph *)offspring[i];
-            fprintf(morphfp, "%d\t%d\t\t%.2f (%.2f)\t%d\n",
-                    i, neuronSimNetworkMorph->tag, neuronSimNetworkMorph->error,
-                    neuronSimNetworkMorph->meanError, population[p1]->tag);
-         }
-         else if (c302Simulation)
+         break;
+      }
+      crossover(child, parent, j, visits, random);
+   }
+}
+
+
+// Crossover neurons.
+void NetworkHomomorphoGenesis::crossover(Network *child, Network *parent,
+                                         int index, vector<CrossoverVisit>& visits,
+                                         Random *random)
+{
+   int       i, n;
+   Adjacency adjacency;
+
+   // Neighbors are visited in index order from a random neuron, as a
+   // recursive scan of all neurons would, so random draws are the same.
+   visits.clear();
+   crossoverNeuron(child, parent, index, synapseCrossoverBondStrength, visits, random);
+   while (visits.size() > 0)
+   {
+      CrossoverVisit& visit = visits.back();
+      n = (int)synapseAdjacency[visit.index].size();
+      if (visit.count == n)
+      {
+         visits.pop_back();
+         continue;
+      }
+      i         = (visit.start + visit.count) % n;
+      adjacency = synapseAdjacency[visit.index][i];
+      switch (visit.phase)
+      {
+      case 0:
+         visit.unvisited = (child->neurons[adjacency.neuron]->index == -1);
+         visit.phase     = 1;
+         if (visit.unvisited && adjacency.outgoing && random->RAND_CHANCE(visit.bond))
          {
-            c302SimNetworkMorph = (c302SimNetworkHomomorph *)offspring[i];
-            fprintf(morphfp, "%d\t%d\t\t%.2f (%.2f)\t%d\n",
-                    i, c302SimNetworkMorph->tag, c302SimNetworkMorph->error,
-                    c302SimNetworkMorph->meanError, population[p1]->tag);
+            crossoverNeuron(child, parent, adjacency.neuron,
+                            visit.bond * synapseCrossoverBondStrength, visits, random);
          }
-         else
+         break;
+
+      case 1:
+         visit.phase = 2;
+         if (visit.unvisited && adjacency.incoming && random->RAND_CHANCE(visit.bond))
          {
-            fprintf(morphfp, "%d\t%d\t\t%f\t%d\n", i, offspring[i]->tag, offspring[i]->error, population[p1]->tag);
+            crossoverNeuron(child, parent, adjacency.neuron,
+                            visit.bond * synapseCrossoverBondStrength, visits, random);
          }
+         break;
+
+      default:
+         visit.phase = 0;
+         visit.count++;
+         break;
+      }
+   }
+}
+
+
+// Crossover neuron and its outgoing synapses, and push its neighbor visit.
+void NetworkHomomorphoGenesis::crossoverNeuron(Network *child, Network *parent, int index,
+                                               float bond, vector<CrossoverVisit>& visits,
+                                               Random *random)
+{
+   int                i, j, k, m, n;
+   vector<int>&       targets   = synapseTargets[index];
+   vector<Adjacency>& neighbors = synapseAdjacency[index];
+   vector<Synapse *>  *childSynapses, *parentSynapses;
+   CrossoverVisit     visit;
+
+   child->neurons[index]->index      = index;
+   child->neurons[index]->excitatory = parent->neurons[index]->excitatory;
+   child->neurons[index]->function   = parent->neurons[index]->function;
+   child->neurons[index]->bias       = parent->neurons[index]->bias;
+   child->neurons[index]->activation = parent->neurons[index]->activation;
+   for (i = 0, n = (int)targets.size(); i < n; i++)
+   {
+      m              = targets[i];
+      childSynapses  = &child->synapses[index][m];
+      parentSynapses = &parent->synapses[index][m];
+      for (j = 0, k = (int)childSynapses->size(); j < k; j++)
+      {
+         (*childSynapses)[j]->weight = (*parentSynapses)[j]->weight;
+         (*childSynapses)[j]->signal = (*parentSynapses)[j]->signal;
       }
    }
 
-#ifdef THREADS
-   // Re-group threads.
-   if (numThreads > 1)
+   // Start neighbor visit at random neuron.
+   j = random->RAND_CHOICE(child->numNeurons);
+   i = 0;
+   n = (int)neighbors.size();
+   while ((i < n) && (neighbors[i].neuron < j))
+   {
+      i++;
+   }
+   visit.index     = index;
+   visit.bond      = bond;
+   visit.start     = (n > 0 ? i % n : 0);
+   visit.count     = 0;
+   visit.phase     = 0;
+   visit.unvisited = false;
+   visits.push_back(visit);
+}
+
+
+// Mutate offspring.
+void NetworkHomomorphoGenesis::mutate()
+{
+   runPhase(MUTATE, numOffspring);
+}
+
+
+// Mutate offspring, marking its evaluation stale.
+// A stale child is not evaluated first: its mutation targets neurons by
+// the motor errors inherited from its parent.
+// Under the mutate policy a duplicate child is always mutated.
+void NetworkHomomorphoGenesis::mutateOffspring(int i)
+{
+   if (offspringRandomizers[i]->RAND_CHANCE(mutationRate) ||
+       ((duplicatePolicy == MUTATE_DUPLICATES) && offspringDuplicates[i]))
+   {
+      ((NetworkHomomorph *)offspring[i])->mutate();
+      offspring[i]->stale = !duplicateOffspring(i);
+      offspringMutated[i] = 1;
+   }
+}
+
+
+// Optimize offspring.
+// Records are logged by part in offspring order.
+void NetworkHomomorphoGenesis::optimize()
+{
+   morphLog->record(MATE_RECORDS, -1, "Mate:\n");
+   morphLog->record(MATE_RECORDS, -1, "Member\tid\t\tfitness\t\tparents\n");
+   morphLog->record(MUTATE_RECORDS, -1, "Mutate:\n");
+   morphLog->record(MUTATE_RECORDS, -1, "Member\tid\t\tfitness\n");
+   morphLog->record(OPTIMIZE_RECORDS, -1, "Optimize:\n");
+   morphLog->record(OPTIMIZE_RECORDS, -1, "Member\tid\t\tfitness\n");
+   submitEvaluations(offspring, true);
+   runPhase(OPTIMIZE, numOffspring);
+   reportRacing();
+}
+
+
+// Breed offspring: mate, mutate and optimize each offspring in one task.
+// Records are logged by part in offspring order.
+void NetworkHomomorphoGenesis::breed()
+{
+   morphLog->record(MATE_RECORDS, -1, "Mate:\n");
+   morphLog->record(MATE_RECORDS, -1, "Member\tid\t\tfitness\t\tparents\n");
+   morphLog->record(MUTATE_RECORDS, -1, "Mutate:\n");
+   morphLog->record(MUTATE_RECORDS, -1, "Member\tid\t\tfitness\n");
+   morphLog->record(OPTIMIZE_RECORDS, -1, "Optimize:\n");
+   morphLog->record(OPTIMIZE_RECORDS, -1, "Member\tid\t\tfitness\n");
+   assert(populationSize > 1);
+   seedOffspringRandomizers(numOffspring);
+   tagBase = NetworkMorphoGenesis::tagGenerator;
+   offspringParents.assign(numOffspring, make_pair(-1, -1));
+   offspringParentTags.assign(numOffspring, make_pair(-1, -1));
+   offspringMutated.assign(numOffspring, 0);
+   if (duplicatePolicy != KEEP_DUPLICATES)
    {
-      pthread_barrier_wait(&morphBarrier);
+      fingerprintPopulation();
+      offspringDuplicates.assign(numOffspring, 0);
    }
+#ifdef THREADS
+   shardPopulation();
 #endif
+   runPhase(BREED, numOffspring);
+   NetworkMorphoGenesis::tagGenerator = tagBase + numOffspring;
+   countOffspring();
+   reportRacing();
 }
 
 
-// Crossover neurons.
-void NetworkHomomorphoGenesis::crossover(Network *child, Network *parent,
-                                         int index, int distance)
+// Log offspring record.
+void NetworkHomomorphoGenesis::logRecord(int part, int index, const char *format, ...)
 {
-   int   i, j, k, n;
-   float b;
+   va_list args;
 
-   child->neurons[index]->index      = index;
-   child->neurons[index]->excitatory = parent->neurons[index]->excitatory;
-   child->neurons[index]->function   = parent->neurons[index]->function;
-   child->neurons[index]->bias       = parent->neurons[index]->bias;
-   child->neurons[index]->activation = parent->neurons[index]->activation;
-   for (i = 0, n = child->numNeurons; i < n; i++)
+   va_start(args, format);
+   morphLog->record(part, index, format, args);
+   va_end(args);
+}
+
+
+// Log member event: member index, id, fitness, and parents or replacement.
+void NetworkHomomorphoGenesis::logMember(int type, int part, int index, int member,
+                                         NetworkMorph *networkMorph, int parent1, int parent2,
+                                         NetworkMorph *replacement)
+{
+   MorphEvent event;
+
+   event.type       = (short)type;
+   event.generation = generation;
+   event.member     = member;
+   event.tag        = networkMorph->tag;
+   event.parent1    = parent1;
+   event.parent2    = parent2;
+   event.value      = (short)getMemberValues(networkMorph, event.error,
+                                             event.meanError, event.fitness);
+   if (replacement != NULL)
+   {
+      getMemberValues(replacement, event.replacementError,
+                      event.replacementMeanError, event.replacementFitness);
+   }
+   morphLog->event(part, index, event);
+}
+
+
+// Get member error, mean error and fitness, returning the logged value.
+int NetworkHomomorphoGenesis::getMemberValues(NetworkMorph *member, float& error,
+                                              float& meanError, float& fitness)
+{
+   error = member->error;
+   if (undulationBehavior)
    {
-      for (j = 0, k = (int)child->synapses[index][i].size(); j < k; j++)
-      {
-         child->synapses[index][i][j]->weight = parent->synapses[index][i][j]->weight;
-         child->synapses[index][i][j]->signal = parent->synapses[index][i][j]->signal;
-      }
+      fitness = ((UndulationNetworkHomomorph *)member)->fitness;
+      return(MorphEvent::FITNESS_VALUE);
    }
-
-   // Crossover neighboring neurons.
-   b = synapseCrossoverBondStrength;
-   for (i = 0; i < distance; i++)
+   else if (neuronSimulation)
    {
-      b *= synapseCrossoverBondStrength;
+      meanError = ((NeuronSimNetworkHomomorph *)member)->meanError;
+      return(MorphEvent::MEAN_ERROR_VALUE);
    }
-   j = randomizer->RAND_CHOICE(n);
-   for (i = 0; i < n; i++)
+   else if (c302Simulation)
    {
-      if (child->neurons[j]->index == -1)
+      meanError = ((c302SimNetworkHomomorph *)member)->meanError;
+      return(MorphEvent::MEAN_ERROR_VALUE);
+   }
+   else
+   {
+      return(MorphEvent::ERROR_VALUE);
+   }
+}
+
+// Report racing work reduction and audited quality loss.
+void NetworkHomomorphoGenesis::reportRacing()
+{
+   int              i, audits;
+   double           work, fullWork, loss;
+   NetworkHomomorph *networkMorph;
+
+   if (!undulationBehavior && !neuronSimulation && !c302Simulation &&
+       (raceSchedule.behaviors != -1))
+   {
+      work   = fullWork = loss = 0.0;
+      audits = 0;
+      for (i = 0; i < numOffspring; i++)
       {
-         if (child->synapses[index][j].size() != 0)
-         {
-            if (randomizer->RAND_CHANCE(b))
-            {
-               crossover(child, parent, j, distance + 1);
-            }
-         }
-         if (child->synapses[j][index].size() != 0)
+         networkMorph = (NetworkHomomorph *)offspring[i];
+         work        += (double)networkMorph->optimizeWork;
+         fullWork    += (double)networkMorph->optimizeFullWork;
+         if (networkMorph->raceAudited)
          {
-            if (randomizer->RAND_CHANCE(b))
-            {
-               crossover(child, parent, j, distance + 1);
-            }
+            audits++;
+            loss += (double)networkMorph->raceLoss;
          }
       }
-      j++;
-      j = (j % n);
+      morphLog->print("Racing work=%.0f/%.0f steps (%.1f%%)", work, fullWork,
+                      fullWork > 0.0 ? (work * 100.0) / fullWork : 100.0);
+      if (audits > 0)
+      {
+         morphLog->print(", audits=%d, mean loss=%f", audits, loss / (double)audits);
+      }
+      morphLog->print("\n");
    }
 }
 
 
-// Mutate offspring.
-void NetworkHomomorphoGenesis::mutate()
+// Evaluate stale offspring once, log its mate and mutate records, and optimize it.
+void NetworkHomomorphoGenesis::optimizeOffspring(int i, int threadNum)
 {
-   fprintf(morphfp, "Mutate:\n");
-   fprintf(morphfp, "Member\tid\t\tfitness\n");
-   mutate(0);
+   if (offspring[i]->stale)
+   {
+      evaluateMember(offspring[i], threadNum);
+   }
+   logMember(MorphEvent::MATE, MATE_RECORDS, i, i, offspring[i],
+             offspringParentTags[i].first, offspringParentTags[i].second);
+   if (offspringMutated[i])
+   {
+      logMember(MorphEvent::MUTATE, MUTATE_RECORDS, i, i, offspring[i]);
+   }
+
+   // A duplicate keeps its twin's evaluation.
+   if ((duplicatePolicy == KEEP_DUPLICATES) || !offspringDuplicates[i])
+   {
+      optimizeMember(offspring[i], (generation * numOffspring) + i, threadNum);
+   }
+   logMember(MorphEvent::OPTIMIZE, OPTIMIZE_RECORDS, i, i, offspring[i]);
 }
 
 
-void NetworkHomomorphoGenesis::mutate(int threadNum)
+// Optimize member with thread's simulator.
+void NetworkHomomorphoGenesis::optimizeMember(NetworkMorph *member, int raceIndex, int threadNum)
 {
-   int                        i;
-   NetworkHomomorph           *networkMorph;
-   UndulationNetworkHomomorph *undulationNetworkMorph;
-   NeuronSimNetworkHomomorph  *neuronSimNetworkMorph;
-   c302SimNetworkHomomorph    *c302SimNetworkMorph;
-
+   if (undulationBehavior)
+   {
+      ((UndulationNetworkHomomorph *)member)->optimize(synapseOptimizedPathLength);
+   }
+   else if (neuronSimulation)
+   {
+      ((NeuronSimNetworkHomomorph *)member)->optimize(synapseOptimizedPathLength,
+                                                      neuronModelSim, neuronEvaluationSims[threadNum]);
+   }
+   else if (c302Simulation)
+   {
+      ((c302SimNetworkHomomorph *)member)->optimize(synapseOptimizedPathLength,
+                                                    c302ModelSim, c302EvaluationSims[threadNum]);
+   }
+   else if (optimizer == BPTT_OPTIMIZER)
+   {
+      ((NetworkHomomorph *)member)->optimizeGradient(behaviors, fitnessMotorList,
+                                                     optimizerBudget != -1 ? optimizerBudget :
+                                                     (int)NetworkHomomorph::DEFAULT_GRADIENT_ITERATIONS,
+                                                     behaviorStep, behaviorTrie);
+   }
+   else
+   {
+      ((NetworkHomomorph *)member)->optimize(behaviors, fitnessMotorList,
+                                             synapseOptimizedPathLength, behaviorStep, behaviorTrie,
+                                             &raceSchedule, raceIndex);
+   }
+   member->fingerprinted = false;
 #ifdef THREADS
-   // Re-group threads.
-   if (numThreads > 1)
+   if (numa != NULL)
    {
-      pthread_barrier_wait(&morphBarrier);
+      numa->countOffspring(threadNum);
    }
 #endif
+}
+
 
-   for (i = 0; i < numOffspring; i++)
+// Fingerprint and index population members, if not already indexed.
+void NetworkHomomorphoGenesis::fingerprintPopulation()
+{
+   if (genomeIndexed)
    {
-#ifdef THREADS
-      if ((i % numThreads) != threadNum)
-      {
-         continue;
-      }
-#endif
-      if (undulationBehavior)
-      {
-         undulationNetworkMorph = (UndulationNetworkHomomorph *)offspring[i];
-         if (randomizer->RAND_CHANCE(mutationRate))
-         {
-            undulationNetworkMorph->mutate();
-            undulationNetworkMorph->evaluate();
-            fprintf(morphfp, "%d\t%d\t\t%f\n",
-                    i, undulationNetworkMorph->tag, undulationNetworkMorph->fitness);
-         }
-      }
-      else if (neuronSimulation)
-      {
-         neuronSimNetworkMorph = (NeuronSimNetworkHomomorph *)offspring[i];
-         if (randomizer->RAND_CHANCE(mutationRate))
-         {
-            neuronSimNetworkMorph->mutate();
-            neuronSimNetworkMorph->evaluate(neuronModelSim, neuronEvaluationSims[threadNum]);
-            fprintf(morphfp, "%d\t%d\t\t%.2f (%.2f)\n",
-                    i, neuronSimNetworkMorph->tag, neuronSimNetworkMorph->error,
-                    neuronSimNetworkMorph->meanError);
-         }
-      }
-      else if (c302Simulation)
-      {
-         c302SimNetworkMorph = (c302SimNetworkHomomorph *)offspring[i];
-         if (randomizer->RAND_CHANCE(mutationRate))
-         {
-            c302SimNetworkMorph->mutate();
-            c302SimNetworkMorph->evaluate(c302ModelSim, c302EvaluationSims[threadNum]);
-            fprintf(morphfp, "%d\t%d\t\t%.2f (%.2f)\n",
-                    i, c302SimNetworkMorph->tag, c302SimNetworkMorph->error,
-                    c302SimNetworkMorph->meanError);
-         }
-      }
-      else
-      {
-         networkMorph = (NetworkHomomorph *)offspring[i];
-         if (randomizer->RAND_CHANCE(mutationRate))
-         {
-            networkMorph->mutate();
-            offspring[i]->evaluate(behaviors, fitnessMotorList, behaviorStep);
-            fprintf(morphfp, "%d\t%d\t\t%f\n", i, offspring[i]->tag, offspring[i]->error);
-         }
-      }
+      return;
    }
-
-#ifdef THREADS
-   // Re-group threads.
-   if (numThreads > 1)
+   genomeIndex.clear();
+   genomeIndexed = true;
+   for (int i = 0, n = (int)population.size(); i < n; i++)
    {
-      pthread_barrier_wait(&morphBarrier);
+      indexGenome(population[i]);
    }
-#endif
 }
 
 
-// Optimize offspring.
-void NetworkHomomorphoGenesis::optimize()
+// Index member entering population by genome fingerprint.
+void NetworkHomomorphoGenesis::indexGenome(NetworkMorph *member)
 {
-   fprintf(morphfp, "Optimize:\n");
-   fprintf(morphfp, "Member\tid\t\tfitness\n");
-   optimize(0);
+   if (!genomeIndexed)
+   {
+      return;
+   }
+   if (!member->fingerprinted)
+   {
+      member->setFingerprint();
+   }
+   genomeIndex.insert(make_pair(member->fingerprint.hash1, member));
 }
 
 
-void NetworkHomomorphoGenesis::optimize(int threadNum)
+// Remove member leaving population from genome index.
+void NetworkHomomorphoGenesis::unindexGenome(NetworkMorph *member)
 {
-   int                        i;
-   NetworkHomomorph           *networkMorph;
-   UndulationNetworkHomomorph *undulationNetworkMorph;
-   NeuronSimNetworkHomomorph  *neuronSimNetworkMorph;
-   c302SimNetworkHomomorph    *c302SimNetworkMorph;
+   GenomeIndex::iterator                              entry;
+   pair<GenomeIndex::iterator, GenomeIndex::iterator> entries;
 
-#ifdef THREADS
-   // Re-group threads.
-   if (numThreads > 1)
+   if (!genomeIndexed)
    {
-      pthread_barrier_wait(&morphBarrier);
+      return;
    }
-#endif
-
-   for (i = 0; i < numOffspring; i++)
+   entries = genomeIndex.equal_range(member->fingerprint.hash1);
+   for (entry = entries.first; entry != entries.second; entry++)
    {
-#ifdef THREADS
-      if ((i % numThreads) != threadNum)
-      {
-         continue;
-      }
-#endif
-      if (undulationBehavior)
-      {
-         undulationNetworkMorph = (UndulationNetworkHomomorph *)offspring[i];
-         undulationNetworkMorph->optimize(synapseOptimizedPathLength);
-         fprintf(morphfp, "%d\t%d\t\t%f\n",
-                 i, undulationNetworkMorph->tag, undulationNetworkMorph->fitness);
-      }
-      else if (neuronSimulation)
-      {
-         neuronSimNetworkMorph = (NeuronSimNetworkHomomorph *)offspring[i];
-         neuronSimNetworkMorph->optimize(synapseOptimizedPathLength,
-                                         neuronModelSim, neuronEvaluationSims[threadNum]);
-         fprintf(morphfp, "%d\t%d\t\t%.2f (%.2f)\n",
-                 i, neuronSimNetworkMorph->tag, neuronSimNetworkMorph->error,
-                 neuronSimNetworkMorph->meanError);
-      }
-      else if (c302Simulation)
+      if (entry->second == member)
       {
-         c302SimNetworkMorph = (c302SimNetworkHomomorph *)offspring[i];
-         c302SimNetworkMorph->optimize(synapseOptimizedPathLength,
-                                       c302ModelSim, c302EvaluationSims[threadNum]);
-         fprintf(morphfp, "%d\t%d\t\t%.2f (%.2f)\n",
-                 i, c302SimNetworkMorph->tag, c302SimNetworkMorph->error,
-                 c302SimNetworkMorph->meanError);
+         genomeIndex.erase(entry);
+         return;
       }
-      else
+   }
+}
+
+
+// Check whether member duplicates a fingerprinted population member.
+// A duplicate takes its twin's evaluation.
+bool NetworkHomomorphoGenesis::duplicateMember(NetworkMorph *member)
+{
+   GenomeIndex::iterator                              twin;
+   pair<GenomeIndex::iterator, GenomeIndex::iterator> twins;
+
+   if (duplicatePolicy == KEEP_DUPLICATES)
+   {
+      return(false);
+   }
+   assert(genomeIndexed);
+   member->setFingerprint();
+   twins = genomeIndex.equal_range(member->fingerprint.hash1);
+   for (twin = twins.first; twin != twins.second; twin++)
+   {
+      if (member->sameGenome(twin->second))
       {
-         networkMorph = (NetworkHomomorph *)offspring[i];
-         networkMorph->optimize(behaviors, fitnessMotorList,
-                                synapseOptimizedPathLength, behaviorStep);
-         fprintf(morphfp, "%d\t%d\t\t%f\n", i, offspring[i]->tag, offspring[i]->error);
+         duplicateCount++;
+         copyEvaluation(member, twin->second);
+         return(true);
       }
    }
+   return(false);
+}
 
-#ifdef THREADS
-   // Re-group threads.
-   if (numThreads > 1)
+
+// Check whether offspring duplicates a population member.
+bool NetworkHomomorphoGenesis::duplicateOffspring(int i)
+{
+   if (duplicatePolicy == KEEP_DUPLICATES)
    {
-      pthread_barrier_wait(&morphBarrier);
+      return(false);
+   }
+   offspringDuplicates[i] = duplicateMember(offspring[i]) ? 1 : 0;
+   return(offspringDuplicates[i] == 1);
+}
+
+
+// Copy evaluation of twin member.
+void NetworkHomomorphoGenesis::copyEvaluation(NetworkMorph *member, NetworkMorph *twin)
+{
+   member->error   = twin->error;
+   member->behaves = twin->behaves;
+   member->stale   = false;
+   if (undulationBehavior)
+   {
+      ((UndulationNetworkHomomorph *)member)->fitness = ((UndulationNetworkHomomorph *)twin)->fitness;
+   }
+   else if (neuronSimulation)
+   {
+      ((NeuronSimNetworkHomomorph *)member)->meanError = ((NeuronSimNetworkHomomorph *)twin)->meanError;
+   }
+   else if (c302Simulation)
+   {
+      ((c302SimNetworkHomomorph *)member)->meanError = ((c302SimNetworkHomomorph *)twin)->meanError;
    }
-#endif
 }
 
 
 // Prune members.
 void NetworkHomomorphoGenesis::prune()
 {
-   int                        i, j, n;
-   NetworkHomomorph           *networkMorph;
-   UndulationNetworkHomomorph *undulationNetworkMorph;
-   NeuronSimNetworkHomomorph  *neuronSimNetworkMorph;
-   c302SimNetworkHomomorph    *c302SimNetworkMorph;
+   int                    i, j, k, n, survivors, ranked;
+   vector<NetworkMorph *> members;
 
-   fprintf(morphfp, "Prune:\n");
-   fprintf(morphfp, "Member\tid\t\tfitness\n");
+   morphLog->print("Prune:\n");
+   morphLog->print("Member\tid\t\tfitness\n");
    for (n = (int)population.size(), i = n - numOffspring, j = 0; i < n; i++, j++)
    {
-      if (undulationBehavior)
-      {
-         undulationNetworkMorph = (UndulationNetworkHomomorph *)population[i];
-         fprintf(morphfp, "%d\t%d\t\t%f\n", i, undulationNetworkMorph->tag, undulationNetworkMorph->fitness);
-         delete undulationNetworkMorph;
-      }
-      else if (neuronSimulation)
-      {
-         neuronSimNetworkMorph = (NeuronSimNetworkHomomorph *)population[i];
-         fprintf(morphfp, "%d\t%d\t\t%.2f (%.2f)\n", i, neuronSimNetworkMorph->tag,
-                 neuronSimNetworkMorph->error, neuronSimNetworkMorph->meanError);
-         delete neuronSimNetworkMorph;
-      }
-      else if (c302Simulation)
-      {
-         c302SimNetworkMorph = (c302SimNetworkHomomorph *)population[i];
-         fprintf(morphfp, "%d\t%d\t\t%.2f (%.2f)\n", i, c302SimNetworkMorph->tag,
-                 c302SimNetworkMorph->error, c302SimNetworkMorph->meanError);
-         delete c302SimNetworkMorph;
-      }
-      else
-      {
-         fprintf(morphfp, "%d\t%d\t\t%f\n", i, population[i]->tag, population[i]->error);
-         delete (NetworkHomomorph *)population[i];
-      }
+      logMember(MorphEvent::PRUNE, -1, -1, i, population[i]);
+      unindexGenome(population[i]);
+      deleteMember(population[i]);
       population[i] = offspring[j];
+      indexGenome(population[i]);
    }
    offspring.clear();
+   survivors = ranked = n - numOffspring;
    if (parentLongevity != -1)
    {
-      fprintf(morphfp, "Longevity replace:\n");
-      fprintf(morphfp, "Member\tid\t\told fitness\tnew fitness\n");
+      // Replacement members draw from the streams following the offspring streams.
       for (i = 0; i < n; i++)
       {
          if (population[i]->offspringCount > parentLongevity)
          {
-            if (undulationBehavior)
-            {
-               undulationNetworkMorph = (UndulationNetworkHomomorph *)population[i];
-               fprintf(morphfp, "%d\t%d\t\t%f", i, undulationNetworkMorph->tag, undulationNetworkMorph->fitness);
-               population[i] = (NetworkMorph *)new UndulationNetworkHomomorph(
-                  undulationMovements, homomorph, networkMorph->synapseWeightsParm,
-                  &motorConnections, randomizer, NetworkMorphoGenesis::tagGenerator++);
-               assert(population[i] != NULL);
-               delete undulationNetworkMorph;
-               undulationNetworkMorph = (UndulationNetworkHomomorph *)population[i];
-               undulationNetworkMorph->evaluate();
-               fprintf(morphfp, "\t%f\n", undulationNetworkMorph->fitness);
-            }
-            else if (neuronSimulation)
-            {
-               neuronSimNetworkMorph = (NeuronSimNetworkHomomorph *)population[i];
-               fprintf(morphfp, "%d\t%d\t\t%.2f (%.2f)", i, neuronSimNetworkMorph->tag,
-                       neuronSimNetworkMorph->error, neuronSimNetworkMorph->meanError);
-               population[i] = (NetworkMorph *)new NeuronSimNetworkHomomorph(
-                  homomorph, networkMorph->synapseWeightsParm, &motorConnections,
-                  randomizer, NetworkMorphoGenesis::tagGenerator++);
-               assert(population[i] != NULL);
-               delete neuronSimNetworkMorph;
-               neuronSimNetworkMorph = (NeuronSimNetworkHomomorph *)population[i];
-               neuronSimNetworkMorph->evaluate(neuronModelSim, neuronEvaluationSims[0]);
-               fprintf(morphfp, "\t%.2f (%.2f)\n", neuronSimNetworkMorph->error,
-                       neuronSimNetworkMorph->meanError);
-            }
-            else if (c302Simulation)
+            replaceIndices.push_back(i);
+            replacedMembers.push_back(population[i]);
+         }
+      }
+      k = (int)replaceIndices.size();
+      seedOffspringRandomizers(numOffspring + k);
+      tagBase = NetworkMorphoGenesis::tagGenerator;
+      runPhase(REPLACE, k);
+      NetworkMorphoGenesis::tagGenerator = tagBase + k;
+      morphLog->print("Longevity replace:\n");
+      morphLog->print("Member\tid\t\told fitness\tnew fitness\n");
+      for (j = 0; j < k; j++)
+      {
+         i = replaceIndices[j];
+         logMember(MorphEvent::REPLACE, -1, -1, i, replacedMembers[j], -1, -1, population[i]);
+         unindexGenome(replacedMembers[j]);
+         deleteMember(replacedMembers[j]);
+         indexGenome(population[i]);
+      }
+
+      // Move replacements behind the survivors and offspring for ranking.
+      if (k > 0)
+      {
+         members.clear();
+         ranked = 0;
+         for (i = j = 0; i < n; i++)
+         {
+            if ((j < k) && (replaceIndices[j] == i))
             {
-               c302SimNetworkMorph = (c302SimNetworkHomomorph *)population[i];
-               fprintf(morphfp, "%d\t%d\t\t%.2f (%.2f)", i, c302SimNetworkMorph->tag,
-                       c302SimNetworkMorph->error, c302SimNetworkMorph->meanError);
-               population[i] = (NetworkMorph *)new c302SimNetworkHomomorph(
-                  homomorph, networkMorph->synapseWeightsParm, &motorConnections,
-                  randomizer, NetworkMorphoGenesis::tagGenerator++);
-               assert(population[i] != NULL);
-               delete c302SimNetworkMorph;
-               c302SimNetworkMorph = (c302SimNetworkHomomorph *)population[i];
-               c302SimNetworkMorph->evaluate(c302ModelSim, c302EvaluationSims[0]);
-               fprintf(morphfp, "\t%.2f (%.2f)\n", c302SimNetworkMorph->error,
-                       c302SimNetworkMorph->meanError);
+               j++;
             }
             else
             {
-               fprintf(morphfp, "%d\t%d\t\t%f", i, population[i]->tag, population[i]->error);
-               networkMorph  = (NetworkHomomorph *)population[i];
-               population[i] = (NetworkMorph *)new NetworkHomomorph(
-                  homomorph, networkMorph->synapseWeightsParm, &motorConnections,
-                  randomizer, NetworkMorphoGenesis::tagGenerator++);
-               assert(population[i] != NULL);
-               delete networkMorph;
-               population[i]->evaluate(behaviors, fitnessMotorList, behaviorStep);
-               fprintf(morphfp, "\t%f\n", population[i]->error);
+               if (i < survivors)
+               {
+                  ranked++;
+               }
+               members.push_back(population[i]);
             }
          }
+         for (j = 0; j < k; j++)
+         {
+            members.push_back(population[replaceIndices[j]]);
+         }
+         population = members;
       }
+      replaceIndices.clear();
+      replacedMembers.clear();
    }
-   sort();
+
+   // Rank offspring and replacements into the sorted survivors.
+   rank(ranked);
 }
 
 
 // Evaluate behavior.
 void NetworkHomomorphoGenesis::evaluate()
 {
-   int i, n;
-
-   if (undulationBehavior)
-   {
-      for (i = 0, n = (int)population.size(); i < n; i++)
-      {
-         ((UndulationNetworkHomomorph *)population[i])->evaluate();
-      }
-   }
-   else if (neuronSimulation)
-   {
-      for (i = 0, n = (int)population.size(); i < n; i++)
-      {
-         ((NeuronSimNetworkHomomorph *)population[i])->evaluate(neuronModelSim, neuronEvaluationSims[0]);
-      }
-   }
-   else if (c302Simulation)
-   {
-      for (i = 0, n = (int)population.size(); i < n; i++)
-      {
-         ((c302SimNetworkHomomorph *)population[i])->evaluate(c302ModelSim, c302EvaluationSims[0]);
-      }
-   }
-   else
-   {
-      ((NetworkMorphoGenesis *)this)->evaluate();
-   }
+   submitEvaluations(population, false);
+   runPhase(EVALUATE, (int)population.size());
 }
 
 
 // Sort members by fitness.
 void NetworkHomomorphoGenesis::sort()
 {
-   int i, j, n;
-   UndulationNetworkHomomorph *undulationNetworkMorph1, *undulationNetworkMorph2;
-   NetworkMorph               *networkMorph;
+   rank(0);
+}
 
+
+// Rank members from first index on into the sorted members before it.
+void NetworkHomomorphoGenesis::rank(int first)
+{
    if (undulationBehavior)
    {
-      for (i = 0, n = (int)population.size(); i < n; i++)
-      {
-         undulationNetworkMorph1 = (UndulationNetworkHomomorph *)population[i];
-         for (j = i + 1; j < n; j++)
-         {
-            undulationNetworkMorph2 = (UndulationNetworkHomomorph *)population[j];
-            if (undulationNetworkMorph2->fitness > undulationNetworkMorph1->fitness)
-            {
-               undulationNetworkMorph1 = undulationNetworkMorph2;
-               networkMorph            = population[i];
-               population[i]           = population[j];
-               population[j]           = networkMorph;
-            }
-         }
-      }
+      merge(first, fitterThan);
    }
    else
    {
-      ((NetworkMorphoGenesis *)this)->sort();
+      merge(first, ranksBefore);
    }
 }
 
 
+// Undulation member is fitter than other.
+bool NetworkHomomorphoGenesis::fitterThan(NetworkMorph *member, NetworkMorph *other)
+{
+   return(((UndulationNetworkHomomorph *)member)->fitness >
+          ((UndulationNetworkHomomorph *)other)->fitness);
+}
+
+
 // Load morph.
 bool NetworkHomomorphoGenesis::load(char *filename, bool binary)
 {
@@ -1594,19 +3156,24 @@ bool NetworkHomomorphoGenesis::load(char *filename, bool binary)
 
    // Check format compatibility.
    FREAD_INT(&format, fp);
-   if (format != FORMAT)
+   if ((format != FORMAT) && (format != FORMAT_SHARED_RANDOM))
    {
       fprintf(stderr, "File format %d is incompatible with expected format %d\n", format, FORMAT);
       return(false);
    }
 
+   // Random streams are derived from the random seed and generation.
+   // Earlier formats also stored the shared random state.
    if (randomizer != NULL)
    {
       delete randomizer;
    }
    randomizer = new Random();
    assert(randomizer != NULL);
-   randomizer->RAND_LOAD(fp);
+   if (format == FORMAT_SHARED_RANDOM)
+   {
+      randomizer->RAND_LOAD(fp);
+   }
    homomorph = new Network(fp);
    assert(homomorph != NULL);
    FREAD_FLOAT(&crossoverRate, fp);
@@ -1700,6 +3267,13 @@ bool NetworkHomomorphoGenesis::load(char *filename, bool binary)
 
 // Save morph.
 bool NetworkHomomorphoGenesis::save(char *filename, bool binary)
+{
+   return(save(filename, population, binary));
+}
+
+
+// Save morph with given members.
+bool NetworkHomomorphoGenesis::save(char *filename, vector<NetworkMorph *>& members, bool binary)
 {
    int         i, j, n, format;
    FilePointer *fp;
@@ -1711,7 +3285,6 @@ bool NetworkHomomorphoGenesis::save(char *filename, bool binary)
    }
    format = FORMAT;
    FWRITE_INT(&format, fp);
-   randomizer->RAND_SAVE(fp);
    homomorph->save(fp);
    FWRITE_FLOAT(&crossoverRate, fp);
    FWRITE_FLOAT(&mutationRate, fp);
@@ -1719,34 +3292,34 @@ bool NetworkHomomorphoGenesis::save(char *filename, bool binary)
    FWRITE_INT(&synapseOptimizedPathLength, fp);
    FWRITE_INT(&populationSize, fp);
    FWRITE_INT(&numOffspring, fp);
-   n = (int)population.size();
+   n = (int)members.size();
    FWRITE_INT(&n, fp);
    if (undulationBehavior)
    {
       for (i = 0; i < n; i++)
       {
-         ((UndulationNetworkHomomorph *)population[i])->save(fp);
+         ((UndulationNetworkHomomorph *)members[i])->save(fp);
       }
    }
    else if (neuronSimulation)
    {
       for (i = 0; i < n; i++)
       {
-         ((NeuronSimNetworkHomomorph *)population[i])->save(fp);
+         ((NeuronSimNetworkHomomorph *)members[i])->save(fp);
       }
    }
    else if (c302Simulation)
    {
       for (i = 0; i < n; i++)
       {
-         ((c302SimNetworkHomomorph *)population[i])->save(fp);
+         ((c302SimNetworkHomomorph *)members[i])->save(fp);
       }
    }
    else
    {
       for (i = 0; i < n; i++)
       {
-         ((NetworkHomomorph *)population[i])->save(fp);
+         ((NetworkHomomorph *)members[i])->save(fp);
       }
    }
    FWRITE_INT(&parentLongevity, fp);
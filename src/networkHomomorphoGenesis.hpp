@@ -10,6 +10,11 @@
 #include "neuronSim.hpp"
 #include "c302SimNetworkHomomorph.hpp"
 #include "c302Sim.hpp"
+#include "taskQueue.hpp"
+#include "island.hpp"
+#include "numa.hpp"
+#include "morphLog.hpp"
+#include <unordered_map>
 #ifdef THREADS
 #include <pthread.h>
 #endif
@@ -20,7 +25,8 @@ class NetworkHomomorphoGenesis : public NetworkMorphoGenesis
 public:
 
    // Storage format.
-   enum { FORMAT = 2 };
+   // Format 2 stored the shared random state; format 3 derives random streams.
+   enum { FORMAT = 3, FORMAT_SHARED_RANDOM = 2 };
 
    // Constructor.
    NetworkHomomorphoGenesis(vector<Behavior *>& behaviors,
@@ -106,6 +112,18 @@ public:
    // Synapse optimized path length.
    int synapseOptimizedPathLength;
 
+   // Synapse permutation racing schedule (behaviors evaluation).
+   NetworkHomomorph::RaceSchedule raceSchedule;
+
+   // Synapse optimizer: weight permutations along a synapse path, gradient
+   // descent by backpropagation through time (behaviors evaluation), or
+   // CMA-ES search along a synapse path. The budget limits permutations,
+   // sampling them if exceeded, gradient descent iterations and CMA-ES
+   // evaluations (-1 = optimizer default).
+   enum OPTIMIZER { PERMUTE_OPTIMIZER, BPTT_OPTIMIZER, CMAES_OPTIMIZER };
+   int optimizer;
+   int optimizerBudget;
+
    // Morph networks.
 #ifdef THREADS
    void morph(int numGenerations, int numThreads,
@@ -127,6 +145,47 @@ public:
    // Optimize offspring.
    void optimize();
 
+   // Breed offspring: pipeline mate, mutate and optimize per offspring.
+   // Not used with an evaluation farm, whose requests are submitted per phase.
+   void breed();
+   bool pipelineOffspring;
+
+   // Steady-state evolution: each child replaces the worst member as soon as
+   // it is evaluated, without waiting for the rest of the generation.
+   bool steadyState;
+
+   // Island migration (NULL for a single population).
+   Island *island;
+
+   // Morph log memory budget (kilobytes).
+   int logBufferSize;
+
+   // Write morph log as binary events.
+   bool binaryLog;
+
+   // NUMA-aware thread placement: pin threads to node cores and choose
+   // parents from members created on the offspring's node, except at the
+   // migration rate.
+   bool  numaPlacement;
+   float numaMigrationRate;
+
+   // Duplicate offspring policy: an offspring whose genome fingerprint
+   // matches a member's can keep its evaluation, reuse the member's error
+   // without evaluating or optimizing, be forced to mutate, or be rejected
+   // and re-mated.
+   enum DUPLICATE_POLICY
+   {
+      KEEP_DUPLICATES, REUSE_DUPLICATES, MUTATE_DUPLICATES, REJECT_DUPLICATES
+   };
+   int duplicatePolicy;
+
+   // Wall-clock time budget (seconds, -1 for none): offspring per generation
+   // are fitted to the remaining time, and morphing stops in time for a
+   // final save. The budget is measured from its start time, or from the
+   // start of morphing if INVALID_TIME.
+   int  timeBudget;
+   TIME timeBudgetStart;
+
    // Prune members.
    void prune();
 
@@ -136,6 +195,9 @@ public:
    // Sort population by fitness.
    void sort();
 
+   // Rank members from first index on into the sorted members before it.
+   void rank(int first);
+
    // Load.
    bool load(char *filename, bool binary = false);
 
@@ -164,16 +226,160 @@ private:
    void initNeuronEvaluationSims(int numSims);
    void initc302EvaluationSims(int numSims);
 
-   void mate(int threadNum);
-   void mutate(int threadNum);
-   void optimize(int threadNum);
+   // Synapse weights of built members.
+   MutableParm synapseWeightsParm;
+
+   // Morph phases run by thread team, one task per offspring or member.
+   enum PHASE { MATE, MUTATE, OPTIMIZE, BREED, BUILD, EVALUATE, REPLACE, STEADY };
+   PHASE phase;
+   int   phaseTasks;
+   void runPhase(PHASE phase, int numTasks);
+   void runPhase(int threadNum);
+   void runTask(int index, int threadNum);
+
+   // Offspring operations.
+   void mateOffspring(int index);
+   void mutateOffspring(int index);
+   void optimizeOffspring(int index, int threadNum);
+   void reportRacing();
+
+   // Offspring parent indices (-1 if none), counted after mating.
+   vector<pair<int, int> > offspringParents;
+
+   // Offspring parent tags and mutation, logged once offspring are evaluated.
+   vector<pair<int, int> > offspringParentTags;
+   vector<char>            offspringMutated;
+   void countOffspring();
+   NetworkMorph *cloneMember(NetworkMorph *member, int tag, Random *random, int node = 0);
+   int chooseParent(int index, Random *random);
+   void crossoverParents(Network *child, Network *parent1, Network *parent2, Random *random);
+   void optimizeMember(NetworkMorph *member, int raceIndex, int threadNum);
+
+   // Duplicate offspring detection.
+   // Population members are indexed by genome fingerprint, and the index is
+   // updated as members enter and leave the population.
+   enum { MAX_REMATES = 3 };
+   vector<char> offspringDuplicates;
+   atomic<int>  duplicateCount;
+   typedef unordered_multimap<unsigned long long, NetworkMorph *> GenomeIndex;
+   GenomeIndex  genomeIndex;
+   bool         genomeIndexed;
+   void fingerprintPopulation();
+   void indexGenome(NetworkMorph *member);
+   void unindexGenome(NetworkMorph *member);
+   bool duplicateMember(NetworkMorph *member);
+   bool duplicateOffspring(int index);
+   void copyEvaluation(NetworkMorph *member, NetworkMorph *twin);
+
+   // Undulation member is fitter than other.
+   static bool fitterThan(NetworkMorph *member, NetworkMorph *other);
+
+   // Member operations.
+   void build();
+   void buildMember(int index);
+   void evaluateMember(NetworkMorph *member, int threadNum);
+   void submitEvaluations(vector<NetworkMorph *>& members, bool staleOnly);
+   void replaceMember(int index, int threadNum);
+   NetworkMorph *newMember(MutableParm& synapseWeightsParm, Random *random, int tag, int node);
+   void deleteMember(NetworkMorph *member);
+   void destroyMember(NetworkMorph *member);
+
+   // Deleted members by NUMA node, reused in place for new members and offspring.
+   vector<vector<NetworkMorph *> > memberPool;
+   int                             memberPoolSize;
+   NetworkMorph *recycleMember(int node);
+   void clearMemberPool();
+
+   // Time budget: deadline, requested offspring, and measured offspring wave,
+   // generation overhead and save times (milliseconds).
+   enum { BUDGET_MARGIN_PERCENT = 10 };
+   TIME budgetDeadline;
+   int  budgetOffspring;
+   int  budgetWaves;
+   TIME budgetWaveTime;
+   TIME budgetOverheadTime;
+   TIME budgetSaveTime;
+   bool budgetGeneration();
+   TIME budgetMargin(TIME time);
+
+   // Report generation of members and return behaving member count.
+   // Steady reports run while other threads breed, deferring step advance.
+   int  reportGeneration(vector<NetworkMorph *>& members, int maxBehaviorStep,
+                         bool steady = false);
+   TIME generationStart;
+
+   // Save members.
+   bool save(char *filename, vector<NetworkMorph *>& members, bool binary = false);
+
+   // Steady-state evolution.
+   // Breeding threads hold the population lock exclusively only to insert a
+   // child. The thread completing a generation reports and checkpoints a
+   // snapshot of the population while the others breed on. Advancing the
+   // behavior testing step stops breeding for the thread team to re-evaluate
+   // the population.
+   void steadyMorph(int numGenerations, int behaveCutoff, int behaveCount,
+                    int maxBehaviorStep, char *saveFile);
+   void steadyBreed(int threadNum);
+   void steadyInsert(NetworkMorph *child, int parent1, int parent2);
+   void steadyGeneration(int threadNum);
+   void steadyNextGeneration(vector<NetworkMorph *>& members, int behaveCount);
+   void snapshotPopulation(vector<NetworkMorph *>& snapshot, int threadNum);
+   atomic<bool>  steadyStop;
+   atomic<bool>  steadyRestep;
+   int           steadyChildren;
+   int           steadyCompleted;
+   int           steadyFirstGeneration;
+   int           steadyLastGeneration;
+   int           steadyBehaveCutoff;
+   int           steadyMaxBehaviorStep;
+   char          *steadySaveFile;
+
+   // Exchange migrants with other islands.
+   void migrate(int threadNum);
+   void sendMigrants();
+   void receiveMigrants(int threadNum);
+   bool sameTopology(Network *network);
+
+   // Population lock: shared while breeding, exclusive while replacing.
+   void lockPopulation(bool exclusive);
+   void unlockPopulation(bool exclusive);
+
+   // Morph mutex protecting steady-state counters.
+   void lockMorph();
+   void unlockMorph();
+
+   // Steady mutex completing one steady-state generation at a time.
+   void lockSteady();
+   void unlockSteady();
+
+   // Lock hold times (microseconds) and acquisitions since last report.
+   TIME morphLockStart, morphLockHold;
+   int  morphLockCount;
+   TIME populationLockStart, populationLockHold;
+   int  populationLockCount;
+
+   // Longevity-expired members and their population indices.
+   vector<int>            replaceIndices;
+   vector<NetworkMorph *> replacedMembers;
+
+   // Morph log, with offspring records ordered by part and index.
+   MorphLog *morphLog;
+   enum { MATE_RECORDS, MUTATE_RECORDS, OPTIMIZE_RECORDS };
+   void logRecord(int part, int index, const char *format, ...);
+   void logMember(int type, int part, int index, int member, NetworkMorph *networkMorph,
+                  int parent1 = -1, int parent2 = -1, NetworkMorph *replacement = NULL);
+   int getMemberValues(NetworkMorph *member, float& error, float& meanError, float& fitness);
 
 #ifdef THREADS
    // Threading.
    pthread_barrier_t morphBarrier;
    pthread_mutex_t   morphMutex;
+   pthread_mutex_t   poolMutex;
+   pthread_mutex_t   steadyMutex;
+   pthread_rwlock_t  populationLock;
    pthread_t         *threads;
    int               numThreads;
+   TaskQueue         *taskQueue;
    struct ThreadInfo
    {
       NetworkHomomorphoGenesis *morphoGenesis;
@@ -182,10 +388,44 @@ private:
    static void *morphThread(void *threadInfo);
 
    bool terminate;
+
+   // NUMA placement (NULL if none) and members by node.
+   Numa                 *numa;
+   vector<vector<int> > nodeMembers;
+   void shardPopulation();
+   int  offspringNode(int index);
 #endif
 
-   // Crossover neurons.
-   void crossover(Network *child, Network *parent, int index, int distance);
+   // Synapse adjacency of homomorph neurons: connected neurons in index order
+   // with synapse directions, and targets of outgoing synapses.
+   struct Adjacency
+   {
+      int  neuron;
+      bool outgoing;
+      bool incoming;
+   };
+   vector<vector<Adjacency> > synapseAdjacency;
+   vector<vector<int> >       synapseTargets;
+   void getSynapseAdjacency();
+
+   // Crossover neuron and, by bond strength, its connected neurons,
+   // visited depth-first with an explicit stack.
+   struct CrossoverVisit
+   {
+      int   index;
+      float bond;
+      int   start;
+      int   count;
+      int   phase;
+      bool  unvisited;
+   };
+   void crossover(Network *child, Network *parent, int index,
+                  vector<CrossoverVisit>& visits, Random *random);
+   void crossoverNeuron(Network *child, Network *parent, int index, float bond,
+                        vector<CrossoverVisit>& visits, Random *random);
+
+   // Offspring and member tags are assigned by task index.
+   int tagBase;
 
    // Get motor connections.
    void getMotorConnections();
@@ -513,7 +513,7 @@ void NetworkIsomorph::addIndexedNeuron(int index, bool excitatory)
 
 
 // Clone.
-NetworkIsomorph *NetworkIsomorph::clone(int tag)
+NetworkIsomorph *NetworkIsomorph::clone(int tag, Random *randomizer)
 {
    int             i, n;
    NetworkIsomorph *networkMorph;
@@ -521,7 +521,8 @@ NetworkIsomorph *NetworkIsomorph::clone(int tag)
    networkMorph = new NetworkIsomorph(
       excitatoryNeuronsParm, inhibitoryNeuronsParm,
       synapsePropensitiesParm, synapseWeightsParm,
-      network->numSensors, network->numMotors, randomizer, tag);
+      network->numSensors, network->numMotors,
+      randomizer != NULL ? randomizer : this->randomizer, tag);
    assert(networkMorph != NULL);
    networkMorph->error = error;
    for (i = 0, n = (int)motorErrors.size(); i < n; i++)
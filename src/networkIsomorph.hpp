@@ -27,8 +27,8 @@ public:
    // Mutate.
    void mutate();
 
-   // Clone.
-   NetworkIsomorph *clone(int tag = (-1));
+   // Clone, drawing from randomizer if given.
+   NetworkIsomorph *clone(int tag = (-1), Random *randomizer = NULL);
 
    // Load.
    void load(FilePointer *fp);
@@ -20,6 +20,7 @@ NetworkIsomorphoGenesis::NetworkIsomorphoGenesis(vector<Behavior *>& behaviors,
    {
       this->behaviors.push_back(behaviors[i]);
    }
+   compileBehaviors();
    assert(numOffspring <= populationSize);
    this->populationSize = populationSize;
    this->numOffspring   = numOffspring;
@@ -44,8 +45,8 @@ NetworkIsomorphoGenesis::NetworkIsomorphoGenesis(vector<Behavior *>& behaviors,
    }
    generation = 0;
    assert(behaviors.size() > 0);
-   numSensors = (int)behaviors[0]->sensorSequence[0].size();
-   numMotors  = (int)behaviors[0]->motorSequence[0].size();
+   numSensors = behaviors[0]->sensorSequence.width();
+   numMotors  = behaviors[0]->motorSequence.width();
    for (i = 0; i < populationSize; i++)
    {
       networkMorph = new NetworkIsomorph(excitatoryNeuronsParm, inhibitoryNeuronsParm,
@@ -68,6 +69,7 @@ NetworkIsomorphoGenesis::NetworkIsomorphoGenesis(vector<Behavior *>& behaviors,
    {
       this->behaviors.push_back(behaviors[i]);
    }
+   compileBehaviors();
    if (!load(filename, binary))
    {
       fprintf(stderr, "Cannot load morph from file %s\n", filename);
@@ -99,6 +101,8 @@ void NetworkIsomorphoGenesis::morph(int numGenerations, char *logFile)
    int i, g, n;
    int behaveCount;
    int maxBehaviorStep;
+   TIME generationStart, idleTime, threadTime;
+   int  steals;
 
    if (logFile != NULL)
    {
@@ -109,6 +113,8 @@ void NetworkIsomorphoGenesis::morph(int numGenerations, char *logFile)
    assert(numThreads > 0);
    terminate        = false;
    this->numThreads = numThreads;
+   taskQueue        = new TaskQueue(numThreads);
+   assert(taskQueue != NULL);
    if (numThreads > 1)
    {
       if (pthread_barrier_init(&morphBarrier, NULL, numThreads) != 0)
@@ -116,11 +122,6 @@ void NetworkIsomorphoGenesis::morph(int numGenerations, char *logFile)
          fprintf(stderr, "pthread_barrier_init failed, errno=%d\n", errno);
          exit(1);
       }
-      if (pthread_mutex_init(&morphMutex, NULL) != 0)
-      {
-         fprintf(stderr, "pthread_mutex_init failed, errno=%d\n", errno);
-         exit(1);
-      }
       threads = new pthread_t[numThreads - 1];
       assert(threads != NULL);
       struct ThreadInfo *info;
@@ -150,6 +151,11 @@ void NetworkIsomorphoGenesis::morph(int numGenerations, char *logFile)
          }
       }
    }
+   if (behaviorTrie != NULL)
+   {
+      fprintf(morphfp, "Behavior trie steps=%d/%d\n",
+              behaviorTrie->trieSteps(), behaviorTrie->behaviorSteps());
+   }
    evaluate();
    sort();
    fprintf(morphfp, "Generation=%d\n", generation);
@@ -167,6 +173,7 @@ void NetworkIsomorphoGenesis::morph(int numGenerations, char *logFile)
    for (g = 0; g < numGenerations; g++)
    {
       generation++;
+      generationStart = gettime();
       fprintf(morphfp, "Generation=%d\n", generation);
       mutate();
       prune();
@@ -201,6 +208,17 @@ void NetworkIsomorphoGenesis::morph(int numGenerations, char *logFile)
             sort();
          }
       }
+#ifdef THREADS
+      if (numThreads > 1)
+      {
+         taskQueue->getStatistics(idleTime, steals);
+         threadTime = (gettime() - generationStart) * (TIME)numThreads;
+         fprintf(morphfp, "Thread idle=%llums/%llums (%.1f%%), steals=%d\n",
+                 idleTime, threadTime,
+                 threadTime > 0 ? ((double)idleTime * 100.0) / (double)threadTime : 0.0, steals);
+         taskQueue->resetStatistics();
+      }
+#endif
       fflush(morphfp);
    }
 
@@ -217,9 +235,10 @@ void NetworkIsomorphoGenesis::morph(int numGenerations, char *logFile)
          pthread_detach(threads[i]);
       }
       delete threads;
-      pthread_mutex_destroy(&morphMutex);
       pthread_barrier_destroy(&morphBarrier);
    }
+   delete taskQueue;
+   taskQueue = NULL;
 #endif
 
    if (logFile != NULL)
@@ -254,13 +273,24 @@ void NetworkIsomorphoGenesis::mutate()
 {
    fprintf(morphfp, "Mutate:\n");
    fprintf(morphfp, "Member\tid\t\tfitness\n");
+
+   // Offspring tags and random streams are assigned by slot, so cloning
+   // needs no lock.
+   offspring.resize(numOffspring);
+   seedOffspringRandomizers(numOffspring);
+   tagBase = NetworkMorphoGenesis::tagGenerator;
+   NetworkMorphoGenesis::tagGenerator = tagBase + numOffspring;
+#ifdef THREADS
+   taskQueue->reset(numOffspring);
+#endif
    mutate(0);
 }
 
 
 void NetworkIsomorphoGenesis::mutate(int threadNum)
 {
-   int i, j;
+   int    i, j;
+   Random *random;
 
 #ifdef THREADS
    // Synchronize threads.
@@ -283,42 +313,28 @@ void NetworkIsomorphoGenesis::mutate(int threadNum)
    }
 #endif
 
-   offspring.resize(numOffspring);
-   for (i = 0; i < numOffspring; i++)
-   {
-#ifdef THREADS
-      // Divide work among threads.
-      if ((i % numThreads) != threadNum)
-      {
-         continue;
-      }
-#endif
-
-      j = randomizer->RAND_CHOICE(populationSize);
-#ifdef THREADS
-      if (numThreads > 1)
-      {
-         pthread_mutex_lock(&morphMutex);
-      }
-#endif
-      offspring[i] = (NetworkMorph *)((NetworkIsomorph *)population[j])->clone(
-         NetworkMorphoGenesis::tagGenerator++);
 #ifdef THREADS
-      if (numThreads > 1)
-      {
-         pthread_mutex_unlock(&morphMutex);
-      }
+   // Take offspring tasks, stealing from other threads when out of work.
+   for (i = taskQueue->next(threadNum); i != -1; i = taskQueue->next(threadNum))
+#else
+   for (i = 0; i < numOffspring; i++)
 #endif
+   {
+      random       = offspringRandomizers[i];
+      j            = random->RAND_CHOICE(populationSize);
+      offspring[i] = (NetworkMorph *)((NetworkIsomorph *)population[j])->clone(tagBase + i, random);
       ((NetworkIsomorph *)offspring[i])->mutate();
-      offspring[i]->evaluate(behaviors, behaviorStep);
+      offspring[i]->evaluate(behaviors, behaviorStep, behaviorTrie);
       fprintf(morphfp, "%d\t%d\t\t%f\n", i, offspring[i]->tag, offspring[i]->error);
    }
 
 #ifdef THREADS
-   // Re-group threads.
+   // Re-group threads, measuring idle time.
    if (numThreads > 1)
    {
+      TIME idleStart = gettime();
       pthread_barrier_wait(&morphBarrier);
+      taskQueue->addIdle(threadNum, gettime() - idleStart);
    }
 #endif
 }
@@ -338,7 +354,9 @@ void NetworkIsomorphoGenesis::prune()
       population[i] = offspring[j];
    }
    offspring.clear();
-   sort();
+
+   // Rank offspring into the sorted survivors.
+   merge(n - numOffspring);
 }
 
 
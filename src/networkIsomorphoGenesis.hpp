@@ -5,6 +5,7 @@
 
 #include "networkMorphoGenesis.hpp"
 #include "networkIsomorph.hpp"
+#include "taskQueue.hpp"
 #ifdef THREADS
 #include <pthread.h>
 #endif
@@ -57,12 +58,15 @@ private:
 
    void mutate(int threadNum);
 
+   // First offspring tag of generation.
+   int tagBase;
+
 #ifdef THREADS
    // Threading.
    pthread_barrier_t morphBarrier;
-   pthread_mutex_t   morphMutex;
    pthread_t         *threads;
    int               numThreads;
+   TaskQueue         *taskQueue;
    struct ThreadInfo
    {
       NetworkIsomorphoGenesis *morphoGenesis;
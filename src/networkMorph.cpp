@@ -5,33 +5,159 @@
 // Maximum tolerated motor output error.
 const float NetworkMorph::MAX_ERROR_TOLERANCE = 0.05f;
 
+// Shared fitness cache.
+FitnessCache *NetworkMorph::fitnessCache = NULL;
+
+// Distributed evaluation farm.
+EvalFarm *NetworkMorph::evalFarm = NULL;
+
 // Constructor.
-NetworkMorph::NetworkMorph()
+NetworkMorph::NetworkMorph() : fingerprint('G')
 {
    network        = NULL;
    tag            = 0;
    error          = 0.0f;
    behaves        = false;
    offspringCount = 0;
+   stale          = false;
+   node           = 0;
+   fingerprinted  = false;
+   farmRequest    = -1;
+}
+
+
+// Set genome fingerprint.
+void NetworkMorph::setFingerprint()
+{
+   FitnessCache::Key key('G');
+
+   key.add(network);
+   fingerprint   = key;
+   fingerprinted = true;
+}
+
+
+// Do fingerprinted members have the same genome?
+bool NetworkMorph::sameGenome(NetworkMorph *member)
+{
+   return(fingerprinted && member->fingerprinted &&
+          (fingerprint.hash1 == member->fingerprint.hash1) &&
+          (fingerprint.hash2 == member->fingerprint.hash2));
 }
 
 
 // Evaluate behavior.
-void NetworkMorph::evaluate(vector<Behavior *>& behaviors, int maxStep)
+void NetworkMorph::evaluate(vector<Behavior *>& behaviors, int maxStep,
+                            BehaviorTrie *behaviorTrie)
 {
    vector<bool> fitnessMotorList;
-   evaluate(behaviors, fitnessMotorList, maxStep);
+   evaluate(behaviors, fitnessMotorList, maxStep, behaviorTrie);
 }
 
 
 void NetworkMorph::evaluate(vector<Behavior *>& behaviors,
-                            vector<bool>& fitnessMotorList, int maxStep)
+                            vector<bool>& fitnessMotorList, int maxStep,
+                            BehaviorTrie *behaviorTrie)
+{
+   bool remote;
+
+   FitnessCache::Key   cacheKey('B');
+   FitnessCache::Value cacheValue;
+
+   if (fitnessCache != NULL)
+   {
+      getCacheKey(cacheKey, behaviors, fitnessMotorList, maxStep);
+      if ((farmRequest == -1) && fitnessCache->lookup(cacheKey, cacheValue))
+      {
+         error       = cacheValue.error;
+         behaves     = cacheValue.behaves;
+         motorErrors = cacheValue.motorErrors;
+         return;
+      }
+   }
+   if (farmRequest != -1)
+   {
+      remote      = evalFarm->collect(farmRequest, error, behaves, motorErrors);
+      farmRequest = -1;
+   }
+   else
+   {
+      remote = ((evalFarm != NULL) &&
+                evalFarm->evaluate(network, behaviors, fitnessMotorList, maxStep,
+                                   error, behaves, motorErrors));
+   }
+   if (!remote)
+   {
+      evaluateBehaviors(behaviors, fitnessMotorList, maxStep, behaviorTrie);
+   }
+   if (fitnessCache != NULL)
+   {
+      cacheValue.error       = error;
+      cacheValue.fitness     = 0.0f;
+      cacheValue.behaves     = behaves;
+      cacheValue.motorErrors = motorErrors;
+      fitnessCache->insert(cacheKey, cacheValue);
+   }
+}
+
+
+// Submit behavior evaluation to the evaluation farm.
+// Cached evaluations are not submitted.
+void NetworkMorph::submitEvaluation(vector<Behavior *>& behaviors,
+                                    vector<bool>& fitnessMotorList, int maxStep)
+{
+   FitnessCache::Key   cacheKey('B');
+   FitnessCache::Value cacheValue;
+
+   if ((evalFarm == NULL) || (farmRequest != -1))
+   {
+      return;
+   }
+   if (fitnessCache != NULL)
+   {
+      getCacheKey(cacheKey, behaviors, fitnessMotorList, maxStep);
+      if (fitnessCache->lookup(cacheKey, cacheValue))
+      {
+         return;
+      }
+   }
+   farmRequest = evalFarm->submit(network, behaviors, fitnessMotorList, maxStep,
+                                  (int)motorErrors.size());
+}
+
+
+// Fitness cache key of behavior evaluation.
+void NetworkMorph::getCacheKey(FitnessCache::Key& cacheKey, vector<Behavior *>& behaviors,
+                               vector<bool>& fitnessMotorList, int maxStep)
+{
+   int i, n;
+
+   cacheKey.add(network);
+   cacheKey.add((unsigned long long)behaviors.size());
+   for (i = 0, n = (int)behaviors.size(); i < n; i++)
+   {
+      cacheKey.add((void *)behaviors[i]);
+   }
+   cacheKey.add((unsigned long long)maxStep);
+   for (i = 0, n = (int)fitnessMotorList.size(); i < n; i++)
+   {
+      cacheKey.add((unsigned long long)(fitnessMotorList[i] ? 1 : 0));
+   }
+   cacheKey.add((unsigned long long)motorErrors.size());
+}
+
+
+void NetworkMorph::evaluateBehaviors(vector<Behavior *>& behaviors,
+                                     vector<bool>& fitnessMotorList, int maxStep,
+                                     BehaviorTrie *behaviorTrie)
 {
    int      i, j, k, n, m, o, count, exceed;
    bool     motorFitness;
-   float    delta;
+   float    delta, *testMotors;
    Behavior *testBehavior;
 
+   BehaviorSequence trieMotors;
+
    error = 0.0f;
    fill(motorErrors.begin(), motorErrors.end(), false);
    behaves = true;
@@ -44,24 +170,45 @@ void NetworkMorph::evaluate(vector<Behavior *>& behaviors,
    {
       motorFitness = false;
    }
+   if (behaviorTrie != NULL)
+   {
+      assert(behaviorTrie->paths.size() == behaviors.size());
+      behaviorTrie->run(network, maxStep, trieMotors);
+   }
+   testBehavior = NULL;
    for (i = 0, n = (int)behaviors.size(); i < n; i++)
    {
-      testBehavior = new Behavior(network, behaviors[i]->sensorSequence);
-      assert(testBehavior != NULL);
-      m = (int)testBehavior->motorSequence.size();
+      if (behaviorTrie != NULL)
+      {
+         m = (int)behaviorTrie->paths[i].size();
+      }
+      else
+      {
+         testBehavior = new Behavior(network, behaviors[i]->sensorSequence, maxStep);
+         assert(testBehavior != NULL);
+         m = testBehavior->motorSequence.size();
+      }
       if ((maxStep != -1) && ((maxStep + 1) < m))
       {
          m = maxStep + 1;
       }
       for (j = 0; j < m; j++)
       {
-         for (k = 0, o = (int)testBehavior->motorSequence[j].size(); k < o; k++)
+         if (behaviorTrie != NULL)
+         {
+            testMotors = trieMotors[behaviorTrie->paths[i][j]];
+         }
+         else
+         {
+            testMotors = testBehavior->motorSequence[j];
+         }
+         for (k = 0, o = network->numMotors; k < o; k++)
          {
             if (motorFitness && !fitnessMotorList[k])
             {
                continue;
             }
-            delta = fabs(behaviors[i]->motorSequence[j][k] - testBehavior->motorSequence[j][k]);
+            delta = fabs(behaviors[i]->motorSequence[j][k] - testMotors[k]);
             if (delta > MAX_ERROR_TOLERANCE)
             {
                exceed++;
@@ -75,7 +222,11 @@ void NetworkMorph::evaluate(vector<Behavior *>& behaviors,
             count++;
          }
       }
-      delete testBehavior;
+      if (testBehavior != NULL)
+      {
+         delete testBehavior;
+         testBehavior = NULL;
+      }
    }
    if (count > 0)
    {
@@ -6,6 +6,8 @@
 #include "network.hpp"
 #include "behavior.hpp"
 #include "mutableParm.hpp"
+#include "fitnessCache.hpp"
+#include "evalFarm.hpp"
 
 // Network morph.
 class NetworkMorph
@@ -25,13 +27,51 @@ public:
    bool         behaves;
    int          offspringCount;
 
+   // Evaluation is stale: network changed since last evaluated.
+   bool stale;
+
+   // NUMA node of thread team block that created member.
+   int node;
+
+   // Genome fingerprint: 128-bit hash of network weights, valid if fingerprinted.
+   FitnessCache::Key fingerprint;
+   bool              fingerprinted;
+   void setFingerprint();
+   bool sameGenome(NetworkMorph *member);
+
    // Evaluate behavior.
-   void evaluate(vector<Behavior *>& behaviors, int maxStep);
+   // A prefix trie compiled from the behaviors avoids re-simulating shared prefixes.
+   void evaluate(vector<Behavior *>& behaviors, int maxStep,
+                 BehaviorTrie *behaviorTrie = NULL);
    void evaluate(vector<Behavior *>& behaviors,
-                 vector<bool>& fitnessMotorList, int maxStep);
+                 vector<bool>& fitnessMotorList, int maxStep,
+                 BehaviorTrie *behaviorTrie = NULL);
+
+   // Submit behavior evaluation to the evaluation farm, to be collected
+   // by the next evaluate.
+   void submitEvaluation(vector<Behavior *>& behaviors,
+                         vector<bool>& fitnessMotorList, int maxStep);
+
+   // Evaluation farm request in flight (-1 if none).
+   int farmRequest;
+
+   // Shared fitness cache (NULL if none).
+   static FitnessCache *fitnessCache;
+
+   // Distributed evaluation farm (NULL if none).
+   static EvalFarm *evalFarm;
 
 protected:
 
    Random *randomizer;
+
+   // Fitness cache key of behavior evaluation.
+   void getCacheKey(FitnessCache::Key& cacheKey, vector<Behavior *>& behaviors,
+                    vector<bool>& fitnessMotorList, int maxStep);
+
+   // Evaluate behavior by simulating network.
+   void evaluateBehaviors(vector<Behavior *>& behaviors,
+                          vector<bool>& fitnessMotorList, int maxStep,
+                          BehaviorTrie *behaviorTrie);
 };
 #endif
@@ -15,9 +15,60 @@ NetworkMorphoGenesis::NetworkMorphoGenesis()
    behaveQuorumMaxGenerations  = -1;
    behaviorStep                = -1;
    behaveQuorumGenerationCount = -1;
-   randomSeed = 4517;
-   generation = 0;
-   morphfp    = stdout;
+   randomSeed   = 4517;
+   generation   = 0;
+   morphfp      = stdout;
+   behaviorTrie = NULL;
+}
+
+
+// Destructor.
+NetworkMorphoGenesis::~NetworkMorphoGenesis()
+{
+   if (behaviorTrie != NULL)
+   {
+      delete behaviorTrie;
+   }
+   for (int i = 0, n = (int)offspringRandomizers.size(); i < n; i++)
+   {
+      delete offspringRandomizers[i];
+   }
+   offspringRandomizers.clear();
+}
+
+
+// Seed offspring random streams for current generation.
+void NetworkMorphoGenesis::seedOffspringRandomizers(int numRandomizers)
+{
+   int    i;
+   Random *random;
+
+   for (i = (int)offspringRandomizers.size(); i < numRandomizers; i++)
+   {
+      random = new Random();
+      assert(random != NULL);
+      offspringRandomizers.push_back(random);
+   }
+   for (i = 0; i < numRandomizers; i++)
+   {
+      offspringRandomizers[i]->SRAND_STREAM(randomSeed, (RANDOM)generation, (RANDOM)i);
+   }
+}
+
+
+// Compile behaviors into prefix trie.
+void NetworkMorphoGenesis::compileBehaviors()
+{
+   if (behaviorTrie != NULL)
+   {
+      delete behaviorTrie;
+      behaviorTrie = NULL;
+   }
+   if (behaviors.size() > 0)
+   {
+      behaviorTrie = new BehaviorTrie(behaviors);
+      assert(behaviorTrie != NULL);
+   }
 }
 
 
@@ -28,7 +79,7 @@ void NetworkMorphoGenesis::evaluate()
 
    for (i = 0, n = (int)population.size(); i < n; i++)
    {
-      population[i]->evaluate(behaviors, fitnessMotorList, behaviorStep);
+      population[i]->evaluate(behaviors, fitnessMotorList, behaviorStep, behaviorTrie);
    }
 }
 
@@ -36,33 +87,28 @@ void NetworkMorphoGenesis::evaluate()
 // Sort members by fitness.
 void NetworkMorphoGenesis::sort()
 {
-   int          i, j, n;
-   NetworkMorph *networkMorph;
+   merge(0, ranksBefore);
+}
 
-   for (i = 0, n = (int)population.size(); i < n; i++)
+
+// Merge members from first index on into sorted members before it.
+// Only the unsorted members are sorted, and equally fit members keep their order.
+void NetworkMorphoGenesis::merge(int first, bool (*before)(NetworkMorph *, NetworkMorph *))
+{
+   assert(first >= 0 && first <= (int)population.size());
+   stable_sort(population.begin() + first, population.end(), before);
+   inplace_merge(population.begin(), population.begin() + first, population.end(), before);
+}
+
+
+// Member ranks before other: behaving members first, then by increasing error.
+bool NetworkMorphoGenesis::ranksBefore(NetworkMorph *member, NetworkMorph *other)
+{
+   if (member->behaves != other->behaves)
    {
-      for (j = i + 1; j < n; j++)
-      {
-         if (population[i]->behaves)
-         {
-            if (population[j]->behaves && (population[i]->error > population[j]->error))
-            {
-               networkMorph  = population[i];
-               population[i] = population[j];
-               population[j] = networkMorph;
-            }
-         }
-         else
-         {
-            if (population[j]->behaves || (population[i]->error > population[j]->error))
-            {
-               networkMorph  = population[i];
-               population[i] = population[j];
-               population[j] = networkMorph;
-            }
-         }
-      }
+      return(member->behaves);
    }
+   return(member->error < other->error);
 }
 
 
@@ -83,13 +129,13 @@ void NetworkMorphoGenesis::saveNetworks(char *filePrefix)
 
 
 // Start morph logging to file.
-bool NetworkMorphoGenesis::startMorphLog(char *logFile)
+bool NetworkMorphoGenesis::startMorphLog(char *logFile, bool binary)
 {
    if (morphfp != stdout)
    {
       fclose(morphfp);
    }
-   if ((morphfp = fopen(logFile, "w")) == NULL)
+   if ((morphfp = fopen(logFile, binary ? "wb" : "w")) == NULL)
    {
       fprintf(stderr, "Cannot open morph log file %s\n", logFile);
       morphfp = stdout;
@@ -4,6 +4,7 @@
 #define __NETWORK_MORPHOGENESIS_HPP__
 
 #include "networkMorph.hpp"
+#include <algorithm>
 
 // Network morphogenesis.
 class NetworkMorphoGenesis
@@ -13,9 +14,16 @@ public:
    // Constructor.
    NetworkMorphoGenesis();
 
+   // Destructor.
+   ~NetworkMorphoGenesis();
+
    // Behaviors.
    vector<Behavior *> behaviors;
 
+   // Behaviors compiled into prefix trie.
+   BehaviorTrie *behaviorTrie;
+   void compileBehaviors();
+
    // Population size.
    int populationSize;
    vector<NetworkMorph *> population;
@@ -48,10 +56,16 @@ public:
    // Sort population by fitness.
    void sort();
 
+   // Merge members from first index on into the sorted members before it.
+   void merge(int first, bool (*before)(NetworkMorph *, NetworkMorph *) = ranksBefore);
+
+   // Member ranks before other: behaving members first, then by increasing error.
+   static bool ranksBefore(NetworkMorph *member, NetworkMorph *other);
+
    // Save networks.
    void saveNetworks(char *filePrefix);
 
-   bool startMorphLog(char *logFile);
+   bool startMorphLog(char *logFile, bool binary = false);
    void stopMorphLog();
 
    // Tag generator.
@@ -61,5 +75,10 @@ protected:
 
    Random *randomizer;
    FILE   *morphfp;
+
+   // Offspring random streams derived from (random seed, generation, offspring index),
+   // independent of the thread creating the offspring.
+   vector<Random *> offspringRandomizers;
+   void seedOffspringRandomizers(int numRandomizers);
 };
 #endif
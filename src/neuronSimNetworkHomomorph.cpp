@@ -8,14 +8,8 @@ NeuronSimNetworkHomomorph::NeuronSimNetworkHomomorph(Network *homomorph,
                                                      vector<vector<pair<int, int> > > *motorConnections,
                                                      Random *randomizer, int tag)
 {
-   this->synapseWeightsParm = synapseWeightsParm;
-   this->synapseWeightsParm.initValue(randomizer);
-   this->motorConnections = motorConnections;
-   this->randomizer       = randomizer;
-   this->tag = tag;
-   network   = homomorph->clone();
-   meanError = 0.0f;
-   motorErrors.resize(network->numMotors, false);
+   network = NULL;
+   init(homomorph, synapseWeightsParm, motorConnections, randomizer, tag);
 }
 
 
@@ -40,65 +34,86 @@ NeuronSimNetworkHomomorph::~NeuronSimNetworkHomomorph()
 void NeuronSimNetworkHomomorph::optimize(int synapseOptimizedPathLength,
                                          NeuronSim *modelSim, NeuronSim *evalSim)
 {
-   int   i, j, k, n, p, q;
-   float e, r;
+   int   i, j, b;
+   float r;
 
-   // Initialize optimization.
    vector<vector<Synapse *> > synapses;
-   vector<vector<float> >     permutations;
-   initOptimize(synapses, permutations, synapseOptimizedPathLength);
+   vector<vector<float> >     candidates;
+   vector<float>              scores;
+   vector<float>              meanErrors;
+
+   // Initialize optimization.
+   Optimizer *optimizer = initOptimize(synapses, synapseOptimizedPathLength);
+   if (optimizer == NULL)
+   {
+      return;
+   }
 
-   // Hill-climb synapse weight permutations.
-   n = 0;
-   e = error;
+   // Hill-climb proposed synapse weights.
    r = meanError;
-   for (i = 1, j = (int)permutations.size(); i < j; i++)
+   while (optimizer->propose(candidates))
    {
-      for (k = 0; k < (int)synapses.size(); k++)
+      j = (int)candidates.size();
+      scores.resize(j);
+      meanErrors.resize(j);
+      for (i = 0; i < j; i++)
       {
-         for (p = 0, q = (int)synapses[k].size(); p < q; p++)
-         {
-            synapses[k][p]->setWeight(permutations[i][k]);
-         }
+         setPermutation(synapses, candidates[i]);
+         evaluate(modelSim, evalSim);
+         scores[i]     = error;
+         meanErrors[i] = meanError;
       }
-      evaluate(modelSim, evalSim);
-      if (error < e)
+      if ((b = optimizer->update(scores)) != -1)
       {
-         n = i;
-         e = error;
-         r = meanError;
+         r = meanErrors[b];
       }
    }
-   for (k = 0; k < (int)synapses.size(); k++)
-   {
-      for (p = 0, q = (int)synapses[k].size(); p < q; p++)
-      {
-         synapses[k][p]->setWeight(permutations[n][k]);
-      }
-   }
-   error     = e;
+   setPermutation(synapses, optimizer->best);
+   error     = optimizer->bestScore;
    meanError = r;
+   delete optimizer;
 }
 
 
 // NEURON simulation fitness evaluation.
 void NeuronSimNetworkHomomorph::evaluate(NeuronSim *modelSim, NeuronSim *evalSim)
 {
+   FitnessCache::Key   cacheKey('N');
+   FitnessCache::Value cacheValue;
+
+   if (fitnessCache != NULL)
+   {
+      cacheKey.add(network);
+      cacheKey.add((void *)modelSim);
+      if (fitnessCache->lookup(cacheKey, cacheValue))
+      {
+         error     = cacheValue.error;
+         meanError = cacheValue.fitness;
+         return;
+      }
+   }
    evalSim->importSynapseWeights(network);
    evalSim->run();
    evalSim->activationDelta(modelSim, error, meanError);
+   if (fitnessCache != NULL)
+   {
+      cacheValue.error   = error;
+      cacheValue.fitness = meanError;
+      cacheValue.behaves = false;
+      fitnessCache->insert(cacheKey, cacheValue);
+   }
 }
 
 
 // Clone.
-NeuronSimNetworkHomomorph *NeuronSimNetworkHomomorph::clone(int tag)
+NeuronSimNetworkHomomorph *NeuronSimNetworkHomomorph::clone(int tag, Random *randomizer)
 {
    int i, n;
    NeuronSimNetworkHomomorph *simNetworkMorph;
 
    simNetworkMorph = new NeuronSimNetworkHomomorph(
       network, synapseWeightsParm,
-      motorConnections, randomizer, tag);
+      motorConnections, randomizer != NULL ? randomizer : this->randomizer, tag);
    assert(simNetworkMorph != NULL);
    simNetworkMorph->error     = error;
    simNetworkMorph->meanError = meanError;
@@ -110,6 +125,28 @@ NeuronSimNetworkHomomorph *NeuronSimNetworkHomomorph::clone(int tag)
 }
 
 
+// Reinitialize in place as constructed from homomorph.
+void NeuronSimNetworkHomomorph::init(Network *homomorph,
+                                     MutableParm& synapseWeightsParm,
+                                     vector<vector<pair<int, int> > > *motorConnections,
+                                     Random *randomizer, int tag)
+{
+   NetworkHomomorph::init(homomorph, synapseWeightsParm, motorConnections, randomizer, tag);
+   meanError = 0.0f;
+}
+
+
+// Clone member in place.
+void NeuronSimNetworkHomomorph::cloneFrom(NeuronSimNetworkHomomorph *member, int tag, Random *randomizer)
+{
+   init(member->network, member->synapseWeightsParm, member->motorConnections,
+        randomizer != NULL ? randomizer : member->randomizer, tag);
+   error       = member->error;
+   meanError   = member->meanError;
+   motorErrors = member->motorErrors;
+}
+
+
 // Load.
 void NeuronSimNetworkHomomorph::load(FilePointer *fp)
 {
@@ -0,0 +1,185 @@
+// NUMA thread placement implementation.
+
+#include "numa.hpp"
+#ifdef __linux__
+#include <sched.h>
+#include <dirent.h>
+#endif
+
+// Default probability of choosing parents from another node.
+const float Numa::DEFAULT_MIGRATION_RATE = 0.1f;
+
+// Constructor.
+Numa::Numa(int numThreads, float migrationRate)
+{
+   int i, j, k, node;
+
+   assert(numThreads > 0);
+   this->numThreads    = numThreads;
+   this->migrationRate = migrationRate;
+   getTopology();
+   numNodes = (int)nodeCpus.size();
+   if (numNodes == 0)
+   {
+      nodeCpus.resize(1);
+      numNodes = 1;
+   }
+
+   // Deal threads to nodes in contiguous blocks.
+   threadNodes.resize(numThreads);
+   threadCpus.resize(numThreads);
+   for (i = k = 0; i < numThreads; i++)
+   {
+      node = (int)(((long long)i * numNodes) / numThreads);
+      if ((i > 0) && (node != threadNodes[i - 1]))
+      {
+         k = 0;
+      }
+      threadNodes[i] = node;
+      j = (int)nodeCpus[node].size();
+      threadCpus[i] = (j > 0) ? nodeCpus[node][k % j] : -1;
+      k++;
+   }
+   offspring = new OffspringCount[numThreads];
+   assert(offspring != NULL);
+   resetStatistics();
+}
+
+
+// Destructor.
+Numa::~Numa()
+{
+   delete [] offspring;
+}
+
+
+// Get nodes and their cores available to process.
+void Numa::getTopology()
+{
+#ifdef __linux__
+   int           i, n, lo, hi, node;
+   char          path[BUFSIZ], list[BUFSIZ], *token, *dash;
+   FILE          *fp;
+   DIR           *dir;
+   struct dirent *entry;
+   cpu_set_t     available;
+   vector<int>   nodes;
+   vector<int>   cpus;
+
+   nodeCpus.clear();
+   CPU_ZERO(&available);
+   if (sched_getaffinity(0, sizeof(available), &available) != 0)
+   {
+      return;
+   }
+   if ((dir = opendir("/sys/devices/system/node")) == NULL)
+   {
+      return;
+   }
+   while ((entry = readdir(dir)) != NULL)
+   {
+      if (sscanf(entry->d_name, "node%d", &node) == 1)
+      {
+         nodes.push_back(node);
+      }
+   }
+   closedir(dir);
+   for (i = 0, n = (int)nodes.size(); i < n; i++)
+   {
+      // Keep nodes in ascending order.
+      for (int j = i + 1; j < n; j++)
+      {
+         if (nodes[j] < nodes[i])
+         {
+            node     = nodes[i];
+            nodes[i] = nodes[j];
+            nodes[j] = node;
+         }
+      }
+      sprintf(path, "/sys/devices/system/node/node%d/cpulist", nodes[i]);
+      if ((fp = fopen(path, "r")) == NULL)
+      {
+         continue;
+      }
+      if (fgets(list, BUFSIZ, fp) == NULL)
+      {
+         list[0] = '\0';
+      }
+      fclose(fp);
+
+      // Parse cpu list, e.g. "0-3,8-11".
+      cpus.clear();
+      for (token = strtok(list, ",\n"); token != NULL; token = strtok(NULL, ",\n"))
+      {
+         lo = hi = atoi(token);
+         if ((dash = strchr(token, '-')) != NULL)
+         {
+            hi = atoi(dash + 1);
+         }
+         for ( ; lo <= hi; lo++)
+         {
+            if ((lo < CPU_SETSIZE) && CPU_ISSET(lo, &available))
+            {
+               cpus.push_back(lo);
+            }
+         }
+      }
+      if (cpus.size() > 0)
+      {
+         nodeCpus.push_back(cpus);
+      }
+   }
+#endif
+}
+
+
+// Pin calling thread to its core.
+bool Numa::pin(int threadNum)
+{
+#if defined(THREADS) && defined(__linux__)
+   cpu_set_t cpus;
+
+   assert(threadNum >= 0 && threadNum < numThreads);
+   if (threadCpus[threadNum] == -1)
+   {
+      return(false);
+   }
+   CPU_ZERO(&cpus);
+   CPU_SET(threadCpus[threadNum], &cpus);
+   if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0)
+   {
+      return(false);
+   }
+   return(true);
+
+#else
+   return(false);
+#endif
+}
+
+
+// Count offspring optimized by thread.
+void Numa::countOffspring(int threadNum)
+{
+   offspring[threadNum].count.fetch_add(1, memory_order_relaxed);
+}
+
+
+// Offspring per node since last reset.
+void Numa::getStatistics(vector<int>& nodeOffspring)
+{
+   nodeOffspring.assign(numNodes, 0);
+   for (int i = 0; i < numThreads; i++)
+   {
+      nodeOffspring[threadNodes[i]] += offspring[i].count.load(memory_order_relaxed);
+   }
+}
+
+
+void Numa::resetStatistics()
+{
+   for (int i = 0; i < numThreads; i++)
+   {
+      offspring[i].count.store(0, memory_order_relaxed);
+   }
+}
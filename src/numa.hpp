@@ -0,0 +1,73 @@
+// NUMA thread placement.
+// Morph threads are dealt to NUMA nodes in contiguous blocks, matching the
+// contiguous task chunks of the task queue, and pinned to the node's cores.
+// Memory is placed by first touch, so offspring and evaluation buffers
+// allocated by a pinned thread are local to its node.
+// Node topology is read from /sys/devices/system/node on Linux; elsewhere
+// all threads share one node and are not pinned.
+
+#ifndef __NUMA_HPP__
+#define __NUMA_HPP__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <vector>
+#include <atomic>
+#ifdef THREADS
+#include <pthread.h>
+#endif
+using namespace std;
+
+class Numa
+{
+public:
+
+   // Default probability of choosing parents from another node.
+   static const float DEFAULT_MIGRATION_RATE;
+
+   // Constructor.
+   Numa(int numThreads, float migrationRate);
+
+   // Destructor.
+   ~Numa();
+
+   // Nodes and thread placement.
+   int         numNodes;
+   int         numThreads;
+   vector<int> threadNodes;
+   vector<int> threadCpus;
+
+   // Probability of choosing parents from another node.
+   float migrationRate;
+
+   // Pin calling thread to its core, returning false if not pinned.
+   bool pin(int threadNum);
+
+   // Count offspring optimized by thread.
+   void countOffspring(int threadNum);
+
+   // Offspring per node since last reset.
+   void getStatistics(vector<int>& nodeOffspring);
+   void resetStatistics();
+
+private:
+
+   // Node cores available to process.
+   vector<vector<int> > nodeCpus;
+   void getTopology();
+
+   // Per-thread offspring counts, padded to separate cache lines.
+   // Counts are atomic so statistics may be read and reset while
+   // steady state threads are counting.
+   class OffspringCount
+   {
+   public:
+      atomic<int> count;
+      char        pad[64 - sizeof(atomic<int>)];
+   };
+   OffspringCount *offspring;
+};
+#endif
@@ -0,0 +1,556 @@
+// Parameter optimizers implementation.
+
+#include "optimizer.hpp"
+#include <algorithm>
+
+// Create optimizer.
+Optimizer *Optimizer::create(int type, vector<MutableParm>& parms, float score,
+                             Random *randomizer, int budget)
+{
+   Optimizer *optimizer;
+
+   switch (type)
+   {
+   case CMAES:
+      optimizer = new CMAESOptimizer(parms, score, randomizer, budget);
+      break;
+
+   default:
+      optimizer = new GridOptimizer(parms, score, randomizer, -1, budget);
+      break;
+   }
+   assert(optimizer != NULL);
+   return(optimizer);
+}
+
+
+// Constructor.
+Optimizer::Optimizer(vector<MutableParm>& parms, float score, Random *randomizer)
+{
+   this->parms      = parms;
+   this->randomizer = randomizer;
+   for (int i = 0, n = (int)parms.size(); i < n; i++)
+   {
+      best.push_back(parms[i].value);
+   }
+   bestScore = score;
+}
+
+
+// Update with candidate scores.
+int Optimizer::update(vector<float>& scores)
+{
+   int i, n, b;
+
+   assert(scores.size() == proposed.size());
+   for (i = 0, n = (int)scores.size(), b = -1; i < n; i++)
+   {
+      if (scores[i] < bestScore)
+      {
+         b         = i;
+         bestScore = scores[i];
+      }
+   }
+   if (b != -1)
+   {
+      best = proposed[b];
+   }
+   return(b);
+}
+
+
+// Grid optimizer constructor.
+GridOptimizer::GridOptimizer(vector<MutableParm>& parms, float score,
+                             Random *randomizer, int samples, int budget) :
+   Optimizer(parms, score, randomizer)
+{
+   int   i, n;
+   float value;
+
+   vector<float> valueRange;
+
+   // Compose parameter value ranges.
+   for (i = 0, n = (int)parms.size(); i < n; i++)
+   {
+      MutableParm& parm = parms[i];
+      valueRange.clear();
+      value = parm.value;
+      valueRange.push_back(value);
+      if (parm.maxDelta > 0.0f)
+      {
+         value = parm.value -
+                 (float)randomizer->RAND_INTERVAL(0.0f, parm.maxDelta);
+         if (value < parm.minimum)
+         {
+            value = parm.minimum;
+         }
+      }
+      valueRange.push_back(value);
+      if (parm.maxDelta > 0.0f)
+      {
+         value = parm.value +
+                 (float)randomizer->RAND_INTERVAL(0.0f, parm.maxDelta);
+         if (value > parm.maximum)
+         {
+            value = parm.maximum;
+         }
+      }
+      valueRange.push_back(value);
+      valueRanges.push_back(valueRange);
+   }
+   this->samples = samples;
+   this->budget  = budget;
+   done          = false;
+}
+
+
+// Propose grid candidates.
+bool GridOptimizer::propose(vector<vector<float> >& candidates)
+{
+   int i, n;
+
+   vector<vector<float> > permutations;
+   vector<float>          permutation;
+
+   candidates.clear();
+   proposed.clear();
+   if (done || (valueRanges.size() == 0))
+   {
+      return(false);
+   }
+   done = true;
+
+   // Sample grid exceeding budget.
+   if (budget != -1)
+   {
+      for (i = 0, n = 3; i < (int)valueRanges.size() - 1 && n - 1 <= budget; i++)
+      {
+         n *= 3;
+      }
+      if ((n - 1) > budget)
+      {
+         sampleValues(candidates, budget);
+         proposed = candidates;
+         return(true);
+      }
+   }
+   permutation.resize(valueRanges.size());
+   permuteValues(permutations, permutation, 0);
+   n = (int)permutations.size();
+   if (samples == -1)
+   {
+      for (i = 1; i < n; i++)
+      {
+         candidates.push_back(permutations[i]);
+      }
+   }
+   else
+   {
+      for (i = 0; i < samples; i++)
+      {
+         candidates.push_back(permutations[randomizer->RAND_CHOICE(n - 1) + 1]);
+      }
+   }
+   proposed = candidates;
+   return(true);
+}
+
+
+// Compose value permutations.
+void GridOptimizer::permuteValues(vector<vector<float> >& permutations,
+                                  vector<float>& permutation, int level)
+{
+   for (int i = 0; i < 3; i++)
+   {
+      permutation[level] = valueRanges[level][i];
+      if (level < (int)valueRanges.size() - 1)
+      {
+         permuteValues(permutations, permutation, level + 1);
+      }
+      else
+      {
+         permutations.push_back(permutation);
+      }
+   }
+}
+
+
+// Sample value permutations by Latin hypercube.
+// Each parameter's column holds its three values equally often, in random
+// order. A sample repeating the incumbent values steps one parameter.
+void GridOptimizer::sampleValues(vector<vector<float> >& permutations, int count)
+{
+   int i, j, k, t, n;
+
+   vector<vector<int> > levels;
+   vector<int>          column;
+   vector<float>        permutation;
+
+   n = (int)valueRanges.size();
+   for (j = 0; j < n; j++)
+   {
+      column.resize(count);
+      for (i = 0; i < count; i++)
+      {
+         column[i] = i % 3;
+      }
+      for (i = count - 1; i > 0; i--)
+      {
+         k         = randomizer->RAND_CHOICE(i + 1);
+         t         = column[i];
+         column[i] = column[k];
+         column[k] = t;
+      }
+      levels.push_back(column);
+   }
+   permutation.resize(n);
+   for (i = 0; i < count; i++)
+   {
+      for (j = 0; j < n; j++)
+      {
+         if (levels[j][i] != 0)
+         {
+            break;
+         }
+      }
+      if (j == n)
+      {
+         levels[randomizer->RAND_CHOICE(n)][i] = randomizer->RAND_CHOICE(2) + 1;
+      }
+      for (j = 0; j < n; j++)
+      {
+         permutation[j] = valueRanges[j][levels[j][i]];
+      }
+      permutations.push_back(permutation);
+   }
+}
+
+
+// Initial step size in maximum delta units.
+const double CMAESOptimizer::INITIAL_SIGMA = 0.5;
+
+// Minimum step size before stopping.
+const double CMAESOptimizer::MINIMUM_SIGMA = 1.0e-4;
+
+// CMA-ES optimizer constructor.
+// Strategy parameters are the defaults of Hansen's CMA-ES tutorial.
+CMAESOptimizer::CMAESOptimizer(vector<MutableParm>& parms, float score,
+                               Random *randomizer, int budget) :
+   Optimizer(parms, score, randomizer)
+{
+   int    i;
+   double w, s, s2;
+
+   n      = (int)parms.size();
+   lambda = 4 + (int)(3.0 * log((double)(n > 0 ? n : 1)));
+   mu     = lambda / 2;
+   for (i = 0, s = 0.0; i < mu; i++)
+   {
+      w = log((double)mu + 0.5) - log((double)(i + 1));
+      weights.push_back(w);
+      s += w;
+   }
+   for (i = 0, s2 = 0.0; i < mu; i++)
+   {
+      weights[i] /= s;
+      s2         += weights[i] * weights[i];
+   }
+   mueff = 1.0 / s2;
+   cc    = (4.0 + mueff / n) / (n + 4.0 + 2.0 * mueff / n);
+   cs    = (mueff + 2.0) / (n + mueff + 5.0);
+   c1    = 2.0 / (((n + 1.3) * (n + 1.3)) + mueff);
+   cmu   = 2.0 * (mueff - 2.0 + 1.0 / mueff) / (((n + 2.0) * (n + 2.0)) + mueff);
+   if (cmu > (1.0 - c1))
+   {
+      cmu = 1.0 - c1;
+   }
+   damps = 1.0 + cs;
+   w     = sqrt((mueff - 1.0) / (n + 1.0)) - 1.0;
+   if (w > 0.0)
+   {
+      damps += 2.0 * w;
+   }
+   chiN = sqrt((double)n) * (1.0 - 1.0 / (4.0 * n) + 1.0 / (21.0 * n * n));
+
+   // Initial distribution: unit covariance about the incumbent.
+   sigma = INITIAL_SIGMA;
+   mean.assign(n, 0.0);
+   pc.assign(n, 0.0);
+   ps.assign(n, 0.0);
+   C.assign(n, vector<double>(n, 0.0));
+   B.assign(n, vector<double>(n, 0.0));
+   D.assign(n, 1.0);
+   for (i = 0; i < n; i++)
+   {
+      C[i][i] = B[i][i] = 1.0;
+      scale.push_back(parms[i].maxDelta > 0.0f ? (double)parms[i].maxDelta : 0.0);
+   }
+   this->budget = (budget == -1 ? (int)DEFAULT_BUDGET : budget);
+   evaluations  = 0;
+}
+
+
+// Propose sampled candidates.
+bool CMAESOptimizer::propose(vector<vector<float> >& candidates)
+{
+   int    i, j, k, m;
+   double d, v;
+
+   vector<double> z, x;
+   vector<float>  candidate;
+
+   candidates.clear();
+   proposed.clear();
+   samples.clear();
+   if ((n == 0) || (evaluations >= budget))
+   {
+      return(false);
+   }
+   for (i = 0, d = 0.0; i < n; i++)
+   {
+      if (D[i] > d)
+      {
+         d = D[i];
+      }
+   }
+   if ((sigma * d) < MINIMUM_SIGMA)
+   {
+      return(false);
+   }
+   m = budget - evaluations;
+   if (m > lambda)
+   {
+      m = lambda;
+   }
+   z.resize(n);
+   x.resize(n);
+   candidate.resize(n);
+   for (k = 0; k < m; k++)
+   {
+      for (i = 0; i < n; i++)
+      {
+         z[i] = D[i] * gaussian();
+      }
+      for (i = 0; i < n; i++)
+      {
+         for (j = 0, v = 0.0; j < n; j++)
+         {
+            v += B[i][j] * z[j];
+         }
+         x[i] = mean[i] + sigma * v;
+
+         // Repair to parameter bounds.
+         MutableParm& parm = parms[i];
+         v = (double)parm.value + scale[i] * x[i];
+         if (v < parm.minimum)
+         {
+            v = parm.minimum;
+         }
+         if (v > parm.maximum)
+         {
+            v = parm.maximum;
+         }
+         candidate[i] = (float)v;
+         if (scale[i] > 0.0)
+         {
+            x[i] = ((double)candidate[i] - (double)parm.value) / scale[i];
+         }
+         else
+         {
+            x[i] = mean[i];
+         }
+      }
+      samples.push_back(x);
+      candidates.push_back(candidate);
+   }
+   evaluations += m;
+   proposed     = candidates;
+   return(true);
+}
+
+
+// Update search distribution.
+// A final partial batch only updates the best values.
+int CMAESOptimizer::update(vector<float>& scores)
+{
+   int    i, j, k, b;
+   double h, v, norm;
+
+   vector<pair<float, int> > ranks;
+   vector<double>            xold, ymean, w;
+
+   b = Optimizer::update(scores);
+   if ((int)scores.size() < lambda)
+   {
+      return(b);
+   }
+
+   // Recombine selected samples.
+   for (k = 0; k < lambda; k++)
+   {
+      ranks.push_back(pair<float, int>(scores[k], k));
+   }
+   stable_sort(ranks.begin(), ranks.end());
+   xold = mean;
+   for (i = 0; i < n; i++)
+   {
+      for (k = 0, v = 0.0; k < mu; k++)
+      {
+         v += weights[k] * samples[ranks[k].second][i];
+      }
+      mean[i] = v;
+   }
+   ymean.resize(n);
+   for (i = 0; i < n; i++)
+   {
+      ymean[i] = (mean[i] - xold[i]) / sigma;
+   }
+
+   // Cumulate step size path with C^(-1/2) * ymean.
+   w.assign(n, 0.0);
+   for (j = 0; j < n; j++)
+   {
+      for (i = 0, v = 0.0; i < n; i++)
+      {
+         v += B[i][j] * ymean[i];
+      }
+      w[j] = v / D[j];
+   }
+   for (i = 0, norm = 0.0; i < n; i++)
+   {
+      for (j = 0, v = 0.0; j < n; j++)
+      {
+         v += B[i][j] * w[j];
+      }
+      ps[i] = (1.0 - cs) * ps[i] + sqrt(cs * (2.0 - cs) * mueff) * v;
+      norm += ps[i] * ps[i];
+   }
+   norm = sqrt(norm);
+   h    = 0.0;
+   if ((norm / sqrt(1.0 - pow(1.0 - cs, 2.0 * evaluations / lambda)) / chiN) <
+       (1.4 + 2.0 / (n + 1.0)))
+   {
+      h = 1.0;
+   }
+
+   // Cumulate covariance path.
+   for (i = 0; i < n; i++)
+   {
+      pc[i] = (1.0 - cc) * pc[i] + h * sqrt(cc * (2.0 - cc) * mueff) * ymean[i];
+   }
+
+   // Rank-one and rank-mu covariance update.
+   for (i = 0; i < n; i++)
+   {
+      for (j = 0; j <= i; j++)
+      {
+         v = 0.0;
+         for (k = 0; k < mu; k++)
+         {
+            v += weights[k] *
+                 ((samples[ranks[k].second][i] - xold[i]) / sigma) *
+                 ((samples[ranks[k].second][j] - xold[j]) / sigma);
+         }
+         C[i][j] = (1.0 - c1 - cmu) * C[i][j] +
+                   c1 * (pc[i] * pc[j] + (1.0 - h) * cc * (2.0 - cc) * C[i][j]) +
+                   cmu * v;
+         C[j][i] = C[i][j];
+      }
+   }
+
+   // Adapt step size.
+   sigma *= exp((cs / damps) * (norm / chiN - 1.0));
+
+   decompose();
+   return(b);
+}
+
+
+// Standard normal deviate (Box-Muller).
+double CMAESOptimizer::gaussian()
+{
+   double u1, u2;
+
+   u1 = 1.0 - randomizer->RAND_PROB();
+   if (u1 <= 0.0)
+   {
+      u1 = 1.0e-300;
+   }
+   u2 = randomizer->RAND_PROB();
+   return(sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2));
+}
+
+
+// Decompose covariance by Jacobi eigenvalue rotations.
+void CMAESOptimizer::decompose()
+{
+   int    i, j, k, sweep;
+   double off, theta, t, c, s, x, y;
+
+   vector<vector<double> > A = C;
+
+   for (i = 0; i < n; i++)
+   {
+      for (j = 0; j < n; j++)
+      {
+         B[i][j] = (i == j ? 1.0 : 0.0);
+      }
+   }
+   for (sweep = 0; sweep < 50; sweep++)
+   {
+      for (i = 0, off = 0.0; i < n; i++)
+      {
+         for (j = i + 1; j < n; j++)
+         {
+            off += A[i][j] * A[i][j];
+         }
+      }
+      if (off < 1.0e-30)
+      {
+         break;
+      }
+      for (i = 0; i < n; i++)
+      {
+         for (j = i + 1; j < n; j++)
+         {
+            if (A[i][j] == 0.0)
+            {
+               continue;
+            }
+            theta = (A[j][j] - A[i][i]) / (2.0 * A[i][j]);
+            t     = 1.0 / (fabs(theta) + sqrt(theta * theta + 1.0));
+            if (theta < 0.0)
+            {
+               t = -t;
+            }
+            c = 1.0 / sqrt(t * t + 1.0);
+            s = t * c;
+            for (k = 0; k < n; k++)
+            {
+               x       = A[k][i];
+               y       = A[k][j];
+               A[k][i] = c * x - s * y;
+               A[k][j] = s * x + c * y;
+            }
+            for (k = 0; k < n; k++)
+            {
+               x       = A[i][k];
+               y       = A[j][k];
+               A[i][k] = c * x - s * y;
+               A[j][k] = s * x + c * y;
+            }
+            for (k = 0; k < n; k++)
+            {
+               x       = B[k][i];
+               y       = B[k][j];
+               B[k][i] = c * x - s * y;
+               B[k][j] = s * x + c * y;
+            }
+         }
+      }
+   }
+   for (i = 0; i < n; i++)
+   {
+      D[i] = (A[i][i] > 1.0e-20 ? sqrt(A[i][i]) : 1.0e-10);
+   }
+}
@@ -0,0 +1,138 @@
+// Parameter optimizers.
+// An optimizer proposes batches of candidate parameter values, receives their
+// scores (errors, lower is better) and updates its search, keeping the best
+// values found, starting from the incumbent values and score.
+// The grid optimizer proposes each parameter's value and a random step below
+// and above it in all combinations, or, if these exceed the evaluation budget,
+// a Latin hypercube sample of them in which each parameter takes each of its
+// three values equally often. The CMA-ES optimizer adapts a multivariate
+// normal search distribution over the parameters, in units of their maximum
+// deltas, within an evaluation budget.
+
+#ifndef __OPTIMIZER_HPP__
+#define __OPTIMIZER_HPP__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+#include <vector>
+#include "mutableParm.hpp"
+using namespace std;
+
+class Optimizer
+{
+public:
+
+   // Optimizer types.
+   enum TYPE { GRID, CMAES };
+
+   // Create optimizer for parameters with incumbent score.
+   // Budget is the maximum number of evaluations (-1 = optimizer default).
+   static Optimizer *create(int type, vector<MutableParm>& parms, float score,
+                            Random *randomizer, int budget = (-1));
+
+   // Destructor.
+   virtual ~Optimizer() {}
+
+   // Propose candidates, returning false when optimization is done.
+   virtual bool propose(vector<vector<float> >& candidates) = 0;
+
+   // Update with candidate scores, returning index of candidate
+   // that became best, or -1.
+   virtual int update(vector<float>& scores);
+
+   // Best values and score.
+   vector<float> best;
+   float         bestScore;
+
+protected:
+
+   Optimizer(vector<MutableParm>& parms, float score, Random *randomizer);
+
+   vector<MutableParm>    parms;
+   Random                 *randomizer;
+   vector<vector<float> > proposed;
+};
+
+// Grid optimizer.
+class GridOptimizer : public Optimizer
+{
+public:
+
+   // Constructor: samples is the number of candidates drawn from the
+   // grid (-1 = entire grid), and budget the maximum number of candidates
+   // (-1 = unlimited).
+   GridOptimizer(vector<MutableParm>& parms, float score,
+                 Random *randomizer, int samples = (-1), int budget = (-1));
+
+   // Propose grid candidates, excluding incumbent values.
+   bool propose(vector<vector<float> >& candidates);
+
+private:
+
+   vector<vector<float> > valueRanges;
+   int                    samples;
+   int                    budget;
+   bool                   done;
+
+   // Compose value permutations.
+   void permuteValues(vector<vector<float> >& permutations,
+                      vector<float>& permutation, int level);
+
+   // Sample value permutations by Latin hypercube.
+   void sampleValues(vector<vector<float> >& permutations, int count);
+};
+
+// CMA-ES optimizer.
+class CMAESOptimizer : public Optimizer
+{
+public:
+
+   // Default evaluation budget.
+   enum { DEFAULT_BUDGET = 100 };
+
+   // Initial step size in maximum delta units.
+   static const double INITIAL_SIGMA;
+
+   // Minimum step size before stopping.
+   static const double MINIMUM_SIGMA;
+
+   // Constructor.
+   CMAESOptimizer(vector<MutableParm>& parms, float score,
+                  Random *randomizer, int budget = (-1));
+
+   // Propose sampled candidates, repaired to parameter bounds.
+   bool propose(vector<vector<float> >& candidates);
+
+   // Update search distribution.
+   int update(vector<float>& scores);
+
+private:
+
+   // Dimension, population size, selected parents and evaluations.
+   int n, lambda, mu;
+   int budget, evaluations;
+
+   // Strategy parameters.
+   vector<double> weights;
+   double         mueff, cc, cs, c1, cmu, damps, chiN;
+
+   // Search distribution in maximum delta units about the incumbent values.
+   double                  sigma;
+   vector<double>          mean;
+   vector<double>          pc, ps;
+   vector<vector<double> > C, B;
+   vector<double>          D;
+   vector<double>          scale;
+
+   // Repaired samples of proposed candidates.
+   vector<vector<double> > samples;
+
+   // Standard normal deviate.
+   double gaussian();
+
+   // Decompose covariance into eigenvectors B and axis lengths D.
+   void decompose();
+};
+#endif
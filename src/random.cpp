@@ -114,6 +114,10 @@ RANDOM Random::genrand_int32(void)
 
    /* mag01[x] = x * RAND_MATRIX_A  for x=0,1 */
 
+   if (stream)
+   {
+      return(stream_int32());
+   }
    if (mti >= RAND_N)                             /* generate N words at one time */
    {
       int kk;
@@ -155,6 +159,60 @@ RANDOM Random::genrand_int32(void)
 }
 
 
+// Philox4x32-10 block for counter.
+// Counter words: low position, high position, stream numbers.
+void Random::philox_block(unsigned long long counter, unsigned int block[4])
+{
+   unsigned int       c0, c1, c2, c3, k0, k1;
+   unsigned long long p0, p1;
+
+   c0 = (unsigned int)(counter & 0xffffffffULL);
+   c1 = (unsigned int)(counter >> 32);
+   c2 = streamNumbers[0];
+   c3 = streamNumbers[1];
+   k0 = streamKey[0];
+   k1 = streamKey[1];
+   for (int i = 0; i < RAND_PHILOX_ROUNDS; i++)
+   {
+      p0 = (unsigned long long)RAND_PHILOX_M0 * (unsigned long long)c0;
+      p1 = (unsigned long long)RAND_PHILOX_M1 * (unsigned long long)c2;
+      c0 = (unsigned int)(p1 >> 32) ^ c1 ^ k0;
+      c2 = (unsigned int)(p0 >> 32) ^ c3 ^ k1;
+      c1 = (unsigned int)p1;
+      c3 = (unsigned int)p0;
+      k0 += (unsigned int)RAND_PHILOX_W0;
+      k1 += (unsigned int)RAND_PHILOX_W1;
+   }
+   block[0] = c0;
+   block[1] = c1;
+   block[2] = c2;
+   block[3] = c3;
+}
+
+
+// Generate next counter-based stream value.
+RANDOM Random::stream_int32(void)
+{
+   RANDOM y;
+   int    i;
+
+   i = (int)(streamPosition & 3ULL);
+   if (i == 0)
+   {
+      philox_block(streamPosition >> 2, streamBlock);
+   }
+   y = (RANDOM)streamBlock[i];
+   streamPosition++;
+
+   // Prevent return of INVALID_RANDOM
+   if (y == INVALID_RANDOM)
+   {
+      y = 0x7fffffffUL;
+   }
+   return(y);
+}
+
+
 /* generates a random number on [0,0x7fffffff]-interval */
 long Random::genrand_int31(void)
 {
@@ -202,6 +260,7 @@ double Random::genrand_res53(void)
 /* load state from file pointer */
 void Random::load_genrand(FilePointer *fp)
 {
+   stream = false;
    for (int i = 0; i < RAND_N; i++)
    {
       FREAD_LONG(&mt[i], fp);
@@ -213,6 +272,7 @@ void Random::load_genrand(FilePointer *fp)
 /* save state to file pointer */
 void Random::save_genrand(FilePointer *fp)
 {
+   assert(!stream);
    for (int i = 0; i < RAND_N; i++)
    {
       FWRITE_LONG(&mt[i], fp);
@@ -226,6 +286,7 @@ void Random::push_genrand()
 {
    RANDOM *mtp;
 
+   assert(!stream);
    mtp = new RANDOM[RAND_N];
    assert(mtp != NULL);
    for (int i = 0; i < RAND_N; i++)
@@ -258,10 +319,23 @@ void Random::pop_genrand()
 // Seed random numbers.
 void Random::SRAND(RANDOM seed)
 {
+   stream = false;
    init_genrand(seed);
 }
 
 
+// Seed counter-based stream.
+void Random::SRAND_STREAM(RANDOM seed, RANDOM stream1, RANDOM stream2)
+{
+   stream           = true;
+   streamKey[0]     = (unsigned int)(seed & 0xffffffffUL);
+   streamKey[1]     = (unsigned int)(((unsigned long long)seed >> 32) ^ 0x5bd1e995UL);
+   streamNumbers[0] = (unsigned int)(stream1 & 0xffffffffUL);
+   streamNumbers[1] = (unsigned int)(stream2 & 0xffffffffUL);
+   streamPosition   = 0;
+}
+
+
 // Get random number
 RANDOM Random::RAND()
 {
@@ -363,7 +437,17 @@ void Random::RAND_CLONE(Random& random)
    {
       random.mt[i] = mt[i];
    }
-   random.mti = mti;
+   random.mti              = mti;
+   random.stream           = stream;
+   random.streamKey[0]     = streamKey[0];
+   random.streamKey[1]     = streamKey[1];
+   random.streamNumbers[0] = streamNumbers[0];
+   random.streamNumbers[1] = streamNumbers[1];
+   random.streamPosition   = streamPosition;
+   for (int i = 0; i < 4; i++)
+   {
+      random.streamBlock[i] = streamBlock[i];
+   }
 
    while (smt.size() > 0)
    {
@@ -25,7 +25,17 @@ typedef double          PROBABILITY;
 /* least significant r bits */
 #define RAND_LOWER_MASK    0x7fffffffUL
 
+// Philox4x32-10 counter-based stream parameters.
+#define RAND_PHILOX_M0        0xD2511F53UL
+#define RAND_PHILOX_M1        0xCD9E8D57UL
+#define RAND_PHILOX_W0        0x9E3779B9UL
+#define RAND_PHILOX_W1        0xBB67AE85UL
+#define RAND_PHILOX_ROUNDS    10
+
 // Random numbers.
+// Mersenne Twister sequence, or a counter-based stream identified by a seed
+// and two stream numbers: the n-th value of a stream is a pure function of
+// (seed, stream numbers, n), so streams need no shared state.
 class Random
 {
 public:
@@ -35,6 +45,13 @@ public:
    RANDOM mt[RAND_N];
    int    mti;
 
+   // Counter-based stream state.
+   bool               stream;
+   unsigned int       streamKey[2];
+   unsigned int       streamNumbers[2];
+   unsigned long long streamPosition;
+   unsigned int       streamBlock[4];
+
    // Save/restore random state on stack.
    stack<RANDOM *> smt;
    stack<int>      smti;
@@ -42,13 +59,15 @@ public:
    // Constructors.
    Random()
    {
-      mti = RAND_N + 1;
+      mti    = RAND_N + 1;
+      stream = false;
    }
 
 
    Random(RANDOM seed)
    {
-      mti = RAND_N + 1;
+      mti    = RAND_N + 1;
+      stream = false;
       SRAND(seed);
    }
 
@@ -63,6 +82,10 @@ public:
    // Seed random numbers.
    void SRAND(RANDOM seed);
 
+   // Seed counter-based stream, e.g. (seed, generation, offspring index).
+   // Streams are not saved: they are recreated from their seed and stream numbers.
+   void SRAND_STREAM(RANDOM seed, RANDOM stream1, RANDOM stream2);
+
    // Get random number
    RANDOM RAND();
 
@@ -113,6 +136,12 @@ private:
    /* generates a random number on [0,0xffffffff]-interval */
    RANDOM genrand_int32(void);
 
+   // Generate next counter-based stream value.
+   RANDOM stream_int32(void);
+
+   // Philox4x32-10 block for counter.
+   void philox_block(unsigned long long counter, unsigned int block[4]);
+
    /* generates a random number on [0,0x7fffffff]-interval */
    long genrand_int31(void);
 
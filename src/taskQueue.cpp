@@ -0,0 +1,223 @@
+// Work-stealing task queue implementation.
+
+#include "taskQueue.hpp"
+
+// Constructor.
+TaskQueue::TaskQueue(int numThreads)
+{
+   assert(numThreads > 0);
+   this->numThreads = numThreads;
+   numTasks         = 0;
+   deques           = new Deque[numThreads];
+   assert(deques != NULL);
+   for (int i = 0; i < numThreads; i++)
+   {
+      deques[i].front  = deques[i].back = 0;
+      deques[i].idle   = 0;
+      deques[i].steals = 0;
+#ifdef THREADS
+      if (pthread_mutex_init(&deques[i].mutex, NULL) != 0)
+      {
+         fprintf(stderr, "pthread_mutex_init failed, errno=%d\n", errno);
+         exit(1);
+      }
+#endif
+   }
+}
+
+
+// Destructor.
+TaskQueue::~TaskQueue()
+{
+#ifdef THREADS
+   for (int i = 0; i < numThreads; i++)
+   {
+      pthread_mutex_destroy(&deques[i].mutex);
+   }
+#endif
+   delete [] deques;
+}
+
+
+// Deal tasks to threads.
+void TaskQueue::reset(int numTasks)
+{
+   int i, chunk, extra, front;
+
+   this->numTasks = numTasks;
+   chunk = numTasks / numThreads;
+   extra = numTasks % numThreads;
+   for (i = front = 0; i < numThreads; i++)
+   {
+      deques[i].front = front;
+      front          += chunk + (i < extra ? 1 : 0);
+      deques[i].back  = front;
+   }
+}
+
+
+// Thread that task was dealt to.
+int TaskQueue::owner(int task)
+{
+   int chunk, extra;
+
+   assert(task >= 0 && task < numTasks);
+   chunk = numTasks / numThreads;
+   extra = numTasks % numThreads;
+   if (task < extra * (chunk + 1))
+   {
+      return(task / (chunk + 1));
+   }
+   return(extra + ((task - (extra * (chunk + 1))) / chunk));
+}
+
+
+// Set NUMA node of each thread.
+void TaskQueue::setNodes(vector<int>& threadNodes)
+{
+   assert((int)threadNodes.size() == numThreads);
+   this->threadNodes = threadNodes;
+}
+
+
+// Next task for thread.
+int TaskQueue::next(int threadNum)
+{
+   int task;
+
+   while (true)
+   {
+      lock(threadNum);
+      if (deques[threadNum].front < deques[threadNum].back)
+      {
+         task = deques[threadNum].front;
+         deques[threadNum].front++;
+         unlock(threadNum);
+         return(task);
+      }
+      unlock(threadNum);
+      if (!steal(threadNum))
+      {
+         return(-1);
+      }
+   }
+}
+
+
+// Steal back half of fullest other deque.
+bool TaskQueue::steal(int threadNum)
+{
+   int i, j, n, victim, most, front, back;
+
+   while (true)
+   {
+      // Choose victim without locking: sizes are rechecked under lock.
+      // Prefer victims on same node.
+      victim = -1;
+      most   = 0;
+      for (i = 1; i < numThreads; i++)
+      {
+         j = (threadNum + i) % numThreads;
+         if ((threadNodes.size() > 0) && (threadNodes[j] != threadNodes[threadNum]))
+         {
+            continue;
+         }
+         n = deques[j].back.load(memory_order_relaxed) -
+             deques[j].front.load(memory_order_relaxed);
+         if (n > most)
+         {
+            most   = n;
+            victim = j;
+         }
+      }
+      if ((victim == -1) && (threadNodes.size() > 0))
+      {
+         for (i = 1; i < numThreads; i++)
+         {
+            j = (threadNum + i) % numThreads;
+            n = deques[j].back.load(memory_order_relaxed) -
+                deques[j].front.load(memory_order_relaxed);
+            if (n > most)
+            {
+               most   = n;
+               victim = j;
+            }
+         }
+      }
+      if (victim == -1)
+      {
+         return(false);
+      }
+      lock(victim);
+      n = deques[victim].back - deques[victim].front;
+      if (n <= 0)
+      {
+         unlock(victim);
+         continue;
+      }
+      back  = deques[victim].back;
+      front = back - ((n + 1) / 2);
+      deques[victim].back = front;
+      unlock(victim);
+      lock(threadNum);
+      deques[threadNum].front = front;
+      deques[threadNum].back  = back;
+      deques[threadNum].steals++;
+      unlock(threadNum);
+      return(true);
+   }
+}
+
+
+// Add idle time.
+// Locked: a thread adds idle time after the closing barrier, while the
+// main thread may be reporting statistics.
+void TaskQueue::addIdle(int threadNum, TIME idle)
+{
+   lock(threadNum);
+   deques[threadNum].idle += idle;
+   unlock(threadNum);
+}
+
+
+// Statistics since last reset.
+void TaskQueue::getStatistics(TIME& idle, int& steals)
+{
+   idle   = 0;
+   steals = 0;
+   for (int i = 0; i < numThreads; i++)
+   {
+      lock(i);
+      idle   += deques[i].idle;
+      steals += deques[i].steals;
+      unlock(i);
+   }
+}
+
+
+void TaskQueue::resetStatistics()
+{
+   for (int i = 0; i < numThreads; i++)
+   {
+      lock(i);
+      deques[i].idle   = 0;
+      deques[i].steals = 0;
+      unlock(i);
+   }
+}
+
+
+void TaskQueue::lock(int threadNum)
+{
+#ifdef THREADS
+   pthread_mutex_lock(&deques[threadNum].mutex);
+#endif
+}
+
+
+void TaskQueue::unlock(int threadNum)
+{
+#ifdef THREADS
+   pthread_mutex_unlock(&deques[threadNum].mutex);
+#endif
+}
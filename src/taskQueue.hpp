@@ -0,0 +1,79 @@
+// Work-stealing task queue.
+// Tasks 0 to n-1 are dealt to per-thread deques in contiguous chunks.
+// A thread takes tasks from the front of its own deque and, when that is
+// empty, steals the back half of the fullest other deque, preferring
+// deques of threads on its own NUMA node when nodes are set.
+
+#ifndef __TASK_QUEUE_HPP__
+#define __TASK_QUEUE_HPP__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <assert.h>
+#include <vector>
+#include <atomic>
+#include "gettime.h"
+#ifdef THREADS
+#include <pthread.h>
+#endif
+using namespace std;
+
+class TaskQueue
+{
+public:
+
+   // Constructor.
+   TaskQueue(int numThreads);
+
+   // Destructor.
+   ~TaskQueue();
+
+   // Deal tasks to threads.
+   // Call from one thread while the others are not taking tasks.
+   void reset(int numTasks);
+
+   // Thread that task was dealt to.
+   int owner(int task);
+
+   // Set NUMA node of each thread.
+   void setNodes(vector<int>& threadNodes);
+
+   // Next task for thread, or -1 when all tasks are taken.
+   int next(int threadNum);
+
+   // Idle time (milliseconds) waiting for other threads to finish tasks.
+   void addIdle(int threadNum, TIME idle);
+
+   // Statistics since last reset.
+   void getStatistics(TIME& idle, int& steals);
+   void resetStatistics();
+
+private:
+
+   // Task deque: tasks front to back-1.
+   // Front and back are changed under the deque mutex, and are atomic
+   // so thieves may read them without it to choose a victim.
+   class Deque
+   {
+   public:
+      atomic<int> front;
+      atomic<int> back;
+      TIME        idle;
+      int         steals;
+#ifdef THREADS
+      pthread_mutex_t mutex;
+#endif
+   };
+   Deque       *deques;
+   int         numThreads;
+   int         numTasks;
+   vector<int> threadNodes;
+
+   // Steal tasks into thread's deque.
+   bool steal(int threadNum);
+
+   void lock(int threadNum);
+   void unlock(int threadNum);
+};
+#endif
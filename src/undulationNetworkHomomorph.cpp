@@ -3,6 +3,10 @@
 #include "undulationNetworkHomomorph.hpp"
 #ifdef FFT_UNDULATION_EVAL
 #include <numeric>
+#include <map>
+#ifdef THREADS
+#include <pthread.h>
+#endif
 #endif
 
 // Constructors.
@@ -11,24 +15,8 @@ UndulationNetworkHomomorph::UndulationNetworkHomomorph(int undulationMovements,
                                                        vector<vector<pair<int, int> > > *motorConnections,
                                                        Random *randomizer, int tag)
 {
-   this->undulationMovements = undulationMovements;
-   this->synapseWeightsParm  = synapseWeightsParm;
-   this->synapseWeightsParm.initValue(randomizer);
-   this->motorConnections = motorConnections;
-   this->randomizer       = randomizer;
-   this->tag = tag;
-   network   = homomorph->clone();
-   motorErrors.resize(network->numMotors, false);
-   fitness = 0.0f;
-#ifdef FFT_UNDULATION_EVAL
-   activations      = (double *)fftw_malloc(sizeof(double) * (undulationMovements * NUM_BODY_JOINTS));
-   bodyActivations  = (double *)fftw_malloc(sizeof(double) * NUM_BODY_JOINTS);
-   bodyDFT          = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * (NUM_BODY_JOINTS / 2 + 1));
-   bodyPlan         = fftw_plan_dft_r2c_1d(NUM_BODY_JOINTS, bodyActivations, bodyDFT, FFTW_MEASURE);
-   jointActivations = (double *)fftw_malloc(sizeof(double) * undulationMovements);
-   jointDFT         = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * (undulationMovements / 2 + 1));
-   jointPlan        = fftw_plan_dft_r2c_1d(undulationMovements, jointActivations, jointDFT, FFTW_MEASURE);
-#endif
+   network = NULL;
+   init(undulationMovements, homomorph, synapseWeightsParm, motorConnections, randomizer, tag);
 }
 
 
@@ -41,70 +29,46 @@ UndulationNetworkHomomorph::UndulationNetworkHomomorph(FilePointer *fp, int undu
    network = NULL;
    load(fp);
    this->motorConnections = motorConnections;
-#ifdef FFT_UNDULATION_EVAL
-   activations      = (double *)fftw_malloc(sizeof(double) * (undulationMovements * NUM_BODY_JOINTS));
-   bodyActivations  = (double *)fftw_malloc(sizeof(double) * NUM_BODY_JOINTS);
-   bodyDFT          = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * (NUM_BODY_JOINTS / 2 + 1));
-   bodyPlan         = fftw_plan_dft_r2c_1d(NUM_BODY_JOINTS, bodyActivations, bodyDFT, FFTW_MEASURE);
-   jointActivations = (double *)fftw_malloc(sizeof(double) * undulationMovements);
-   jointDFT         = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * (undulationMovements / 2 + 1));
-   jointPlan        = fftw_plan_dft_r2c_1d(undulationMovements, jointActivations, jointDFT, FFTW_MEASURE);
-#endif
 }
 
 
 UndulationNetworkHomomorph::~UndulationNetworkHomomorph()
 {
-#ifdef FFT_UNDULATION_EVAL
-   fftw_destroy_plan(bodyPlan);
-   fftw_free(bodyActivations);
-   fftw_free(bodyDFT);
-   fftw_destroy_plan(jointPlan);
-   fftw_free(jointActivations);
-   fftw_free(jointDFT);
-   fftw_free(activations);
-#endif
 }
 
 
 // Optimize synapses.
 void UndulationNetworkHomomorph::optimize(int synapseOptimizedPathLength)
 {
-   int   i, j, k, n, p, q;
-   float e;
+   int i, j;
 
-   // Initialize optimization.
    vector<vector<Synapse *> > synapses;
-   vector<vector<float> >     permutations;
-   initOptimize(synapses, permutations, synapseOptimizedPathLength);
+   vector<vector<float> >     candidates;
+   vector<float>              scores;
 
-   // Hill-climb synapse weight permutations.
-   n = 0;
-   e = error;
-   for (i = 1, j = (int)permutations.size(); i < j; i++)
+   // Initialize optimization.
+   Optimizer *optimizer = initOptimize(synapses, synapseOptimizedPathLength);
+   if (optimizer == NULL)
    {
-      for (k = 0; k < (int)synapses.size(); k++)
-      {
-         for (p = 0, q = (int)synapses[k].size(); p < q; p++)
-         {
-            synapses[k][p]->setWeight(permutations[i][k]);
-         }
-      }
-      evaluate();
-      if (error < e)
-      {
-         n = i;
-         e = error;
-      }
+      return;
    }
-   for (k = 0; k < (int)synapses.size(); k++)
+
+   // Hill-climb proposed synapse weights.
+   while (optimizer->propose(candidates))
    {
-      for (p = 0, q = (int)synapses[k].size(); p < q; p++)
+      j = (int)candidates.size();
+      scores.resize(j);
+      for (i = 0; i < j; i++)
       {
-         synapses[k][p]->setWeight(permutations[n][k]);
+         setPermutation(synapses, candidates[i]);
+         evaluate();
+         scores[i] = error;
       }
+      optimizer->update(scores);
    }
-   error = e;
+   setPermutation(synapses, optimizer->best);
+   error = optimizer->bestScore;
+   delete optimizer;
 }
 
 
@@ -271,6 +235,171 @@ const struct UndulationNetworkHomomorph::BodyJoint UndulationNetworkHomomorph::b
 
 #ifdef FFT_UNDULATION_EVAL
 
+// Shared Fourier transform plans.
+// The FFTW planner is not thread-safe, but executing a plan on new arrays is.
+static map<int, fftw_plan> fourierPlans;
+#ifdef THREADS
+static pthread_mutex_t     fourierPlanMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t       fourierScratchKey;
+static pthread_once_t      fourierScratchOnce = PTHREAD_ONCE_INIT;
+#else
+static void                *fourierScratch = NULL;
+#endif
+
+// Get real-to-complex plan for transform size.
+// Plans are made on fftw_malloc arrays, which have the alignment of all scratch arrays.
+fftw_plan UndulationNetworkHomomorph::getPlan(int size)
+{
+   fftw_plan    plan;
+   double       *in;
+   fftw_complex *out;
+
+   map<int, fftw_plan>::iterator itr;
+
+#ifdef THREADS
+   pthread_mutex_lock(&fourierPlanMutex);
+#endif
+   itr = fourierPlans.find(size);
+   if (itr != fourierPlans.end())
+   {
+      plan = itr->second;
+   }
+   else
+   {
+      in  = (double *)fftw_malloc(sizeof(double) * size);
+      out = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * (size / 2 + 1));
+      assert(in != NULL && out != NULL);
+      plan = fftw_plan_dft_r2c_1d(size, in, out, FFTW_MEASURE);
+      assert(plan != NULL);
+      fftw_free(in);
+      fftw_free(out);
+      fourierPlans[size] = plan;
+   }
+#ifdef THREADS
+   pthread_mutex_unlock(&fourierPlanMutex);
+#endif
+   return(plan);
+}
+
+
+#ifdef THREADS
+// Create thread-specific scratch key.
+void UndulationNetworkHomomorph::createScratchKey()
+{
+   if (pthread_key_create(&fourierScratchKey, UndulationNetworkHomomorph::freeScratch) != 0)
+   {
+      fprintf(stderr, "pthread_key_create failed, errno=%d\n", errno);
+      exit(1);
+   }
+}
+
+
+#endif
+
+// Get scratch arrays for calling thread.
+UndulationNetworkHomomorph::FourierScratch *UndulationNetworkHomomorph::getScratch(int undulationMovements)
+{
+   FourierScratch *scratch;
+
+#ifdef THREADS
+   pthread_once(&fourierScratchOnce, createScratchKey);
+   scratch = (FourierScratch *)pthread_getspecific(fourierScratchKey);
+#else
+   scratch = (FourierScratch *)fourierScratch;
+#endif
+   if ((scratch != NULL) && (scratch->undulationMovements != undulationMovements))
+   {
+      freeScratch(scratch);
+      scratch = NULL;
+   }
+   if (scratch == NULL)
+   {
+      scratch = new FourierScratch();
+      assert(scratch != NULL);
+      scratch->undulationMovements = undulationMovements;
+      scratch->activations         = (double *)fftw_malloc(sizeof(double) * (undulationMovements * NUM_BODY_JOINTS));
+      scratch->bodyActivations     = (double *)fftw_malloc(sizeof(double) * NUM_BODY_JOINTS);
+      scratch->bodyDFT             = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * (NUM_BODY_JOINTS / 2 + 1));
+      scratch->jointActivations    = (double *)fftw_malloc(sizeof(double) * undulationMovements);
+      scratch->jointDFT            = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * (undulationMovements / 2 + 1));
+      assert(scratch->activations != NULL && scratch->bodyActivations != NULL &&
+             scratch->bodyDFT != NULL && scratch->jointActivations != NULL &&
+             scratch->jointDFT != NULL);
+#ifdef THREADS
+      pthread_setspecific(fourierScratchKey, scratch);
+#else
+      fourierScratch = scratch;
+#endif
+   }
+   return(scratch);
+}
+
+
+// Free scratch arrays.
+void UndulationNetworkHomomorph::freeScratch(void *scratchArg)
+{
+   FourierScratch *scratch = (FourierScratch *)scratchArg;
+
+   fftw_free(scratch->activations);
+   fftw_free(scratch->bodyActivations);
+   fftw_free(scratch->bodyDFT);
+   fftw_free(scratch->jointActivations);
+   fftw_free(scratch->jointDFT);
+   delete scratch;
+}
+
+
+// Load planner wisdom.
+bool UndulationNetworkHomomorph::loadWisdom(char *filename)
+{
+   int result;
+
+#ifdef THREADS
+   pthread_mutex_lock(&fourierPlanMutex);
+#endif
+   result = fftw_import_wisdom_from_filename(filename);
+#ifdef THREADS
+   pthread_mutex_unlock(&fourierPlanMutex);
+#endif
+   return(result != 0);
+}
+
+
+// Save planner wisdom.
+bool UndulationNetworkHomomorph::saveWisdom(char *filename)
+{
+   int result;
+
+#ifdef THREADS
+   pthread_mutex_lock(&fourierPlanMutex);
+#endif
+   result = fftw_export_wisdom_to_filename(filename);
+#ifdef THREADS
+   pthread_mutex_unlock(&fourierPlanMutex);
+#endif
+   return(result != 0);
+}
+
+
+// Destroy shared plans.
+void UndulationNetworkHomomorph::destroyPlans()
+{
+   map<int, fftw_plan>::iterator itr;
+
+#ifdef THREADS
+   pthread_mutex_lock(&fourierPlanMutex);
+#endif
+   for (itr = fourierPlans.begin(); itr != fourierPlans.end(); itr++)
+   {
+      fftw_destroy_plan(itr->second);
+   }
+   fourierPlans.clear();
+#ifdef THREADS
+   pthread_mutex_unlock(&fourierPlanMutex);
+#endif
+}
+
+
 /*
  * Evaluate undulation behavior fitness.
  *
@@ -288,22 +417,31 @@ const struct UndulationNetworkHomomorph::BodyJoint UndulationNetworkHomomorph::b
  * touch sensor neurons are stimulated. A less dispersed spectrum represents a more distinct
  * undulation which is a fitter undulation behavior.
  */
-void UndulationNetworkHomomorph::evaluate()
+void UndulationNetworkHomomorph::evaluateUndulation()
 {
    int i, j, k, m, n;
 
-   vector<vector<float> > sensorSequence;
-   Behavior               *behavior;
-   vector<double>         values;
-   double                 sum, mean, max, bodyMax, jointMax, bodySum, jointSum;
-   double                 r, im, mag;
+   BehaviorSequence sensorSequence;
+   Behavior         *behavior;
+   vector<double>   values;
+   double           sum, mean, max, bodyMax, jointMax, bodySum, jointSum;
+   double           r, im, mag;
+
+   // Shared plans and per-thread scratch arrays.
+   FourierScratch *scratch         = getScratch(undulationMovements);
+   double         *activations     = scratch->activations;
+   double         *bodyActivations = scratch->bodyActivations;
+   double         *jointActivations = scratch->jointActivations;
+   fftw_complex   *bodyDFT         = scratch->bodyDFT;
+   fftw_complex   *jointDFT        = scratch->jointDFT;
+   fftw_plan      bodyPlan         = getPlan(NUM_BODY_JOINTS);
+   fftw_plan      jointPlan        = getPlan(undulationMovements);
 
    // Stimulate the touch sensors.
-   sensorSequence.resize(undulationMovements);
    n = network->numSensors;
+   sensorSequence.resize(undulationMovements, n);
    for (i = 0; i < undulationMovements; i++)
    {
-      sensorSequence[i].resize(n, 0.0f);
       sensorSequence[i][sensorIndices[0].index] = 1.0f;
       sensorSequence[i][sensorIndices[1].index] = 1.0f;
    }
@@ -341,7 +479,7 @@ void UndulationNetworkHomomorph::evaluate()
       {
          bodyActivations[j] = activations[j + (NUM_BODY_JOINTS * i)];
       }
-      fftw_execute(bodyPlan);
+      fftw_execute_dft_r2c(bodyPlan, bodyActivations, bodyDFT);
       values.clear();
       max = 0.0;
       for (j = 0; j < k; j++)
@@ -378,7 +516,7 @@ void UndulationNetworkHomomorph::evaluate()
       {
          jointActivations[j] = activations[i + (NUM_BODY_JOINTS * j)];
       }
-      fftw_execute(jointPlan);
+      fftw_execute_dft_r2c(jointPlan, jointActivations, jointDFT);
       values.clear();
       max = 0.0;
       for (j = 0; j < k; j++)
@@ -450,7 +588,7 @@ void UndulationNetworkHomomorph::evaluate()
       {
          bodyActivations[j] = activations[j + (NUM_BODY_JOINTS * i)];
       }
-      fftw_execute(bodyPlan);
+      fftw_execute_dft_r2c(bodyPlan, bodyActivations, bodyDFT);
       values.clear();
       for (j = 0; j < k; j++)
       {
@@ -476,7 +614,7 @@ void UndulationNetworkHomomorph::evaluate()
       {
          jointActivations[j] = activations[i + (NUM_BODY_JOINTS * j)];
       }
-      fftw_execute(jointPlan);
+      fftw_execute_dft_r2c(jointPlan, jointActivations, jointDFT);
       values.clear();
       for (j = 0; j < k; j++)
       {
@@ -501,24 +639,41 @@ void UndulationNetworkHomomorph::evaluate()
 
 #else
 
+// Fourier transform planner wisdom: no plans without Fourier transform evaluation.
+bool UndulationNetworkHomomorph::loadWisdom(char *)
+{
+   return(true);
+}
+
+
+bool UndulationNetworkHomomorph::saveWisdom(char *)
+{
+   return(true);
+}
+
+
+void UndulationNetworkHomomorph::destroyPlans()
+{
+}
+
+
 // Evaluate undulation behavior fitness.
 // Fitness is a function of the number and magnitude of opposing muscle forces
 // when the light touch sensors are active.
-void UndulationNetworkHomomorph::evaluate()
+void UndulationNetworkHomomorph::evaluateUndulation()
 {
    int i, j, k, m, n;
 
-   vector<vector<float> > sensorSequence;
-   Behavior               *behavior;
+   BehaviorSequence sensorSequence;
+   Behavior         *behavior;
    float highForces[NUM_BODY_JOINTS];
    float forces[NUM_BODY_JOINTS];
 
    // Stimulate the touch sensors.
-   sensorSequence.resize(undulationMovements);
    n = network->numSensors;
+   sensorSequence.resize(undulationMovements, n);
    for (i = 0; i < undulationMovements; i++)
    {
-      sensorSequence[i].resize(n, 0.0f);
       sensorSequence[i][sensorIndices[0].index] = 1.0f;
       sensorSequence[i][sensorIndices[1].index] = 1.0f;
    }
@@ -657,16 +812,41 @@ void UndulationNetworkHomomorph::evaluate()
 
 #endif
 
+// Evaluate undulation behavior fitness, consulting fitness cache.
+void UndulationNetworkHomomorph::evaluate()
+{
+   FitnessCache::Key   cacheKey('U');
+   FitnessCache::Value cacheValue;
+
+   if (fitnessCache == NULL)
+   {
+      evaluateUndulation();
+      return;
+   }
+   cacheKey.add(network);
+   cacheKey.add((unsigned long long)undulationMovements);
+   if (fitnessCache->lookup(cacheKey, cacheValue))
+   {
+      fitness = cacheValue.fitness;
+      return;
+   }
+   evaluateUndulation();
+   cacheValue.error   = 0.0f;
+   cacheValue.fitness = fitness;
+   cacheValue.behaves = false;
+   fitnessCache->insert(cacheKey, cacheValue);
+}
+
 
 // Clone.
-UndulationNetworkHomomorph *UndulationNetworkHomomorph::clone(int tag)
+UndulationNetworkHomomorph *UndulationNetworkHomomorph::clone(int tag, Random *randomizer)
 {
    int i, n;
    UndulationNetworkHomomorph *undulationNetworkMorph;
 
    undulationNetworkMorph = new UndulationNetworkHomomorph(
       undulationMovements, network, synapseWeightsParm,
-      motorConnections, randomizer, tag);
+      motorConnections, randomizer != NULL ? randomizer : this->randomizer, tag);
    assert(undulationNetworkMorph != NULL);
    undulationNetworkMorph->fitness = fitness;
    for (i = 0, n = (int)motorErrors.size(); i < n; i++)
@@ -677,6 +857,28 @@ UndulationNetworkHomomorph *UndulationNetworkHomomorph::clone(int tag)
 }
 
 
+// Reinitialize in place as constructed from homomorph.
+void UndulationNetworkHomomorph::init(int undulationMovements, Network *homomorph,
+                                      MutableParm& synapseWeightsParm,
+                                      vector<vector<pair<int, int> > > *motorConnections,
+                                      Random *randomizer, int tag)
+{
+   this->undulationMovements = undulationMovements;
+   NetworkHomomorph::init(homomorph, synapseWeightsParm, motorConnections, randomizer, tag);
+   fitness = 0.0f;
+}
+
+
+// Clone member in place.
+void UndulationNetworkHomomorph::cloneFrom(UndulationNetworkHomomorph *member, int tag, Random *randomizer)
+{
+   init(member->undulationMovements, member->network, member->synapseWeightsParm,
+        member->motorConnections, randomizer != NULL ? randomizer : member->randomizer, tag);
+   fitness     = member->fitness;
+   motorErrors = member->motorErrors;
+}
+
+
 // Load.
 void UndulationNetworkHomomorph::load(FilePointer *fp)
 {
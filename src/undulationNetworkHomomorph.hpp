@@ -35,8 +35,17 @@ public:
    int undulationMovements;
    void evaluate();
 
-   // Clone.
-   UndulationNetworkHomomorph *clone(int tag = (-1));
+   // Clone, optionally drawing from given randomizer.
+   UndulationNetworkHomomorph *clone(int tag = (-1), Random *randomizer = NULL);
+
+   // Reinitialize in place as constructed from homomorph, reusing network storage.
+   void init(int undulationMovements, Network *homomorph,
+             MutableParm& synapseWeightsParm,
+             vector<vector<pair<int, int> > > *motorConnections,
+             Random *randomizer, int tag = (-1));
+
+   // Clone member in place, optionally drawing from given randomizer.
+   void cloneFrom(UndulationNetworkHomomorph *member, int tag = (-1), Random *randomizer = NULL);
 
    // Load.
    void load(FilePointer *fp);
@@ -71,11 +80,38 @@ public:
    static const int              NUM_BODY_JOINTS = 12;
    static const struct BodyJoint bodyJoints[NUM_BODY_JOINTS];
 
+   // Fourier transform planner wisdom.
+   // Plans are shared by all members, so wisdom is loaded before members are created.
+   static bool loadWisdom(char *filename);
+   static bool saveWisdom(char *filename);
+
+   // Destroy shared Fourier transform plans.
+   static void destroyPlans();
+
+private:
+
 #ifdef FFT_UNDULATION_EVAL
-   // Fourier transform.
-   double       *activations, *bodyActivations, *jointActivations;
-   fftw_complex *bodyDFT, *jointDFT;
-   fftw_plan    bodyPlan, jointPlan;
+   // Fourier transform plans keyed by transform size.
+   // Plans are executed on per-thread scratch arrays.
+   static fftw_plan getPlan(int size);
+
+   // Per-thread Fourier transform scratch arrays.
+   class FourierScratch
+   {
+   public:
+      int          undulationMovements;
+      double       *activations, *bodyActivations, *jointActivations;
+      fftw_complex *bodyDFT, *jointDFT;
+   };
+   static FourierScratch *getScratch(int undulationMovements);
+   static void freeScratch(void *scratch);
+#ifdef THREADS
+   static void createScratchKey();
+#endif
 #endif
+
+
+   // Evaluate fitness by simulation.
+   void evaluateUndulation();
 };
 #endif